@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Soak tests levels by running many headless bot playthroughs at once.
+
+Starts --instances copies of the packaged game side by side with -CobbleHeadless -CobbleBot -nullrhi -nosound, each
+playing one of --maps with its own -CobbleBotSeed, and keeps that many running until --runs playthroughs have finished.
+Every instance writes its BotReport.json and log to its own folder under --out. The CPU time and peak resident memory of
+each instance come from the OS when it exits, so they include everything the process did, loading included.
+
+Prints pass and fail counts per map with the reasons runs failed, and the per instance footprint, and writes
+summary.json to --out. Exits with 1 if any run failed.
+
+    python3 bot_farm.py Saved/StagedBuilds/LinuxNoEditor --maps Lvl_Construciton_Intro --runs 32 --instances 8
+"""
+import argparse
+import collections
+import json
+import os
+import signal
+import statistics
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "StartupIO"))
+from capture_open_order import BOOT_MAP, find_game_binary  # noqa: E402
+
+METRICS = ["GameSeconds", "WallSeconds", "AverageGameThreadMs", "MaxGameThreadMs", "Hitches", "PeakUsedPhysicalBytes"]
+
+
+def map_path(name):
+    return name if name.startswith("/") else "/Game/Levels/" + name
+
+
+def start_run(binary, args, run, out_dir):
+    level = args.maps[run % len(args.maps)]
+    run_dir = os.path.join(out_dir, "run_%03d" % run)
+    os.makedirs(run_dir, exist_ok=True)
+    report = os.path.join(run_dir, "BotReport.json")
+    if os.path.exists(report):
+        os.remove(report)
+    command = [binary, map_path(level), "-CobbleHeadless", "-CobbleBot", "-CobbleBotSeed=%d" % (args.seed + run),
+               "-CobbleBotReport=" + report,
+               "-abslog=" + os.path.join(run_dir, "Cobble.log"),
+               "-nullrhi", "-nosound", "-unattended", "-nosplash", "-NoCobbleTelemetry"]
+    if args.max_fps > 0:
+        command.append("-ExecCmds=t.MaxFPS %d" % args.max_fps)
+    process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return process.pid, {"Run": run, "Map": level, "Dir": run_dir, "Started": time.time(), "Process": process,
+                         "TimedOut": False}
+
+
+def finish_run(entry, status, usage):
+    result = {"Run": entry["Run"], "Map": entry["Map"], "ExitCode": os.waitstatus_to_exitcode(status),
+              "CpuSeconds": usage.ru_utime + usage.ru_stime, "MaxResidentBytes": usage.ru_maxrss * 1024,
+              "ProcessSeconds": time.time() - entry["Started"]}
+    report = os.path.join(entry["Dir"], "BotReport.json")
+    if entry["TimedOut"]:
+        result["Passed"] = False
+        result["Reason"] = "Timed out"
+    elif os.path.isfile(report):
+        with open(report) as f:
+            result.update(json.load(f))
+    else:
+        result["Passed"] = False
+        result["Reason"] = "No report, the game exited with %d" % result["ExitCode"]
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("staged_dir")
+    parser.add_argument("--platform", default="Linux")
+    parser.add_argument("--maps", nargs="+", default=[BOOT_MAP], help="map names or /Game paths")
+    parser.add_argument("--runs", type=int, default=16)
+    parser.add_argument("--instances", type=int, default=os.cpu_count())
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--max-fps", type=int, default=30, help="frame rate cap per instance, 0 for none")
+    parser.add_argument("--timeout", type=float, default=900, help="seconds before an instance is killed")
+    parser.add_argument("--out", default="Saved/Playtests/Farm")
+    args = parser.parse_args()
+
+    binary = find_game_binary(args.staged_dir, args.platform)
+    os.makedirs(args.out, exist_ok=True)
+    running = {}
+    results = []
+    next_run = 0
+    start = time.time()
+    while next_run < args.runs or running:
+        while next_run < args.runs and len(running) < args.instances:
+            pid, entry = start_run(binary, args, next_run, args.out)
+            running[pid] = entry
+            next_run += 1
+        # Killed once by pid, Popen.kill would poll and reap the instance before wait4 could see it
+        for pid, entry in running.items():
+            if not entry["TimedOut"] and time.time() - entry["Started"] > args.timeout:
+                os.kill(pid, signal.SIGKILL)
+                entry["TimedOut"] = True
+        # wait4 rather than Popen.wait, it hands back the instance's own CPU time and peak memory
+        pid, status, usage = os.wait4(-1, os.WNOHANG)
+        if pid not in running:
+            time.sleep(0.5)
+            continue
+        entry = running.pop(pid)
+        entry["Process"].returncode = os.waitstatus_to_exitcode(status)
+        result = finish_run(entry, status, usage)
+        results.append(result)
+        print("Run %d %s: %s in %.0fs (%s)" % (result["Run"], result["Map"], "passed" if result["Passed"] else "FAILED",
+                                               result["ProcessSeconds"], result["Reason"]))
+
+    maps = {}
+    for level in args.maps:
+        runs = [r for r in results if r["Map"] == level]
+        passed = [r for r in runs if r["Passed"]]
+        maps[level] = {"Runs": len(runs), "Passed": len(passed),
+                       "Failures": collections.Counter(r["Reason"] for r in runs if not r["Passed"]),
+                       "Median": {m: statistics.median(r[m] for r in passed) for m in METRICS} if passed else {}}
+    footprint = {"CpuSeconds": statistics.median(r["CpuSeconds"] for r in results),
+                 "MaxResidentBytes": max(r["MaxResidentBytes"] for r in results)}
+    summary = {"Instances": args.instances, "WallSeconds": time.time() - start, "Maps": maps, "Footprint": footprint,
+               "Runs": sorted(results, key=lambda r: r["Run"])}
+
+    print("%d runs on %d instances in %.0fs" % (len(results), args.instances, summary["WallSeconds"]))
+    for level, entry in maps.items():
+        print("  %-32s %d of %d passed" % (level, entry["Passed"], entry["Runs"]))
+        for reason, count in entry["Failures"].most_common():
+            print("    %3d x %s" % (count, reason))
+    print("  Per instance: median %.1f CPU seconds, at most %.0f MB resident"
+          % (footprint["CpuSeconds"], footprint["MaxResidentBytes"] / 1e6))
+    with open(os.path.join(args.out, "summary.json"), "w") as f:
+        json.dump(summary, f, indent=2)
+    if any(not r["Passed"] for r in results):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Measures time to first frame and bytes read when booting into Lvl_Construciton_Intro.
+
+Runs the packaged game --runs times with -CobbleBootBench, which writes Saved/Profiling/BootReport.json and quits once
+the level has drawn, and prints the median of each number. With --cold the page cache is dropped before every run so the
+reads come off the disk (needs root, Linux only).
+
+    python3 boot_benchmark.py Saved/StagedBuilds/LinuxNoEditor --runs 5 --cold [--json results.json]
+"""
+import argparse
+import glob
+import json
+import os
+import statistics
+import subprocess
+import sys
+
+from capture_open_order import BOOT_MAP, find_game_binary
+
+METRICS = ["SecondsToFirstFrame", "SecondsToMapLoaded", "SecondsToFirstMapFrame", "DiskBytesRead", "BytesRead",
+           "PeakUsedPhysicalBytes"]
+
+
+def drop_page_cache():
+    subprocess.run(["sync"], check=True)
+    try:
+        with open("/proc/sys/vm/drop_caches", "w") as f:
+            f.write("3\n")
+    except PermissionError:
+        sys.exit("--cold needs root to drop the page cache")
+
+
+def find_report(staged_dir):
+    reports = glob.glob(os.path.join(staged_dir, "**", "Saved", "Profiling", "BootReport.json"), recursive=True)
+    reports += glob.glob(os.path.expanduser("~/.config/Epic/Cobble/Saved/Profiling/BootReport.json"))
+    return max(reports, key=os.path.getmtime) if reports else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("staged_dir")
+    parser.add_argument("--platform", default="Linux")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--cold", action="store_true")
+    parser.add_argument("--json", help="also write every run and the medians here")
+    args = parser.parse_args()
+
+    binary = find_game_binary(args.staged_dir, args.platform)
+    runs = []
+    for run in range(args.runs):
+        if args.cold:
+            drop_page_cache()
+        previous = find_report(args.staged_dir)
+        previous_time = os.path.getmtime(previous) if previous else 0
+        subprocess.run([binary, BOOT_MAP, "-CobbleBootBench", "-unattended", "-nosplash"], check=True)
+        report = find_report(args.staged_dir)
+        if report is None or os.path.getmtime(report) <= previous_time:
+            sys.exit("Run %d did not write a boot report" % (run + 1))
+        with open(report) as f:
+            runs.append(json.load(f))
+        print("Run %d: first map frame after %.2fs, %.1f MB read from disk"
+              % (run + 1, runs[-1]["SecondsToFirstMapFrame"], runs[-1]["DiskBytesRead"] / 1e6))
+
+    medians = {metric: statistics.median(r[metric] for r in runs) for metric in METRICS}
+    print("Median over %d %s runs:" % (len(runs), "cold" if args.cold else "warm"))
+    for metric in METRICS:
+        print("  %-24s %s" % (metric, medians[metric]))
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"Cold": args.cold, "Runs": runs, "Median": medians}, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
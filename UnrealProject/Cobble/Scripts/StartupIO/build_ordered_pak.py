@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Builds a pak with files in boot open order and compression chosen per file.
+
+Every staged file is compressed with zlib once to measure its ratio and decompression speed. Files the boot opens
+(listed in GameOpenOrder.log) are compressed only when reading the smaller file plus decompressing it is no slower than
+reading it raw at --disk-mbps, within --slack. Other files are compressed whenever that saves install size. Files that
+don't shrink below --max-ratio (Wwise media, movies, already compressed data) are always stored.
+
+Boot files go first in open order, the rest follow sorted by path. A CSV of every decision is written next to the pak.
+
+    python3 build_ordered_pak.py --staged Saved/StagedBuilds/LinuxNoEditor \\
+        --unrealpak ~/UnrealEngine/Engine/Binaries/Linux/UnrealPak --out Cobble-Linux.pak
+"""
+import argparse
+import csv
+import os
+import re
+import subprocess
+import time
+import zlib
+
+PROJECT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+SAMPLE_BYTES = 4 * 1024 * 1024  # Large files are judged on their first few megabytes
+MIN_COMPRESS_BYTES = 4096  # Below a compression block the saving is lost to padding
+
+
+def read_open_order(path):
+    order = {}
+    if not os.path.isfile(path):
+        return order
+    with open(path) as f:
+        for index, line in enumerate(f):
+            match = re.match(r'\s*"([^"]+)"\s*(\d+)?', line)
+            if match:
+                order.setdefault(os.path.normpath(match.group(1)).lower(), int(match.group(2) or index))
+    return order
+
+
+def staged_files(staged_dir):
+    for root, _, files in os.walk(staged_dir):
+        relative_root = os.path.relpath(root, staged_dir)
+        if relative_root.split(os.sep)[0] == "Manifest_NonUFSFiles" or os.sep + "Binaries" in os.sep + relative_root:
+            continue
+        if relative_root == ".":
+            continue  # Launch scripts and manifests, not files the game reads through the pak
+        for name in files:
+            yield os.path.join(root, name), os.path.join("..", "..", "..", relative_root, name).replace("\\", "/")
+
+
+def measure(path):
+    with open(path, "rb") as f:
+        data = f.read(SAMPLE_BYTES)
+    if len(data) < MIN_COMPRESS_BYTES:
+        return 1.0, float("inf")
+    compressed = zlib.compress(data, 6)
+    start = time.perf_counter()
+    zlib.decompress(compressed)
+    seconds = max(time.perf_counter() - start, 1e-9)
+    return len(compressed) / len(data), len(data) / seconds / 1e6
+
+
+def should_compress(ratio, decompress_mbps, is_boot_file, args):
+    if ratio > args.max_ratio:
+        return False
+    if not is_boot_file:
+        return True
+    # Per byte of the original file: read raw, versus read compressed and decompress
+    stored_cost = 1 / args.disk_mbps
+    compressed_cost = ratio / args.disk_mbps + 1 / decompress_mbps
+    return compressed_cost <= stored_cost * (1 + args.slack)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--staged", required=True, help="staged build directory, e.g. Saved/StagedBuilds/LinuxNoEditor")
+    parser.add_argument("--unrealpak", required=True)
+    parser.add_argument("--out", required=True)
+    parser.add_argument("--platform", default="Linux")
+    parser.add_argument("--order", help="defaults to Build/<Platform>/FileOpenOrder/GameOpenOrder.log")
+    parser.add_argument("--disk-mbps", type=float, default=150, help="read speed of the slowest disk we ship on")
+    parser.add_argument("--max-ratio", type=float, default=0.9)
+    parser.add_argument("--slack", type=float, default=0.1, help="how much slower a boot file may load to save space")
+    args = parser.parse_args()
+
+    order_path = args.order or os.path.join(PROJECT_DIR, "Build", args.platform, "FileOpenOrder", "GameOpenOrder.log")
+    open_order = read_open_order(order_path)
+    if not open_order:
+        print("No open order at %s, files will be in path order" % order_path)
+
+    entries = []
+    for source, mount_path in staged_files(args.staged):
+        boot_index = open_order.get(os.path.normpath(mount_path).lower())
+        ratio, decompress_mbps = measure(source)
+        compress = should_compress(ratio, decompress_mbps, boot_index is not None, args)
+        entries.append((boot_index, mount_path, source, os.path.getsize(source), ratio, decompress_mbps, compress))
+    entries.sort(key=lambda e: (e[0] is None, e[0] if e[0] is not None else 0, e[1]))
+
+    out = os.path.abspath(args.out)
+    response = out + ".response.txt"
+    with open(response, "w") as f:
+        for _, mount_path, source, _, _, _, compress in entries:
+            f.write('"%s" "%s"%s\n' % (source, mount_path, " -compress" if compress else ""))
+    with open(out + ".compression.csv", "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["MountPath", "BootOrder", "Bytes", "ZlibRatio", "DecompressMBps", "Compressed"])
+        for boot_index, mount_path, _, size, ratio, decompress_mbps, compress in entries:
+            writer.writerow([mount_path, "" if boot_index is None else boot_index, size, "%.3f" % ratio,
+                             "%.0f" % decompress_mbps, int(compress)])
+
+    command = [args.unrealpak, out, "-create=" + response, "-compressionformats=Zlib", "-platform=" + args.platform,
+               "-multiprocess"]
+    if open_order:
+        command.append("-order=" + os.path.abspath(order_path))
+    print(" ".join(command))
+    subprocess.run(command, check=True)
+
+    raw = sum(e[3] for e in entries)
+    compressed = sum(1 for e in entries if e[6])
+    boot = sum(1 for e in entries if e[0] is not None)
+    print("%d files (%d in boot order), %d compressed, %.1f MB staged, pak is %.1f MB"
+          % (len(entries), boot, compressed, raw / 1e6, os.path.getsize(out) / 1e6))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""Records the order files are opened while a staged build boots into Lvl_Construciton_Intro.
+
+Runs the staged (not pak'd) Development build with -fileopenlog and -CobbleBootBench so it quits by itself once the
+level has drawn, then copies GameOpenOrder.log to Build/<Platform>/FileOpenOrder/, where BuildCookRun and
+build_ordered_pak.py pick it up.
+
+    python3 capture_open_order.py Saved/StagedBuilds/LinuxNoEditor [--platform Linux] [--frames 120]
+"""
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+PROJECT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+BOOT_MAP = "/Game/Levels/Lvl_Construciton_Intro"
+
+
+def find_game_binary(staged_dir, platform):
+    binaries = os.path.join(staged_dir, "Cobble", "Binaries", platform)
+    for name in ("Cobble", "Cobble.exe"):
+        path = os.path.join(binaries, name)
+        if os.path.isfile(path):
+            return path
+    sys.exit("No Cobble binary in " + binaries)
+
+
+def find_newest_log(staged_dir, since):
+    newest = None
+    for root, _, files in os.walk(staged_dir):
+        if "GameOpenOrder.log" in files:
+            path = os.path.join(root, "GameOpenOrder.log")
+            if os.path.getmtime(path) >= since and (newest is None or os.path.getmtime(path) > os.path.getmtime(newest)):
+                newest = path
+    return newest
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("staged_dir")
+    parser.add_argument("--platform", default="Linux")
+    parser.add_argument("--frames", type=int, default=120, help="frames to keep running after the map loads")
+    args = parser.parse_args()
+
+    started = time.time()
+    command = [find_game_binary(args.staged_dir, args.platform), BOOT_MAP, "-fileopenlog", "-CobbleBootBench",
+               "-BootBenchFrames=%d" % args.frames, "-unattended", "-nosplash"]
+    print(" ".join(command))
+    subprocess.run(command, check=True)
+
+    log = find_newest_log(args.staged_dir, started)
+    if log is None:
+        sys.exit("The game did not write GameOpenOrder.log, is this a Development build?")
+    destination = os.path.join(PROJECT_DIR, "Build", args.platform, "FileOpenOrder", "GameOpenOrder.log")
+    os.makedirs(os.path.dirname(destination), exist_ok=True)
+    shutil.copyfile(log, destination)
+    with open(destination) as f:
+        print("Captured %d files in open order to %s" % (sum(1 for _ in f), destination))
+
+
+if __name__ == "__main__":
+    main()
@@ -8,9 +8,9 @@ public class Cobble : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 	
-		PublicDependencyModuleNames.AddRange(new string[] { "CableComponent", "Core", "CoreUObject", "Engine", "InputCore" });
+		PublicDependencyModuleNames.AddRange(new string[] { "CableComponent", "Core", "CoreUObject", "Engine", "InputCore", "Paper2D" });
 
-        PrivateDependencyModuleNames.AddRange(new string[] { "CableComponent" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "CableComponent", "AssetRegistry", "Json", "AkAudio", "Sockets", "Networking" });
 
         // Uncomment if you are using Slate UI
         // PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
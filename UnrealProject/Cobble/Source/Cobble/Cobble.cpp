@@ -1,6 +1,30 @@
 // Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "Cobble.h"
+#include "CobbleMemory.h"
+#include "CobbleHitchDetector.h"
+#include "CobbleBootBenchmark.h"
+#include "CobbleTelemetry.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Cobble, "Cobble" );
+class FCobbleGameModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FCobbleMemory::Startup();
+		FCobbleHitchDetector::Startup();
+		FCobbleBootBenchmark::Startup();
+		FCobbleTelemetry::Startup();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FCobbleTelemetry::Shutdown();
+		FCobbleBootBenchmark::Shutdown();
+		FCobbleHitchDetector::Shutdown();
+		FCobbleMemory::Shutdown();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FCobbleGameModule, Cobble, "Cobble" );
@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleAudioStreaming.h"
+#include "CobbleAudioZone.h"
+#include "CobbleSettings.h"
+#include "CobbleTelemetry.h"
+#include "CobbleSideScroll.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	// Zones only change state as fast as the players walk, so there is no need to look every frame
+	const float UpdateInterval = 0.25f;
+
+	FAutoConsoleCommandWithWorldAndArgs AudioReportCommand(
+		TEXT("Cobble.AudioReport"),
+		TEXT("Prints the audio zones, resident audio memory and audio load stalls."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UCobbleAudioStreaming* AudioStreaming = World != nullptr ? UGameInstance::GetSubsystem<UCobbleAudioStreaming>(World->GetGameInstance()) : nullptr;
+			if (AudioStreaming != nullptr)
+				AudioStreaming->PrintReport();
+		}));
+}
+
+void UCobbleAudioStreaming::Deinitialize()
+{
+	for (FZoneState& State : Zones)
+	{
+		UnloadZone(State);
+	}
+	Zones.Reset();
+	Super::Deinitialize();
+}
+
+bool UCobbleAudioStreaming::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && Zones.Num() > 0;
+}
+
+TStatId UCobbleAudioStreaming::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCobbleAudioStreaming, STATGROUP_Tickables);
+}
+
+void UCobbleAudioStreaming::Tick(float DeltaTime)
+{
+	COBBLE_TELEMETRY_SCOPE(Streaming);
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0)
+	{
+		TimeUntilUpdate = UpdateInterval;
+		UpdateZones();
+	}
+}
+
+void UCobbleAudioStreaming::RegisterZone(ACobbleAudioZone* Zone)
+{
+	if (Zone != nullptr && FindZoneState(Zone) == nullptr)
+	{
+		FZoneState& State = Zones.AddDefaulted_GetRef();
+		State.Zone = Zone;
+		// Zones saved before the estimate was baked work it out now
+		State.EstimatedBytes = Zone->EstimatedBytes > 0 ? Zone->EstimatedBytes : Zone->EstimateAudioBytes();
+		// Decide straight away so a zone the player spawns in starts loading this frame
+		TimeUntilUpdate = 0;
+	}
+}
+
+void UCobbleAudioStreaming::UnregisterZone(ACobbleAudioZone* Zone)
+{
+	for (int32 i = Zones.Num() - 1; i >= 0; i--)
+	{
+		if (Zones[i].Zone == Zone || !Zones[i].Zone.IsValid())
+		{
+			UnloadZone(Zones[i]);
+			Zones.RemoveAtSwap(i);
+		}
+	}
+}
+
+void UCobbleAudioStreaming::UpdateZones()
+{
+	TArray<AActor*> Viewers;
+	for (ULocalPlayer* LocalPlayer : GetGameInstance()->GetLocalPlayers())
+	{
+		APlayerController* Controller = LocalPlayer != nullptr ? LocalPlayer->PlayerController : nullptr;
+		if (Controller != nullptr && Controller->GetViewTarget() != nullptr)
+			Viewers.Add(Controller->GetViewTarget());
+	}
+	if (Viewers.Num() == 0)
+		return;
+	UpdateZoneDistances(Viewers);
+
+	for (FZoneState& State : Zones)
+	{
+		if (State.bReleasable && IsResident(State))
+			UnloadZone(State);
+	}
+
+	// Nearest first, so with a tight budget the zone the player reaches next wins
+	TArray<FZoneState*> ToLoad;
+	for (FZoneState& State : Zones)
+	{
+		if (State.bWanted && !IsResident(State))
+			ToLoad.Add(&State);
+	}
+	ToLoad.Sort([](const FZoneState& A, const FZoneState& B) { return A.NearestStart < B.NearestStart; });
+
+	const int64 Budget = (int64)GetDefault<UCobbleSettings>()->AudioResidentBudgetKB * 1024;
+	for (FZoneState* State : ToLoad)
+	{
+		if (Budget > 0)
+		{
+			// Evict resident zones nobody is standing in, farthest behind first, until the new zone fits
+			while (GetResidentBytes() + GetBudgetBytes(*State) > Budget)
+			{
+				FZoneState* Evict = nullptr;
+				for (FZoneState& Other : Zones)
+				{
+					if (IsResident(Other) && !Other.bOccupied && Other.NearestStart < State->NearestStart
+						&& (Evict == nullptr || Other.NearestStart < Evict->NearestStart))
+						Evict = &Other;
+				}
+				if (Evict == nullptr)
+					break;
+				UnloadZone(*Evict);
+			}
+			if (GetResidentBytes() + GetBudgetBytes(*State) > Budget && !State->bOccupied)
+			{
+				NumBudgetWaits++;
+				continue;
+			}
+		}
+		LoadZone(*State);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (FZoneState& State : Zones)
+	{
+		const bool bLoaded = State.Handle.IsValid() && State.Handle->HasLoadCompleted();
+		if (State.bOccupied && !bLoaded && State.StallStartTime == 0)
+			State.StallStartTime = Now;
+	}
+}
+
+void UCobbleAudioStreaming::UpdateZoneDistances(const TArray<AActor*>& Viewers)
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	for (FZoneState& State : Zones)
+	{
+		ACobbleAudioZone* Zone = State.Zone.Get();
+		State.bWanted = false;
+		State.bOccupied = false;
+		State.bReleasable = Zone != nullptr;
+		State.NearestStart = MAX_flt;
+		if (Zone == nullptr)
+			continue;
+		for (const AActor* Viewer : Viewers)
+		{
+			const FVector Axis = FCobbleSideScroll::GetScrollAxis(Viewer);
+			const float Centre = FCobbleSideScroll::GetDistanceAlongAxis(Axis, Viewer->GetActorLocation(), Zone->GetActorLocation());
+			const float HalfLength = Zone->GetHalfLengthAlongAxis(Axis);
+			const float Start = Centre - HalfLength;
+			const float End = Centre + HalfLength;
+			State.bWanted |= Start <= Settings->AudioLoadAhead && End >= -Settings->AudioKeepBehind;
+			State.bOccupied |= Start <= 0 && End >= 0;
+			// The gap between keeping and releasing stops zones on the edge from loading and unloading over and over
+			State.bReleasable &= End < -(Settings->AudioKeepBehind + Settings->AudioUnloadBehind) || Start > Settings->AudioLoadAhead + Settings->AudioUnloadBehind;
+			if (FMath::Abs(Start) < FMath::Abs(State.NearestStart))
+				State.NearestStart = Start;
+		}
+	}
+}
+
+void UCobbleAudioStreaming::LoadZone(FZoneState& State)
+{
+	ACobbleAudioZone* Zone = State.Zone.Get();
+	if (Zone == nullptr)
+		return;
+	TArray<FSoftObjectPath> Paths;
+	for (const TSoftObjectPtr<UObject>& Asset : Zone->AudioAssets)
+	{
+		if (!Asset.IsNull())
+			Paths.Add(Asset.ToSoftObjectPath());
+	}
+	if (Paths.Num() == 0)
+		return;
+	const TAsyncLoadPriority Priority = State.bOccupied ? FStreamableManager::AsyncLoadHighPriority : FStreamableManager::DefaultAsyncLoadPriority;
+	State.Handle = Streamable.RequestAsyncLoad(Paths, FStreamableDelegate::CreateUObject(this, &UCobbleAudioStreaming::OnZoneLoaded, State.Zone), Priority);
+	NumLoads++;
+}
+
+void UCobbleAudioStreaming::UnloadZone(FZoneState& State)
+{
+	if (State.Handle.IsValid())
+	{
+		State.Handle->ReleaseHandle();
+		State.Handle.Reset();
+		NumUnloads++;
+	}
+	State.StallStartTime = 0;
+}
+
+void UCobbleAudioStreaming::OnZoneLoaded(TWeakObjectPtr<ACobbleAudioZone> Zone)
+{
+	FZoneState* State = Zone.IsValid() ? FindZoneState(Zone.Get()) : nullptr;
+	if (State == nullptr || !State->Handle.IsValid())
+		return;
+
+	TArray<UObject*> Assets;
+	State->Handle->GetLoadedAssets(Assets);
+	State->ResidentBytes = 0;
+	for (UObject* Asset : Assets)
+	{
+		if (Asset != nullptr)
+			State->ResidentBytes += Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+
+	if (State->StallStartTime > 0)
+	{
+		const double StallSeconds = FPlatformTime::Seconds() - State->StallStartTime;
+		State->StallStartTime = 0;
+		NumStalls++;
+		TotalStallSeconds += StallSeconds;
+		LongestStallSeconds = FMath::Max(LongestStallSeconds, StallSeconds);
+		UE_LOG(LogTemp, Warning, TEXT("Audio stall: player was in %s for %.0f ms before its audio loaded"), *Zone->GetName(), StallSeconds * 1000);
+	}
+}
+
+bool UCobbleAudioStreaming::IsResident(const FZoneState& State) const
+{
+	return State.Handle.IsValid();
+}
+
+int64 UCobbleAudioStreaming::GetResidentBytes() const
+{
+	int64 Bytes = 0;
+	for (const FZoneState& State : Zones)
+	{
+		if (IsResident(State))
+			Bytes += GetBudgetBytes(State);
+	}
+	return Bytes;
+}
+
+int64 UCobbleAudioStreaming::GetBudgetBytes(const FZoneState& State) const
+{
+	return FMath::Max(State.ResidentBytes, State.EstimatedBytes);
+}
+
+UCobbleAudioStreaming::FZoneState* UCobbleAudioStreaming::FindZoneState(const ACobbleAudioZone* Zone)
+{
+	return Zones.FindByPredicate([Zone](const FZoneState& State) { return State.Zone.Get() == Zone; });
+}
+
+void UCobbleAudioStreaming::PrintReport() const
+{
+	UE_LOG(LogTemp, Display, TEXT("Cobble audio: %.1f KB resident of %d KB budget, %d loads, %d unloads, %d loads waited for budget"),
+		GetResidentBytes() / 1024.0, GetDefault<UCobbleSettings>()->AudioResidentBudgetKB, NumLoads, NumUnloads, NumBudgetWaits);
+	UE_LOG(LogTemp, Display, TEXT("Cobble audio: %d stalls, %.0f ms total, %.0f ms longest"), NumStalls, TotalStallSeconds * 1000, LongestStallSeconds * 1000);
+	for (const FZoneState& State : Zones)
+	{
+		const TCHAR* Status = !IsResident(State) ? TEXT("Unloaded") : State.Handle->HasLoadCompleted() ? TEXT("Loaded") : TEXT("Loading");
+		UE_LOG(LogTemp, Display, TEXT("  %-32s %-9s %8.1f KB %s"), State.Zone.IsValid() ? *State.Zone->GetName() : TEXT("(gone)"), Status,
+			GetBudgetBytes(State) / 1024.0, State.bOccupied ? TEXT("occupied") : State.bWanted ? TEXT("ahead") : TEXT(""));
+	}
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "Engine/StreamableManager.h"
+#include "CobbleAudioStreaming.generated.h"
+
+class ACobbleAudioZone;
+
+/**
+ * Keeps the audio of nearby ACobbleAudioZones resident. Zones within AudioLoadAhead of a local player along the scroll axis
+ * are loaded asynchronously, nearest first. Zones further than AudioUnloadBehind behind every player, or far ahead, are released.
+ * AudioResidentBudgetKB caps the estimated resident size: zones nobody is standing in are evicted, farthest first, to make room,
+ * and loads that still don't fit wait. A zone counts against the budget from the moment its load is issued, with the size
+ * baked into it when it was saved until it has loaded once.
+ *
+ * A stall is a player standing in a zone whose audio isn't loaded yet. Stalls are logged as warnings and Cobble.AudioReport
+ * prints the zones, resident memory and stall totals.
+ */
+UCLASS()
+class COBBLE_API UCobbleAudioStreaming : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterZone(ACobbleAudioZone* Zone);
+	void UnregisterZone(ACobbleAudioZone* Zone);
+	int64 GetResidentBytes() const;
+	void PrintReport() const;
+
+private:
+	struct FZoneState
+	{
+		TWeakObjectPtr<ACobbleAudioZone> Zone;
+		TSharedPtr<FStreamableHandle> Handle;
+		// Estimated once loaded, kept after unloading so the budget knows what a reload costs
+		int64 ResidentBytes = 0;
+		// ACobbleAudioZone::EstimatedBytes, covers media streamed from disk that ResidentBytes leaves out
+		int64 EstimatedBytes = 0;
+		double StallStartTime = 0;
+		// Distance from the nearest local player to the start of the zone along the scroll axis, negative once passed
+		float NearestStart = 0;
+		bool bWanted = false;
+		bool bOccupied = false;
+		bool bReleasable = false;
+	};
+
+	void UpdateZones();
+	void UpdateZoneDistances(const TArray<AActor*>& Viewers);
+	void LoadZone(FZoneState& State);
+	void UnloadZone(FZoneState& State);
+	void OnZoneLoaded(TWeakObjectPtr<ACobbleAudioZone> Zone);
+	bool IsResident(const FZoneState& State) const;
+	// What the zone counts against the budget while loading or loaded
+	int64 GetBudgetBytes(const FZoneState& State) const;
+	FZoneState* FindZoneState(const ACobbleAudioZone* Zone);
+
+private:
+	TArray<FZoneState> Zones;
+	FStreamableManager Streamable;
+	float TimeUntilUpdate = 0;
+
+	int32 NumLoads = 0;
+	int32 NumUnloads = 0;
+	int32 NumBudgetWaits = 0;
+	int32 NumStalls = 0;
+	double TotalStallSeconds = 0;
+	double LongestStallSeconds = 0;
+};
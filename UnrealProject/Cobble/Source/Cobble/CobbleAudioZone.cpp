@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleAudioZone.h"
+#include "CobbleAudioStreaming.h"
+#include "Components/BoxComponent.h"
+#include "Engine/GameInstance.h"
+#include "AssetRegistryModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+
+ACobbleAudioZone::ACobbleAudioZone()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	Bounds = CreateDefaultSubobject<UBoxComponent>(TEXT("Bounds"));
+	Bounds->SetBoxExtent(FVector(2000, 500, 1000));
+	Bounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Bounds->SetGenerateOverlapEvents(false);
+	Bounds->SetHiddenInGame(true);
+	SetRootComponent(Bounds);
+}
+
+float ACobbleAudioZone::GetHalfLengthAlongAxis(const FVector& Axis) const
+{
+	const FVector Extent = Bounds->Bounds.BoxExtent;
+	return FMath::Abs(Axis.X) * Extent.X + FMath::Abs(Axis.Y) * Extent.Y;
+}
+
+int64 ACobbleAudioZone::EstimateAudioBytes() const
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	TSet<FName> Packages;
+	TArray<FName> ToVisit;
+	for (const TSoftObjectPtr<UObject>& Asset : AudioAssets)
+	{
+		if (!Asset.IsNull())
+			ToVisit.Add(FName(*Asset.ToSoftObjectPath().GetLongPackageName()));
+	}
+	// Events keep their media in packages of their own
+	while (ToVisit.Num() > 0)
+	{
+		const FName PackageName = ToVisit.Pop(false);
+		bool bAlreadyVisited = false;
+		Packages.Add(PackageName, &bAlreadyVisited);
+		if (bAlreadyVisited)
+			continue;
+		TArray<FName> Dependencies;
+		AssetRegistry.GetDependencies(PackageName, Dependencies, EAssetRegistryDependencyType::Hard);
+		for (FName Dependency : Dependencies)
+		{
+			if (!FPackageName::IsScriptPackage(Dependency.ToString()))
+				ToVisit.Add(Dependency);
+		}
+	}
+
+	int64 Bytes = 0;
+	for (FName PackageName : Packages)
+	{
+		FString Filename;
+		if (!FPackageName::DoesPackageExist(PackageName.ToString(), nullptr, &Filename))
+			continue;
+		Bytes += FMath::Max<int64>(IFileManager::Get().FileSize(*Filename), 0);
+		// Streamed media is bulk data kept next to the package, which GetResourceSizeBytes leaves out
+		for (const TCHAR* Extension : { TEXT(".uexp"), TEXT(".ubulk"), TEXT(".uptnl") })
+			Bytes += FMath::Max<int64>(IFileManager::Get().FileSize(*FPaths::ChangeExtension(Filename, Extension)), 0);
+	}
+	return Bytes;
+}
+
+#if WITH_EDITOR
+void ACobbleAudioZone::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+	if (!IsTemplate())
+		EstimatedBytes = EstimateAudioBytes();
+}
+#endif
+
+void ACobbleAudioZone::BeginPlay()
+{
+	Super::BeginPlay();
+	if (GetNetMode() == NM_DedicatedServer)
+		return;
+	if (UCobbleAudioStreaming* AudioStreaming = UGameInstance::GetSubsystem<UCobbleAudioStreaming>(GetGameInstance()))
+	{
+		AudioStreaming->RegisterZone(this);
+	}
+}
+
+void ACobbleAudioZone::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCobbleAudioStreaming* AudioStreaming = UGameInstance::GetSubsystem<UCobbleAudioStreaming>(GetGameInstance()))
+	{
+		AudioStreaming->UnregisterZone(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
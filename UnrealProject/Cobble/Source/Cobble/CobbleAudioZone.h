@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleAudioZone.generated.h"
+
+/**
+ * A stretch of level and the audio assets (Wwise events, which carry their own media with event based packaging) it needs.
+ * Place one or more per level or sublevel. UCobbleAudioStreaming loads them ahead of the players and unloads them behind.
+ */
+UCLASS()
+class COBBLE_API ACobbleAudioZone : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleAudioZone();
+
+	// Half the length of the zone along the scroll axis
+	float GetHalfLengthAlongAxis(const FVector& Axis) const;
+	// Size on disk of the audio assets and the packages they depend on, bulk data included so streamed media counts too
+	int64 EstimateAudioBytes() const;
+
+public:
+	UPROPERTY(EditAnywhere, Category = Audio)
+	TArray<TSoftObjectPtr<UObject>> AudioAssets;
+	// EstimateAudioBytes as of the last save, what UCobbleAudioStreaming reserves when it starts loading the zone
+	UPROPERTY(VisibleAnywhere, Category = Audio)
+	int64 EstimatedBytes = 0;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+#endif
+
+	UPROPERTY(VisibleAnywhere)
+	class UBoxComponent* Bounds;
+};
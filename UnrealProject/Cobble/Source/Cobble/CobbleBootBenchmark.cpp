@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleBootBenchmark.h"
+#include "Engine/World.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	FDelegateHandle EndFrameHandle;
+	FDelegateHandle PostLoadMapHandle;
+	double FirstFrameTime = 0;
+	double MapLoadedTime = 0;
+	FString LoadedMapName;
+	int32 FramesToWait = 1;
+	int32 FramesSinceMapLoaded = 0;
+
+	double SinceProcessStart()
+	{
+		return FPlatformTime::Seconds() - GStartTime;
+	}
+
+	// Bytes this process has read, from /proc on Linux. read_bytes is what actually came off the disk, rchar includes the page cache.
+	void GetBytesRead(int64& OutDiskBytes, int64& OutTotalBytes)
+	{
+		OutDiskBytes = -1;
+		OutTotalBytes = -1;
+#if PLATFORM_LINUX
+		FString ProcIO;
+		if (FFileHelper::LoadFileToString(ProcIO, TEXT("/proc/self/io")))
+		{
+			TArray<FString> Lines;
+			ProcIO.ParseIntoArrayLines(Lines);
+			for (const FString& Line : Lines)
+			{
+				FString Key, Value;
+				if (Line.Split(TEXT(":"), &Key, &Value))
+				{
+					if (Key == TEXT("read_bytes"))
+						OutDiskBytes = FCString::Atoi64(*Value.TrimStart());
+					else if (Key == TEXT("rchar"))
+						OutTotalBytes = FCString::Atoi64(*Value.TrimStart());
+				}
+			}
+		}
+#endif
+	}
+
+	void WriteReport()
+	{
+		int64 DiskBytes, TotalBytes;
+		GetBytesRead(DiskBytes, TotalBytes);
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+		FString Json;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Map"), LoadedMapName);
+		Writer->WriteValue(TEXT("SecondsToFirstFrame"), FirstFrameTime);
+		Writer->WriteValue(TEXT("SecondsToMapLoaded"), MapLoadedTime);
+		Writer->WriteValue(TEXT("SecondsToFirstMapFrame"), SinceProcessStart());
+		Writer->WriteValue(TEXT("DiskBytesRead"), DiskBytes);
+		Writer->WriteValue(TEXT("BytesRead"), TotalBytes);
+		Writer->WriteValue(TEXT("PeakUsedPhysicalBytes"), (int64)MemoryStats.PeakUsedPhysical);
+		Writer->WriteValue(TEXT("UsingPak"), FPlatformFileManager::Get().FindPlatformFile(TEXT("PakFile")) != nullptr);
+		Writer->WriteObjectEnd();
+		Writer->Close();
+
+		const FString Filename = FPaths::ProfilingDir() / TEXT("BootReport.json");
+		FFileHelper::SaveStringToFile(Json, *Filename);
+		UE_LOG(LogTemp, Display, TEXT("Boot benchmark: first map frame after %.3fs, report written to %s"), SinceProcessStart(), *Filename);
+	}
+
+	void OnPostLoadMap(UWorld* World)
+	{
+		if (MapLoadedTime == 0 && World != nullptr)
+		{
+			MapLoadedTime = SinceProcessStart();
+			LoadedMapName = World->GetOutermost()->GetName();
+		}
+	}
+
+	void OnEndFrame()
+	{
+		if (FirstFrameTime == 0)
+			FirstFrameTime = SinceProcessStart();
+		if (MapLoadedTime == 0 || ++FramesSinceMapLoaded < FramesToWait)
+			return;
+		WriteReport();
+		FCobbleBootBenchmark::Shutdown();
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void FCobbleBootBenchmark::Startup()
+{
+	if (!FParse::Param(FCommandLine::Get(), TEXT("CobbleBootBench")) || IsRunningCommandlet())
+		return;
+	FParse::Value(FCommandLine::Get(), TEXT("BootBenchFrames="), FramesToWait);
+	FramesToWait = FMath::Max(FramesToWait, 1);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&OnEndFrame);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddStatic(&OnPostLoadMap);
+}
+
+void FCobbleBootBenchmark::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	EndFrameHandle.Reset();
+	PostLoadMapHandle.Reset();
+}
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+Boot benchmark used by Scripts/StartupIO. Enabled with -CobbleBootBench on the command line.
+Waits for the first map to load and draw BootBenchFrames frames (-BootBenchFrames=N, default 1), then writes
+Saved/Profiling/BootReport.json with the time from process start to the first engine frame, to the map being loaded and to
+its first frame, the bytes the process read (Linux) and peak memory, and quits.
+*/
+struct COBBLE_API FCobbleBootBenchmark
+{
+	// Called by the module
+	static void Startup();
+	static void Shutdown();
+};
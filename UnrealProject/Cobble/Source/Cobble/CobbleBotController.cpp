@@ -0,0 +1,338 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleBotController.h"
+#include "CobblePaperCharacter.h"
+#include "CobbleGearHolderComponent.h"
+#include "CobbleManifestBinding.h"
+#include "CobbleHeadless.h"
+#include "CobblePuzzleCheckCommandlet.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+	// Getting closer than this to where the bot is going resets the stuck timer
+	const float ProgressDistance = 10;
+}
+
+ACobbleBotController::ACobbleBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+bool ACobbleBotController::IsRequested()
+{
+	static const bool bRequested = FParse::Param(FCommandLine::Get(), TEXT("CobbleBot"));
+	return bRequested && !IsRunningCommandlet();
+}
+
+void ACobbleBotController::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (State == EBotState::Finished)
+		return;
+	if (State == EBotState::Starting)
+	{
+		// Players log in before or after the game mode starts play depending on the net mode, so wait for one
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			if (ACobblePaperCharacter* Player = It->IsValid() ? Cast<ACobblePaperCharacter>((*It)->GetPawn()) : nullptr)
+			{
+				(*It)->UnPossess();
+				Start(Player);
+				break;
+			}
+		}
+		return;
+	}
+
+	Character = Cast<ACobblePaperCharacter>(GetPawn());
+	if (Character == nullptr)
+	{
+		Finish(false, TEXT("Lost the character"));
+		return;
+	}
+	RecordFrame();
+	if (GetWorld()->GetTimeSeconds() - StartTime > TimeLimitSeconds)
+	{
+		Finish(false, FString::Printf(TEXT("Over the time limit on step %d: %s"), CurrentStep + 1, *Solution.Steps[CurrentStep]));
+		return;
+	}
+	if (State == EBotState::Walking)
+		TickWalking(DeltaTime);
+	else if (State == EBotState::Interacting)
+		TickInteracting();
+}
+
+void ACobbleBotController::Start(ACobblePaperCharacter* InCharacter)
+{
+	Possess(InCharacter);
+	Character = InCharacter;
+	StartTime = GetWorld()->GetTimeSeconds();
+	StartWallTime = FPlatformTime::Seconds();
+	int32 Seed = 0;
+	bRandomized = FParse::Value(FCommandLine::Get(), TEXT("CobbleBotSeed="), Seed);
+	Random.Initialize(Seed);
+
+	// The same reach the puzzle check uses, so a level that passes the check is one the bot should finish
+	const UCobblePuzzleCheckCommandlet* PuzzleCheck = GetDefault<UCobblePuzzleCheckCommandlet>();
+	Reach.MaxGap = PuzzleCheck->MaxGap;
+	Reach.MaxJumpHeight = PuzzleCheck->MaxJumpHeight;
+	FString Error;
+	if (!FCobblePuzzleSolver::ExtractGraph(GetWorld(), Reach, Graph, Error))
+	{
+		Finish(false, Error);
+		return;
+	}
+	// One worker, the other instances on the machine need the cores
+	Solution = FCobblePuzzleSolver::Solve(Graph, 1, MaxSolveStates);
+	if (!Solution.bSolved)
+	{
+		Finish(false, Solution.bComplete ? TEXT("The level has no solution") : TEXT("The solver ran out of states"));
+		return;
+	}
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		SiteActors.Add(It->GetName(), *It);
+	}
+	UE_LOG(LogTemp, Display, TEXT("Cobble bot: playing %d steps, solved in %.2fs"), Solution.Steps.Num(), Solution.Seconds);
+	BeginStep(0);
+}
+
+void ACobbleBotController::BeginStep(int32 Step)
+{
+	CurrentStep = Step;
+	const int32 Site = Solution.StepSites[Step];
+	StepActor = SiteActors.FindRef(Graph.Sites[Site].Name);
+	StepComponent = nullptr;
+	if (AActor* Actor = StepActor.Get())
+	{
+		UCobbleGearHolderComponent* Holder = ACobbleManifestBinding::FindGearHolder(Actor);
+		StepComponent = Holder != nullptr ? (USceneComponent*)Holder : Actor->GetRootComponent();
+	}
+	else if (Step < Solution.Steps.Num() - 1)
+	{
+		Finish(false, FString::Printf(TEXT("Could not find %s for step %d: %s"), *Graph.Sites[Site].Name, Step + 1, *Solution.Steps[Step]));
+		return;
+	}
+
+	PlanRoute(Site);
+	ClosestDistance = MAX_flt;
+	LastProgressTime = GetWorld()->GetTimeSeconds();
+	BlockedTime = 0;
+	InteractAttempts = 0;
+	PauseUntil = bRandomized ? LastProgressTime + Random.FRandRange(0, MaxPauseSeconds) : 0;
+	State = EBotState::Walking;
+	UE_LOG(LogTemp, Log, TEXT("Cobble bot: step %d of %d, %s"), Step + 1, Solution.Steps.Num(), *Solution.Steps[Step]);
+}
+
+void ACobbleBotController::PlanRoute(int32 Site)
+{
+	Route.Reset();
+	const FVector Location = Character->GetActorLocation();
+	int32 From = INDEX_NONE;
+	float ClosestSquared = MAX_flt;
+	for (int32 Index = 0; Index < Graph.Sites.Num(); Index++)
+	{
+		const float DistanceSquared = FVector::DistSquared(Graph.Sites[Index].Location, Location);
+		if (DistanceSquared < ClosestSquared)
+		{
+			ClosestSquared = DistanceSquared;
+			From = Index;
+		}
+	}
+
+	// Breadth first over the edges, ignoring what they need powered since the solution already has it powered by now
+	TArray<int32> Previous;
+	Previous.Init(INDEX_NONE, Graph.Sites.Num());
+	TArray<int32> Queue;
+	Queue.Add(From);
+	Previous[From] = From;
+	for (int32 Index = 0; Index < Queue.Num() && Previous[Site] == INDEX_NONE; Index++)
+	{
+		for (const FCobblePuzzleEdge& Edge : Graph.Edges[Queue[Index]])
+		{
+			if (Previous[Edge.To] == INDEX_NONE)
+			{
+				Previous[Edge.To] = Queue[Index];
+				Queue.Add(Edge.To);
+			}
+		}
+	}
+	// Off the graph the bot heads straight for the site and the stuck check decides
+	if (Previous[Site] == INDEX_NONE)
+		return;
+	for (int32 Waypoint = Previous[Site]; Waypoint != From; Waypoint = Previous[Waypoint])
+	{
+		Route.Insert(Waypoint, 0);
+	}
+}
+
+FVector ACobbleBotController::GetStepLocation() const
+{
+	// Holders can ride on platforms, so follow the component rather than the baked site
+	if (const USceneComponent* Component = StepComponent.Get())
+		return Component->GetComponentLocation();
+	return Graph.Sites[Solution.StepSites[CurrentStep]].Location;
+}
+
+void ACobbleBotController::TickWalking(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now < PauseUntil)
+		return;
+	const bool bAtStepSite = Route.Num() == 0;
+	const FVector Target = bAtStepSite ? GetStepLocation() : Graph.Sites[Route[0]].Location;
+	const FVector Location = Character->GetActorLocation();
+	const FVector Forward = Character->GetActorForwardVector();
+	const float Along = FVector::DotProduct(Target - Location, Forward);
+	const float Height = Target.Z - Location.Z;
+	const bool bFalling = Character->GetMovementComponent()->IsFalling();
+	const bool bArrived = FMath::Abs(Along) < ArriveDistance && FMath::Abs(Height) < ArriveHeight;
+
+	// Riding a platform counts as progress, waiting for one only as long as StuckSeconds
+	const float Distance = FVector::Dist(Target, Location);
+	if (Distance < ClosestDistance - ProgressDistance)
+	{
+		ClosestDistance = Distance;
+		LastProgressTime = Now;
+	}
+	else if (Now - LastProgressTime > StuckSeconds)
+	{
+		Finish(false, FString::Printf(TEXT("Stuck on step %d: %s"), CurrentStep + 1, *Solution.Steps[CurrentStep]));
+		return;
+	}
+
+	float Input = FMath::Abs(Along) > ArriveDistance * 0.5f ? FMath::Sign(Along) : 0;
+	if (!bAtStepSite)
+	{
+		if (bArrived)
+		{
+			Route.RemoveAt(0);
+			ClosestDistance = MAX_flt;
+		}
+	}
+	else if (CurrentStep == Solution.Steps.Num() - 1)
+	{
+		if (bArrived)
+		{
+			Finish(true, TEXT("Reached the goal"));
+			return;
+		}
+	}
+	else if (Character->OverlappedActor == StepActor.Get() && !bFalling)
+	{
+		BeginInteract();
+		return;
+	}
+	else if (bArrived && Character->OverlappedActor != nullptr)
+	{
+		// Something else next to the step's actor has the highlight, step away from it until it lets go
+		Input = FMath::Sign(FVector::DotProduct(Location - Character->OverlappedActor->GetActorLocation(), Forward));
+	}
+	Character->MoveHorizontal(Input);
+
+	const float Speed = FVector::DotProduct(Character->GetVelocity(), Forward);
+	BlockedTime = Input != 0 && FMath::Abs(Speed) < 1 && !bFalling ? BlockedTime + DeltaTime : 0;
+	const bool bHop = bRandomized && Random.FRand() < HopsPerSecond * DeltaTime;
+	const bool bClimb = Height > JumpHeight && FMath::Abs(Along) < Reach.MaxGap;
+	if (!bFalling && !Character->IsActionActive(Character->JumpAction) && (BlockedTime > BlockedSeconds || bClimb || bHop))
+	{
+		Character->PreJump();
+		BlockedTime = 0;
+		Jumps++;
+	}
+}
+
+void ACobbleBotController::BeginInteract()
+{
+	State = EBotState::Interacting;
+	InteractAttempts++;
+	Interactions++;
+	InteractTime = GetWorld()->GetTimeSeconds();
+	bWasHoldingGear = Character->IsPlayerHoldingGear();
+	// Holding a hose or a box this drops it instead, which the next attempt makes up for
+	Character->Interact();
+}
+
+void ACobbleBotController::TickInteracting()
+{
+	if (Character->IsActionActive(Character->InteractAction) || GetWorld()->GetTimeSeconds() - InteractTime < InteractSettleSeconds)
+		return;
+	if (DidStepTake())
+	{
+		BeginStep(CurrentStep + 1);
+		return;
+	}
+	if (InteractAttempts >= MaxInteractAttempts)
+	{
+		Finish(false, FString::Printf(TEXT("Step %d did not take: %s"), CurrentStep + 1, *Solution.Steps[CurrentStep]));
+		return;
+	}
+	State = EBotState::Walking;
+}
+
+bool ACobbleBotController::DidStepTake() const
+{
+	// Every step before the goal picks up, takes out or puts in a gear
+	return Character->IsPlayerHoldingGear() != bWasHoldingGear;
+}
+
+void ACobbleBotController::RecordFrame()
+{
+	const double FrameMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Frames++;
+	TotalFrameMs += FrameMs;
+	MaxFrameMs = FMath::Max(MaxFrameMs, FrameMs);
+	if (FrameMs > HitchMilliseconds)
+		Hitches++;
+}
+
+void ACobbleBotController::Finish(bool bPassed, const FString& Reason)
+{
+	State = EBotState::Finished;
+	if (Character != nullptr)
+		Character->MoveHorizontal(0);
+	UE_LOG(LogTemp, Display, TEXT("Cobble bot: %s, %s"), bPassed ? TEXT("passed") : TEXT("failed"), *Reason);
+	WriteReport(bPassed, Reason);
+	FPlatformMisc::RequestExit(false);
+}
+
+void ACobbleBotController::WriteReport(bool bPassed, const FString& Reason) const
+{
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("Map"), UWorld::RemovePIEPrefix(GetWorld()->GetMapName()));
+	Writer->WriteValue(TEXT("Passed"), bPassed);
+	Writer->WriteValue(TEXT("Reason"), Reason);
+	Writer->WriteValue(TEXT("Seed"), bRandomized ? Random.GetInitialSeed() : -1);
+	Writer->WriteValue(TEXT("Headless"), FCobbleHeadless::IsEnabled(this));
+	Writer->WriteValue(TEXT("StepsCompleted"), bPassed ? Solution.Steps.Num() : CurrentStep);
+	Writer->WriteValue(TEXT("Steps"), Solution.Steps.Num());
+	Writer->WriteValue(TEXT("Interactions"), Interactions);
+	Writer->WriteValue(TEXT("Jumps"), Jumps);
+	Writer->WriteValue(TEXT("SolveSeconds"), Solution.Seconds);
+	Writer->WriteValue(TEXT("GameSeconds"), GetWorld()->GetTimeSeconds() - StartTime);
+	Writer->WriteValue(TEXT("WallSeconds"), FPlatformTime::Seconds() - StartWallTime);
+	Writer->WriteValue(TEXT("Frames"), Frames);
+	Writer->WriteValue(TEXT("AverageGameThreadMs"), Frames > 0 ? TotalFrameMs / Frames : 0);
+	Writer->WriteValue(TEXT("MaxGameThreadMs"), MaxFrameMs);
+	Writer->WriteValue(TEXT("Hitches"), Hitches);
+	Writer->WriteValue(TEXT("PeakUsedPhysicalBytes"), (int64)MemoryStats.PeakUsedPhysical);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FString Filename = FPaths::ProjectSavedDir() / TEXT("Playtests") / TEXT("BotReport.json");
+	FParse::Value(FCommandLine::Get(), TEXT("CobbleBotReport="), Filename);
+	FFileHelper::SaveStringToFile(Json, *Filename);
+	UE_LOG(LogTemp, Display, TEXT("Cobble bot: report written to %s"), *Filename);
+}
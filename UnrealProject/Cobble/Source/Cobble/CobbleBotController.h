@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+#include "CobblePuzzleSolver.h"
+#include "CobbleBotController.generated.h"
+
+class ACobblePaperCharacter;
+
+/**
+ * Plays a level on its own for soak testing, see Scripts/Playtest. Enabled with -CobbleBot on the command line, usually next
+ * to -CobbleHeadless. The game mode spawns it, it takes over the first player's character, solves the level with
+ * FCobblePuzzleSolver and plays the solution through the character's own MoveHorizontal, PreJump and Interact: along the
+ * puzzle graph to each step's site, jumping when the next site is higher or the character stops moving, and interacting once
+ * the step's actor is the one the character has highlighted.
+ *
+ * The run passes when the character gets to the goal. It fails when the level has no solution, a step doesn't take after
+ * MaxInteractAttempts, the character gets no closer to where it is going for StuckSeconds or the run is over TimeLimitSeconds.
+ * The result, with game thread frame times and peak memory, is written to -CobbleBotReport=File (Saved/Playtests/BotReport.json
+ * by default) and the game quits. -CobbleBotSeed=N adds random pauses and hops so parallel runs don't all play alike.
+ */
+UCLASS(config = Game, NotPlaceable)
+class COBBLE_API ACobbleBotController : public AController
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleBotController();
+
+	static bool IsRequested();
+
+	virtual void Tick(float DeltaTime) override;
+
+public:
+	UPROPERTY(config)
+	float TimeLimitSeconds = 600;
+	UPROPERTY(config)
+	float StuckSeconds = 20;
+	// How close along the scroll axis and in height counts as being at a site
+	UPROPERTY(config)
+	float ArriveDistance = 30;
+	UPROPERTY(config)
+	float ArriveHeight = 100;
+	// Higher than this the bot jumps toward a site once it is within the reach's MaxGap
+	UPROPERTY(config)
+	float JumpHeight = 60;
+	// Jumps when pushing against something for this long without moving
+	UPROPERTY(config)
+	float BlockedSeconds = 0.3f;
+	UPROPERTY(config)
+	int32 MaxInteractAttempts = 3;
+	// Waited after an interaction's animation before checking it took
+	UPROPERTY(config)
+	float InteractSettleSeconds = 0.2f;
+	UPROPERTY(config)
+	int64 MaxSolveStates = 1000000;
+	// Seeded runs only, longest pause before each step and chance of a hop each second
+	UPROPERTY(config)
+	float MaxPauseSeconds = 2;
+	UPROPERTY(config)
+	float HopsPerSecond = 0.2f;
+	// Game thread frames over this count as hitches in the report
+	UPROPERTY(config)
+	float HitchMilliseconds = 50;
+
+private:
+	enum class EBotState : uint8
+	{
+		Starting,
+		Walking,
+		Interacting,
+		Finished
+	};
+
+	void Start(ACobblePaperCharacter* InCharacter);
+	void BeginStep(int32 Step);
+	void TickWalking(float DeltaTime);
+	void TickInteracting();
+	void BeginInteract();
+	bool DidStepTake() const;
+	// Fills Route with the sites between the character and Site, following the puzzle graph
+	void PlanRoute(int32 Site);
+	FVector GetStepLocation() const;
+	void Finish(bool bPassed, const FString& Reason);
+	void RecordFrame();
+	void WriteReport(bool bPassed, const FString& Reason) const;
+
+private:
+	EBotState State = EBotState::Starting;
+	ACobblePaperCharacter* Character = nullptr;
+	FCobblePuzzleReach Reach;
+	FCobblePuzzleGraph Graph;
+	FCobblePuzzleSolution Solution;
+	TMap<FString, TWeakObjectPtr<AActor>> SiteActors;
+	FRandomStream Random;
+	bool bRandomized = false;
+
+	int32 CurrentStep = 0;
+	TWeakObjectPtr<AActor> StepActor;
+	TWeakObjectPtr<USceneComponent> StepComponent; // Where to stand for the step, a holder component or the actor's root
+	TArray<int32> Route;
+	float ClosestDistance = MAX_flt;
+	float LastProgressTime = 0;
+	float BlockedTime = 0;
+	float PauseUntil = 0;
+
+	int32 InteractAttempts = 0;
+	float InteractTime = 0;
+	bool bWasHoldingGear = false;
+
+	float StartTime = 0;
+	double StartWallTime = 0;
+	int32 Frames = 0;
+	double TotalFrameMs = 0;
+	double MaxFrameMs = 0;
+	int32 Hitches = 0;
+	int32 Jumps = 0;
+	int32 Interactions = 0;
+};
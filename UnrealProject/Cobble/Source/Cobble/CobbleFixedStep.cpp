@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleFixedStep.h"
+#include "CobbleSettings.h"
+#include "CobbleHitchDetector.h"
+#include "Engine/World.h"
+
+namespace
+{
+	TMap<const UWorld*, TWeakObjectPtr<ACobbleFixedStep>> WorldSteppers;
+}
+
+ACobbleFixedStep::ACobbleFixedStep()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Before character movement, so characters standing on machines see where they are this frame
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("Root")));
+
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	StepSeconds = 1 / FMath::Max(Settings->FixedStepRate, 1.0f);
+	MaxStepsPerFrame = FMath::Max(Settings->MaxFixedStepsPerFrame, 1);
+}
+
+bool ACobbleFixedStep::IsEnabled()
+{
+	return GetDefault<UCobbleSettings>()->bFixedStepGameplay;
+}
+
+ACobbleFixedStep* ACobbleFixedStep::Get(UWorld* World, bool bCreate)
+{
+	if (World == nullptr || !World->IsGameWorld())
+		return nullptr;
+	if (ACobbleFixedStep* Stepper = WorldSteppers.FindRef(World).Get())
+		return Stepper;
+	if (!bCreate || World->bIsTearingDown)
+		return nullptr;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACobbleFixedStep* Stepper = World->SpawnActor<ACobbleFixedStep>(SpawnParams);
+	WorldSteppers.Add(World, Stepper);
+	return Stepper;
+}
+
+void ACobbleFixedStep::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WorldSteppers.Remove(GetWorld());
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACobbleFixedStep::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	Accumulator += DeltaTime;
+	int32 NumSteps = 0;
+	while (Accumulator >= StepSeconds && NumSteps < MaxStepsPerFrame)
+	{
+		Accumulator -= StepSeconds;
+		StepTimeBehind = Accumulator;
+		StepEvent.Broadcast(StepSeconds);
+		NumSteps++;
+	}
+	if (Accumulator >= StepSeconds)
+	{
+		FCobbleHitchDetector::RecordEvent(ECobbleEvent::FixedStepsDropped, this, Accumulator);
+		Accumulator = FMath::Fmod(Accumulator, StepSeconds);
+	}
+	StepTimeBehind = 0;
+	InterpolateEvent.Broadcast(Accumulator / StepSeconds);
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleFixedStep.generated.h"
+
+// Step seconds for OnStep, how far the frame is between the last two steps (0 to 1) for OnInterpolate
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnCobbleFixedStep, float);
+
+// Previous and current simulated location of something stepped at the fixed rate, for drawing it in between
+struct FCobbleStepLocation
+{
+	FVector Previous = FVector::ZeroVector;
+	FVector Current = FVector::ZeroVector;
+
+	void Reset(const FVector& Location) { Previous = Current = Location; }
+	void Push(const FVector& Location) { Previous = Current; Current = Location; }
+	FVector Get(float Alpha) const { return FMath::Lerp(Previous, Current, Alpha); }
+};
+
+/**
+ * Runs gameplay simulation at a fixed rate (Project Settings > Cobble > Fixed Step) instead of once per frame with the frame's
+ * delta time, so machines behave the same at any frame rate and a long frame can't push them further than a normal one.
+ *
+ * Each frame the step runs zero or more times to catch up with the frame time, at most MaxFixedStepsPerFrame times. Time past
+ * that is dropped, the game slows down through the spike instead of simulating it all at once. After the steps OnInterpolate
+ * lets everything place its visuals between its last two simulated states. Opt in, nothing uses it unless
+ * bFixedStepGameplay is set.
+ */
+UCLASS(NotPlaceable)
+class COBBLE_API ACobbleFixedStep : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleFixedStep();
+
+	static bool IsEnabled();
+	// The stepper for a game world, spawned on first use if bCreate. nullptr outside game worlds.
+	static ACobbleFixedStep* Get(UWorld* World, bool bCreate = true);
+
+	FOnCobbleFixedStep& OnStep() { return StepEvent; }
+	FOnCobbleFixedStep& OnInterpolate() { return InterpolateEvent; }
+	float GetStepSeconds() const { return StepSeconds; }
+	// During OnStep, how long before the current frame time the step being run is
+	float GetStepTimeBehind() const { return StepTimeBehind; }
+
+	virtual void Tick(float DeltaTime) override;
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	FOnCobbleFixedStep StepEvent;
+	FOnCobbleFixedStep InterpolateEvent;
+	float StepSeconds = 1 / 60.0f;
+	int32 MaxStepsPerFrame = 4;
+	float Accumulator = 0;
+	float StepTimeBehind = 0;
+};
+
+// An object's OnStep and OnInterpolate bindings, bound while it has something to simulate
+struct FCobbleFixedStepBinding
+{
+	FDelegateHandle StepHandle;
+	FDelegateHandle InterpolateHandle;
+
+	bool IsBound() const { return StepHandle.IsValid(); }
+
+	template<typename UserClass>
+	void Bind(UWorld* World, UserClass* Object, void (UserClass::*StepFunc)(float), void (UserClass::*InterpolateFunc)(float))
+	{
+		Unbind(World);
+		if (ACobbleFixedStep* Stepper = ACobbleFixedStep::Get(World))
+		{
+			StepHandle = Stepper->OnStep().AddUObject(Object, StepFunc);
+			InterpolateHandle = Stepper->OnInterpolate().AddUObject(Object, InterpolateFunc);
+		}
+	}
+
+	void Unbind(UWorld* World)
+	{
+		if (!IsBound())
+			return;
+		if (ACobbleFixedStep* Stepper = ACobbleFixedStep::Get(World, false))
+		{
+			Stepper->OnStep().Remove(StepHandle);
+			Stepper->OnInterpolate().Remove(InterpolateHandle);
+		}
+		StepHandle.Reset();
+		InterpolateHandle.Reset();
+	}
+};
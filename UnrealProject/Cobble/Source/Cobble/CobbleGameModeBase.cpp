@@ -2,4 +2,64 @@
 
 
 #include "CobbleGameModeBase.h"
+#include "CobbleBotController.h"
+#include "CobbleLevelTransitions.h"
+#include "CobblePaperCharacter.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 
+ACobbleGameModeBase::ACobbleGameModeBase()
+{
+	bUseSeamlessTravel = true;
+}
+
+void ACobbleGameModeBase::StartPlay()
+{
+	Super::StartPlay();
+	if (ACobbleBotController::IsRequested())
+		GetWorld()->SpawnActor<ACobbleBotController>();
+}
+
+void ACobbleGameModeBase::PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+	if (ErrorMessage.IsEmpty() && GetNumPlayers() >= MaxCoopPlayers)
+	{
+		ErrorMessage = TEXT("Server full");
+	}
+}
+
+void ACobbleGameModeBase::GetSeamlessTravelActorList(bool bToTransition, TArray<AActor*>& ActorList)
+{
+	Super::GetSeamlessTravelActorList(bToTransition, ActorList);
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (ACobblePaperCharacter* Character = It->IsValid() ? Cast<ACobblePaperCharacter>((*It)->GetPawn()) : nullptr)
+		{
+			ActorList.Add(Character);
+			Character->GetHeldItems(ActorList);
+		}
+	}
+}
+
+void ACobbleGameModeBase::HandleSeamlessTravelPlayer(AController*& C)
+{
+	Super::HandleSeamlessTravelPlayer(C);
+	// A character that travelled is still where it was in the old map
+	APawn* Pawn = C != nullptr ? C->GetPawn() : nullptr;
+	AActor* PlayerStart = Pawn != nullptr ? FindPlayerStart(C) : nullptr;
+	if (PlayerStart != nullptr)
+	{
+		Pawn->TeleportTo(PlayerStart->GetActorLocation(), PlayerStart->GetActorRotation());
+	}
+}
+
+void ACobbleGameModeBase::PostSeamlessTravel()
+{
+	Super::PostSeamlessTravel();
+	if (UCobbleLevelTransitions* Transitions = UGameInstance::GetSubsystem<UCobbleLevelTransitions>(GetGameInstance()))
+	{
+		Transitions->OnTravelFinished(GetWorld());
+	}
+}
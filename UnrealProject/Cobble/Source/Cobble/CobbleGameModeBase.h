@@ -7,11 +7,26 @@
 #include "CobbleGameModeBase.generated.h"
 
 /**
- * 
+ * Co-op game mode. Host with ?listen on the map URL, the second player joins by connecting to the host's address.
+ * See CobbleNetworking.h for running both players on one machine.
+ * Travel between maps is seamless: characters and their held gears are carried to the next map's player starts,
+ * see UCobbleLevelTransitions.
+ * With -CobbleBot on the command line an ACobbleBotController plays the level, see Scripts/Playtest.
  */
 UCLASS()
 class COBBLE_API ACobbleGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	ACobbleGameModeBase();
+	virtual void StartPlay() override;
+	virtual void PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
+	virtual void GetSeamlessTravelActorList(bool bToTransition, TArray<AActor*>& ActorList) override;
+	virtual void HandleSeamlessTravelPlayer(AController*& C) override;
+	virtual void PostSeamlessTravel() override;
+
+public:
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "1"))
+	int32 MaxCoopPlayers = 2;
 };
@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleGearHolderComponent.h"
+#include "Gear.h"
+#include "CobbleNetworking.h"
+#include "CobbleHitchDetector.h"
+#include "CobbleMachineAudio.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleTelemetry.h"
+#include "PaperSprite.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/ConstructorHelpers.h"
+
+UCobbleGearHolderComponent::UCobbleGearHolderComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false; // Only ticks while a gear is turning
+	SetIsReplicatedByDefault(true);
+	SetCollisionProfileName("OverlapAll");
+	// What BP_GearHolder set on its sprites before the holder was a component, so content saved back then still draws
+	static ConstructorHelpers::FObjectFinderOptional<UPaperSprite> DefaultSprite(TEXT("/Game/Art/Textures/GearHolder/Gear_Holder_Sprite.Gear_Holder_Sprite"));
+	static ConstructorHelpers::FObjectFinderOptional<UPaperSprite> DefaultHighlightSprite(TEXT("/Game/Art/Textures/Gear/gear_inmachine_Sprite.gear_inmachine_Sprite"));
+	SourceSprite = DefaultSprite.Get();
+	HighlightSprite = DefaultHighlightSprite.Get();
+}
+
+void UCobbleGearHolderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	HolderSprite = GetSprite();
+	ACobbleMachineAudio* MachineAudio = TurningLoopEvent != nullptr ? ACobbleMachineAudio::Get(GetWorld()) : nullptr;
+	if (MachineAudio != nullptr)
+	{
+		MachineSoundId = MachineAudio->RegisterSource(this, TurningLoopEvent, TurningLoopLoudness);
+		MachineAudio->SetSourceActive(MachineSoundId, bWasPowered);
+	}
+	// Left alone if another holder already took it
+	if (StartingGear != nullptr && StartingGear->GetAttachParentActor() == nullptr && !HasGearInHolder() && GetOwnerRole() == ROLE_Authority)
+		SeatGear(StartingGear);
+}
+
+void UCobbleGearHolderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnbindFromPlayerHeldItem();
+	FixedStepBinding.Unbind(GetWorld());
+	if (ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(GetWorld(), false))
+		MachineAudio->UnregisterSource(MachineSoundId);
+	MachineSoundId = INDEX_NONE;
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCobbleGearHolderComponent::Highlight(ACobblePaperCharacter* Interactor)
+{
+	BindToPlayerHeldItem(Interactor);
+	UpdateHighlight(Interactor, true);
+}
+
+void UCobbleGearHolderComponent::Unhighlight(ACobblePaperCharacter* Interactor)
+{
+	UpdateHighlight(Interactor, false);
+	UnbindFromPlayerHeldItem();
+}
+
+void UCobbleGearHolderComponent::Interact(ACobblePaperCharacter* Interactor)
+{
+	if (Interactor == nullptr)
+		return;
+	if (HasGearInHolder())
+	{
+		if (Interactor->PickUpItem(GearInHolder))
+		{
+			AActor* OldGear = GearInHolder;
+			FCobbleNet::MarkStateChanged(GetOwner());
+			GearInHolder = nullptr;
+			if (AGear* Gear = Cast<AGear>(OldGear))
+				Gear->SetIsHeld(true);
+			OnRep_GearInHolder(OldGear);
+		}
+	}
+	else
+	{
+		AActor* NewGear = Interactor->ReleaseHeldItem(EHeldItemType::Gear);
+		if (NewGear != nullptr)
+			SeatGear(NewGear);
+	}
+}
+
+void UCobbleGearHolderComponent::SeatGear(AActor* NewGear)
+{
+	FCobbleNet::MarkStateChanged(GetOwner());
+	GearInHolder = NewGear;
+	bIsGearTurning = true;
+	OnRep_GearInHolder(nullptr);
+	// Once attached, so the gear doesn't merge its sprite for the moment it is neither held nor in the holder
+	if (AGear* Gear = Cast<AGear>(NewGear))
+		Gear->SetIsHeld(false);
+}
+
+void UCobbleGearHolderComponent::OnRep_GearInHolder(AActor* OldGear)
+{
+	if (OldGear != nullptr && OldGear->GetRootComponent()->GetAttachParent() == this)
+	{
+		OldGear->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		// Batched again if it was left in the level rather than taken
+		if (AInteractable* Gear = Cast<AInteractable>(OldGear))
+			Gear->SetSpriteBatched(true);
+	}
+	if (GearInHolder != nullptr)
+	{
+		if (AInteractable* Gear = Cast<AInteractable>(GearInHolder))
+			Gear->SetSpriteBatched(false); // It turns while in the holder
+		GearInHolder->AttachToComponent(this, FAttachmentTransformRules::KeepWorldTransform);
+		FTransform GearTransform = GetComponentTransform();
+		GearTransform.SetScale3D(GearInHolder->GetActorScale3D());
+		GearInHolder->SetActorTransform(GearTransform);
+		if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+			PhysicsRegions->UpdateActorCells(GearInHolder);
+		FCobbleHitchDetector::RecordEvent(ECobbleEvent::GearPlacedInHolder, GetOwner());
+	}
+	if (HighlightingPlayer != nullptr)
+	{
+		UpdateHighlight(HighlightingPlayer, true);
+	}
+	UpdatePowerState();
+}
+
+void UCobbleGearHolderComponent::OnRep_IsGearTurning()
+{
+	UpdatePowerState();
+}
+
+void UCobbleGearHolderComponent::UpdatePowerState()
+{
+	const bool bIsPowered = GetIsGearTurning();
+	if (bIsPowered != bWasPowered)
+	{
+		bWasPowered = bIsPowered;
+		SetTurning(bIsPowered);
+		if (ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(GetWorld(), false))
+			MachineAudio->SetSourceActive(MachineSoundId, bIsPowered);
+		PowerChangedEvent.Broadcast(bIsPowered);
+	}
+}
+
+void UCobbleGearHolderComponent::SetTurning(bool bTurning)
+{
+	const bool bFixedStep = bTurning && ACobbleFixedStep::IsEnabled();
+	SetComponentTickEnabled(bTurning && !bFixedStep);
+	if (!bFixedStep)
+	{
+		FixedStepBinding.Unbind(GetWorld());
+	}
+	else if (!FixedStepBinding.IsBound())
+	{
+		CurrentGearRotation = PreviousGearRotation = GearInHolder->GetRootComponent()->GetRelativeTransform().GetRotation();
+		FixedStepBinding.Bind(GetWorld(), this, &UCobbleGearHolderComponent::FixedStep, &UCobbleGearHolderComponent::InterpolateFixedStep);
+	}
+}
+
+void UCobbleGearHolderComponent::FixedStep(float StepSeconds)
+{
+	COBBLE_TELEMETRY_SCOPE(Interactables);
+	PreviousGearRotation = CurrentGearRotation;
+	CurrentGearRotation = (CurrentGearRotation * FQuat(GearRotation * StepSeconds)).GetNormalized();
+}
+
+void UCobbleGearHolderComponent::InterpolateFixedStep(float Alpha)
+{
+	if (GearInHolder != nullptr)
+		GearInHolder->SetActorRelativeRotation(FQuat::Slerp(PreviousGearRotation, CurrentGearRotation, Alpha));
+}
+
+bool UCobbleGearHolderComponent::GetIsGearTurning() const
+{
+	return GearInHolder != nullptr && bIsGearTurning;
+}
+
+void UCobbleGearHolderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	COBBLE_TELEMETRY_SCOPE(Interactables);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (GetIsGearTurning())
+	{
+		GearInHolder->AddActorLocalRotation(GearRotation * DeltaTime);
+	}
+}
+
+void UCobbleGearHolderComponent::UpdateHighlight(ACobblePaperCharacter* ForPlayer, bool bHighlighted)
+{
+	if (ForPlayer == nullptr)
+		return;
+	if (HasGearInHolder())
+	{
+		// Offer the gear in the holder to the player
+		SetShowingGearInput(false);
+		if (bHighlighted && ForPlayer->HasFreeHeldItemSlot())
+			ForPlayer->ShowGearHighlight();
+		else
+			ForPlayer->HideGearHighlight();
+	}
+	else
+	{
+		// Display the gear input highlight when the player has a gear to put in
+		SetShowingGearInput(bHighlighted && ForPlayer->IsPlayerHoldingGear());
+	}
+}
+
+void UCobbleGearHolderComponent::SetShowingGearInput(bool bShow)
+{
+	UPaperSprite* WantedSprite = bShow && HighlightSprite != nullptr ? HighlightSprite : HolderSprite;
+	if (GetSprite() != WantedSprite)
+		SetSprite(WantedSprite);
+}
+
+void UCobbleGearHolderComponent::BindToPlayerHeldItem(ACobblePaperCharacter* InPlayer)
+{
+	UnbindFromPlayerHeldItem();
+	HighlightingPlayer = InPlayer;
+	if (HighlightingPlayer != nullptr)
+	{
+		HeldItemChangedHandle = HighlightingPlayer->OnHeldItemChanged().AddUObject(this, &UCobbleGearHolderComponent::OnPlayerHeldItemChanged);
+	}
+}
+
+void UCobbleGearHolderComponent::UnbindFromPlayerHeldItem()
+{
+	if (HighlightingPlayer != nullptr && HeldItemChangedHandle.IsValid())
+	{
+		HighlightingPlayer->OnHeldItemChanged().Remove(HeldItemChangedHandle);
+	}
+	HeldItemChangedHandle.Reset();
+	HighlightingPlayer = nullptr;
+}
+
+void UCobbleGearHolderComponent::OnPlayerHeldItemChanged(int32 SlotIndex, EHeldItemType OldType, EHeldItemType NewType)
+{
+	UpdateHighlight(HighlightingPlayer, true);
+}
+
+void UCobbleGearHolderComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(UCobbleGearHolderComponent, GearInHolder);
+	DOREPLIFETIME(UCobbleGearHolderComponent, bIsGearTurning);
+}
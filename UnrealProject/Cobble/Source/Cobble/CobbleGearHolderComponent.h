@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PaperSpriteComponent.h"
+#include "CobblePaperCharacter.h"
+#include "CobbleFixedStep.h"
+#include "CobbleGearHolderComponent.generated.h"
+
+// True when a gear starts turning in the holder, false when it stops
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGearHolderPowerChanged, bool);
+
+/**
+ * A socket a gear can be put in, drawn with the holder sprite. A gear in the holder turns and powers whatever owns the
+ * component. The owning actor implements IInteractInterface and forwards Highlight, Unhighlight and Interact here.
+ * While a player holding a gear is in reach the sprite is swapped for HighlightSprite, and the gear sits at the
+ * component's transform once it is put in.
+ */
+UCLASS(ClassGroup = Cobble, meta = (BlueprintSpawnableComponent))
+class COBBLE_API UCobbleGearHolderComponent : public UPaperSpriteComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCobbleGearHolderComponent();
+
+	void Highlight(ACobblePaperCharacter* Interactor);
+	void Unhighlight(ACobblePaperCharacter* Interactor);
+	void Interact(ACobblePaperCharacter* Interactor);
+	bool GetIsGearTurning() const;
+	bool HasGearInHolder() const { return GearInHolder != nullptr; }
+	FOnGearHolderPowerChanged& OnPowerChanged() { return PowerChangedEvent; }
+
+	// Turns the gear while powered, unless fixed step gameplay is on
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Gear Holder")
+	class UPaperSprite* HighlightSprite;
+	UPROPERTY(EditAnywhere, Category = "Gear Holder")
+	FRotator GearRotation = FRotator(-200, 0, 0);
+	// Put in the holder when play starts, so a level can begin with its machines running
+	UPROPERTY(EditAnywhere, Category = "Gear Holder")
+	class AGear* StartingGear = nullptr;
+	// Loops while a gear turns in the holder, played through ACobbleMachineAudio
+	UPROPERTY(EditAnywhere, Category = Audio)
+	class UAkAudioEvent* TurningLoopEvent = nullptr;
+	UPROPERTY(EditAnywhere, Category = Audio)
+	float TurningLoopLoudness = 1;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void UpdateHighlight(ACobblePaperCharacter* ForPlayer, bool bHighlighted);
+	void SetShowingGearInput(bool bShow);
+	void BindToPlayerHeldItem(ACobblePaperCharacter* InPlayer);
+	void UnbindFromPlayerHeldItem();
+	void OnPlayerHeldItemChanged(int32 SlotIndex, EHeldItemType OldType, EHeldItemType NewType);
+	// Server only
+	void SeatGear(AActor* NewGear);
+	UFUNCTION()
+	void OnRep_GearInHolder(AActor* OldGear);
+	UFUNCTION()
+	void OnRep_IsGearTurning();
+	void UpdatePowerState();
+	void SetTurning(bool bTurning);
+	void FixedStep(float StepSeconds);
+	void InterpolateFixedStep(float Alpha);
+
+private:
+	UPROPERTY(ReplicatedUsing = OnRep_GearInHolder)
+	AActor* GearInHolder = nullptr;
+	UPROPERTY(ReplicatedUsing = OnRep_IsGearTurning)
+	bool bIsGearTurning = false;
+	// The sprite set in the editor, put back when the highlight goes
+	UPROPERTY(Transient)
+	class UPaperSprite* HolderSprite = nullptr;
+	bool bWasPowered = false;
+	int32 MachineSoundId = INDEX_NONE;
+	FCobbleFixedStepBinding FixedStepBinding;
+	// Simulated rotation of the gear in the holder at the last two fixed steps
+	FQuat PreviousGearRotation = FQuat::Identity;
+	FQuat CurrentGearRotation = FQuat::Identity;
+	FOnGearHolderPowerChanged PowerChangedEvent;
+	ACobblePaperCharacter* HighlightingPlayer = nullptr; // Local player this is highlighted for, null when not highlighted
+	FDelegateHandle HeldItemChangedHandle;
+};
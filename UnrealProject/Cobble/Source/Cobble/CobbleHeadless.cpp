@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleHeadless.h"
+#include "PaperFlipbookComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Misc/CommandLine.h"
+
+bool FCobbleHeadless::IsEnabled(const AActor* Actor)
+{
+	static const bool bHeadless = FParse::Param(FCommandLine::Get(), TEXT("CobbleHeadless"));
+	const UWorld* World = bHeadless && Actor != nullptr ? Actor->GetWorld() : nullptr;
+	return World != nullptr && World->IsGameWorld();
+}
+
+void FCobbleHeadless::SkipComponent(UActorComponent* Component)
+{
+	if (Component != nullptr && !Component->IsRegistered())
+		Component->bAutoRegister = false;
+}
+
+void FCobbleHeadless::HideComponent(USceneComponent* Component)
+{
+	if (Component == nullptr)
+		return;
+	Component->SetVisibility(false);
+	if (UPaperFlipbookComponent* Flipbook = Cast<UPaperFlipbookComponent>(Component))
+	{
+		Flipbook->Stop();
+		Flipbook->PrimaryComponentTick.bStartWithTickEnabled = false;
+		Flipbook->SetComponentTickEnabled(false);
+	}
+}
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UActorComponent;
+class USceneComponent;
+
+/*
+Headless simulation for running many game instances on one machine, see Scripts/Playtest. Enabled with -CobbleHeadless
+on the command line, next to -nullrhi -nosound. Actors call these from PreRegisterAllComponents, before their components
+register. SkipComponent is for components that are only there to be looked at: they never register, so they never tick,
+overlap or get a render proxy. HideComponent is for the ones play still needs, like the character's flipbook whose length
+times jumps and interactions, or a hose cable the hose end follows. They stay registered but hidden, and flipbooks stop.
+*/
+struct COBBLE_API FCobbleHeadless
+{
+	// Only true in game worlds, so the editor never strips anything
+	static bool IsEnabled(const AActor* Actor);
+	static void SkipComponent(UActorComponent* Component);
+	static void HideComponent(USceneComponent* Component);
+};
@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleHitchDetector.h"
+#include "CobbleSettings.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RHI.h"
+#include "Templates/Atomic.h"
+
+namespace
+{
+	struct FCobbleEventRecord
+	{
+		double Time = 0;
+		uint64 Frame = 0;
+		FName ObjectName;
+		float Value = 0;
+		ECobbleEvent Event = ECobbleEvent::LeverFlipped;
+	};
+
+	/*
+	Multiple producer ring buffer. Writers claim an index with one atomic increment and publish the slot by storing index + 1
+	in its sequence. The reader only keeps slots whose sequence matches before and after copying, so it never sees a torn
+	record. Old events are overwritten, nothing ever blocks.
+	*/
+	class FCobbleEventRing
+	{
+	public:
+		static const uint64 Capacity = 4096; // Power of two
+
+		void Push(const FCobbleEventRecord& Record)
+		{
+			const uint64 Index = NextIndex++;
+			FSlot& Slot = Slots[Index & (Capacity - 1)];
+			Slot.Sequence = 0;
+			Slot.Record = Record;
+			Slot.Sequence = Index + 1;
+		}
+
+		void CopyFromFrame(uint64 FirstFrame, TArray<FCobbleEventRecord>& OutRecords) const
+		{
+			const uint64 End = NextIndex.Load();
+			const uint64 Start = End > Capacity ? End - Capacity : 0;
+			for (uint64 Index = Start; Index < End; Index++)
+			{
+				const FSlot& Slot = Slots[Index & (Capacity - 1)];
+				if (Slot.Sequence.Load() != Index + 1)
+					continue;
+				const FCobbleEventRecord Record = Slot.Record;
+				if (Slot.Sequence.Load() == Index + 1 && Record.Frame >= FirstFrame)
+					OutRecords.Add(Record);
+			}
+		}
+
+	private:
+		struct FSlot
+		{
+			TAtomic<uint64> Sequence{ 0 };
+			FCobbleEventRecord Record;
+		};
+		FSlot Slots[Capacity];
+		TAtomic<uint64> NextIndex{ 0 };
+	};
+
+	struct FFrameTiming
+	{
+		uint64 Frame = 0;
+		float FrameMs = 0;
+		float GameThreadMs = 0;
+		float RenderThreadMs = 0;
+		float GPUMs = 0;
+	};
+
+	FCobbleEventRing EventRing;
+	// Only touched on the game thread
+	TArray<FFrameTiming> FrameTimings;
+	int32 NextFrameTiming = 0;
+	double LastEndFrameTime = 0;
+	double LastDumpTime = -MAX_dbl;
+	FDelegateHandle EndFrameHandle;
+
+	void OnEndFrame()
+	{
+		const double Now = FPlatformTime::Seconds();
+		const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+		if (LastEndFrameTime > 0 && FrameTimings.Num() > 0)
+		{
+			FFrameTiming& Timing = FrameTimings[NextFrameTiming];
+			NextFrameTiming = (NextFrameTiming + 1) % FrameTimings.Num();
+			Timing.Frame = GFrameCounter;
+			Timing.FrameMs = (Now - LastEndFrameTime) * 1000;
+			Timing.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+			Timing.RenderThreadMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+			Timing.GPUMs = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+
+			if (Timing.FrameMs > Settings->HitchBudgetMs && Now - LastDumpTime > Settings->HitchReportCooldown)
+			{
+				LastDumpTime = Now;
+				FCobbleHitchDetector::DumpReport(*FString::Printf(TEXT("Frame took %.1f ms, budget is %.1f ms"), Timing.FrameMs, Settings->HitchBudgetMs));
+			}
+		}
+		LastEndFrameTime = Now;
+	}
+
+	FAutoConsoleCommand HitchDumpCommand(
+		TEXT("Cobble.HitchDump"),
+		TEXT("Writes a hitch report with the recent gameplay events and frame timings."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FCobbleHitchDetector::DumpReport(TEXT("Requested with Cobble.HitchDump"));
+		}));
+}
+
+void FCobbleHitchDetector::Startup()
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	if (!Settings->bEnableHitchDetector || IsRunningCommandlet())
+		return;
+	FrameTimings.SetNum(FMath::Max(Settings->HitchReportFrames, 1));
+	NextFrameTiming = 0;
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&OnEndFrame);
+}
+
+void FCobbleHitchDetector::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	EndFrameHandle.Reset();
+}
+
+void FCobbleHitchDetector::RecordEvent(ECobbleEvent Event, const UObject* Object, float Value)
+{
+	FCobbleEventRecord Record;
+	Record.Time = FPlatformTime::Seconds();
+	Record.Frame = GFrameCounter;
+	Record.ObjectName = Object != nullptr ? Object->GetFName() : NAME_None;
+	Record.Value = Value;
+	Record.Event = Event;
+	EventRing.Push(Record);
+}
+
+const TCHAR* FCobbleHitchDetector::GetEventName(ECobbleEvent Event)
+{
+	switch (Event)
+	{
+	case ECobbleEvent::LeverFlipped: return TEXT("LeverFlipped");
+	case ECobbleEvent::CableGravityChanged: return TEXT("CableGravityChanged");
+	case ECobbleEvent::GearTeleported: return TEXT("GearTeleported");
+	case ECobbleEvent::GearPlacedInHolder: return TEXT("GearPlacedInHolder");
+	case ECobbleEvent::PlatformPowerChanged: return TEXT("PlatformPowerChanged");
+	case ECobbleEvent::PlatformReversed: return TEXT("PlatformReversed");
+	case ECobbleEvent::LandedTimerStarted: return TEXT("LandedTimerStarted");
+	case ECobbleEvent::JumpTimerStarted: return TEXT("JumpTimerStarted");
+	case ECobbleEvent::InteractTimerStarted: return TEXT("InteractTimerStarted");
+	case ECobbleEvent::BoxGrabbed: return TEXT("BoxGrabbed");
+	case ECobbleEvent::BoxSettled: return TEXT("BoxSettled");
+	case ECobbleEvent::FixedStepsDropped: return TEXT("FixedStepsDropped");
+	case ECobbleEvent::PhysicsRegionRestored: return TEXT("PhysicsRegionRestored");
+	default: return TEXT("Unknown");
+	}
+}
+
+void FCobbleHitchDetector::DumpReport(const TCHAR* Reason)
+{
+	const uint64 FirstFrame = GFrameCounter > (uint64)FrameTimings.Num() ? GFrameCounter - FrameTimings.Num() : 0;
+	TArray<FCobbleEventRecord> Events;
+	EventRing.CopyFromFrame(FirstFrame, Events);
+	Events.Sort([](const FCobbleEventRecord& A, const FCobbleEventRecord& B) { return A.Time < B.Time; });
+
+	const double Now = FPlatformTime::Seconds();
+	FString Report = FString::Printf(TEXT("# %s\n# Frame %llu\nFrame,FrameMs,GameThreadMs,RenderThreadMs,GPUMs\n"), Reason, GFrameCounter);
+	for (int32 i = 0; i < FrameTimings.Num(); i++)
+	{
+		// Oldest first
+		const FFrameTiming& Timing = FrameTimings[(NextFrameTiming + i) % FrameTimings.Num()];
+		if (Timing.Frame != 0)
+			Report += FString::Printf(TEXT("%llu,%.2f,%.2f,%.2f,%.2f\n"), Timing.Frame, Timing.FrameMs, Timing.GameThreadMs, Timing.RenderThreadMs, Timing.GPUMs);
+	}
+	Report += TEXT("\nFrame,SecondsAgo,Event,Object,Value\n");
+	for (const FCobbleEventRecord& Record : Events)
+	{
+		Report += FString::Printf(TEXT("%llu,%.4f,%s,%s,%g\n"), Record.Frame, Now - Record.Time, GetEventName(Record.Event), *Record.ObjectName.ToString(), Record.Value);
+	}
+
+	// Writing on the game thread would make the hitch worse
+	const FString Filename = FPaths::ProjectSavedDir() / TEXT("Hitches") / FString::Printf(TEXT("Hitch_%s_F%llu.csv"), *FDateTime::Now().ToString(), GFrameCounter);
+	UE_LOG(LogTemp, Warning, TEXT("%s, writing hitch report %s"), Reason, *Filename);
+	Async(EAsyncExecution::ThreadPool, [Report = MoveTemp(Report), Filename]()
+	{
+		FFileHelper::SaveStringToFile(Report, *Filename);
+	});
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Gameplay events worth knowing about when a frame is slow
+enum class ECobbleEvent : uint8
+{
+	LeverFlipped,
+	CableGravityChanged,
+	GearTeleported,
+	GearPlacedInHolder,
+	PlatformPowerChanged,
+	PlatformReversed,
+	LandedTimerStarted,
+	JumpTimerStarted,
+	InteractTimerStarted,
+	BoxGrabbed,
+	BoxSettled,
+	FixedStepsDropped,
+	PhysicsRegionRestored
+};
+
+/*
+Records cheap time stamped gameplay events into a fixed size lock free ring buffer from any thread, and watches the frame time.
+When a frame takes longer than HitchBudgetMs (Project Settings > Cobble > Hitches) the events and timings of the last
+HitchReportFrames frames are written to Saved/Hitches/Hitch_<date>_F<frame>.csv on a background thread.
+Cobble.HitchDump writes a report for the current frame on demand.
+*/
+struct COBBLE_API FCobbleHitchDetector
+{
+	// Called by the module
+	static void Startup();
+	static void Shutdown();
+
+	// Safe to call from any thread. Value is whatever is useful for the event, e.g. the new cable gravity.
+	static void RecordEvent(ECobbleEvent Event, const UObject* Object, float Value = 0);
+
+	static const TCHAR* GetEventName(ECobbleEvent Event);
+	static void DumpReport(const TCHAR* Reason);
+};
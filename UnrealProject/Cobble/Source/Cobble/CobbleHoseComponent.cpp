@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleHoseComponent.h"
+#include "CobblePaperCharacter.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobbleMachineAudio.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleTelemetry.h"
+#include "Net/UnrealNetwork.h"
+
+UCobbleHoseComponent::UCobbleHoseComponent()
+{
+	COBBLE_LLM_SCOPE(Hoses);
+	SetIsReplicatedByDefault(true);
+	bEnableCollision = true;
+	SetGenerateOverlapEvents(true);
+	SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+	if (bUseGoodCable)
+	{
+		SubstepTime = 0.005;
+		NumSegments = 20;
+		SolverIterations = 16;
+		bEnableStiffness = true;
+	}
+}
+
+void UCobbleHoseComponent::BeginPlay()
+{
+	COBBLE_LLM_SCOPE(Hoses);
+	Super::BeginPlay();
+	FCobbleTelemetry::AddToGauge(ECobbleGauge::HosesSimulating, 1);
+	USceneComponent* SoundAnchor = EndCollision != nullptr ? (USceneComponent*)EndCollision : this;
+	ACobbleMachineAudio* MachineAudio = DragLoopEvent != nullptr ? ACobbleMachineAudio::Get(GetWorld()) : nullptr;
+	if (MachineAudio != nullptr)
+	{
+		MachineSoundId = MachineAudio->RegisterSource(SoundAnchor, DragLoopEvent, DragLoopLoudness);
+		MachineAudio->SetSourceActive(MachineSoundId, IsHeld());
+	}
+}
+
+void UCobbleHoseComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(GetWorld(), false))
+		MachineAudio->UnregisterSource(MachineSoundId);
+	MachineSoundId = INDEX_NONE;
+	FCobbleTelemetry::AddToGauge(ECobbleGauge::HosesSimulating, -1);
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCobbleHoseComponent::PickUp(ACobblePaperCharacter* Interactor)
+{
+	// The owner is what the character holds, so dropping it comes back here through the owner's Drop
+	if (Interactor != nullptr && !IsHeld() && Interactor->PickUpItem(GetOwner()))
+	{
+		FCobbleNet::MarkStateChanged(GetOwner());
+		AttachedCharacter = Interactor;
+		OnRep_AttachedCharacter();
+	}
+}
+
+void UCobbleHoseComponent::Drop()
+{
+	FCobbleNet::MarkStateChanged(GetOwner());
+	AttachedCharacter = nullptr;
+	OnRep_AttachedCharacter();
+}
+
+bool UCobbleHoseComponent::IsEndInReach(const AActor* Actor) const
+{
+	return EndCollision != nullptr && EndCollision->IsOverlappingActor(Actor);
+}
+
+void UCobbleHoseComponent::OnRep_AttachedCharacter()
+{
+	if (ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(GetWorld(), false))
+		MachineAudio->SetSourceActive(MachineSoundId, IsHeld());
+	// The loose end goes wherever the player carries it, so the hose can't be pruned with the region it belongs to
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->SetActorAwake(GetOwner(), IsHeld());
+	if (AttachedCharacter != nullptr)
+	{
+		SetAttachEndTo(AttachedCharacter, NAME_None, NAME_None);
+		bAttachEnd = true;
+	}
+	else
+	{
+		AttachEndTo.OtherActor = nullptr;
+		bAttachEnd = false;
+	}
+}
+
+void UCobbleHoseComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	COBBLE_LLM_SCOPE(Hoses);
+	COBBLE_TELEMETRY_SCOPE(Hoses);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (EndCollision != nullptr)
+	{
+		TArray<FVector> ParticleLocs;
+		GetCableParticleLocations(ParticleLocs);
+		if (ParticleLocs.Num() > 0)
+			EndCollision->SetWorldLocation(ParticleLocs.Last());
+	}
+	if (AttachEndTo.OtherActor != nullptr)
+	{
+		CableLength = (AttachEndTo.OtherActor->GetActorLocation() - GetComponentLocation()).Size() + 50;
+	}
+}
+
+void UCobbleHoseComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(UCobbleHoseComponent, AttachedCharacter);
+}
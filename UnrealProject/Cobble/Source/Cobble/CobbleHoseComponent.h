@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CableComponent.h"
+#include "CobbleHoseComponent.generated.h"
+
+/**
+ * A hose the player can pick up by its loose end and drag around. The owning actor implements IPickupInterface and
+ * forwards Drop here, and gives the hose a collision box that follows the loose end so players can reach it.
+ */
+UCLASS(ClassGroup = Cobble, meta = (BlueprintSpawnableComponent))
+class COBBLE_API UCobbleHoseComponent : public UCableComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCobbleHoseComponent();
+
+	void PickUp(class ACobblePaperCharacter* Interactor);
+	void Drop();
+	bool IsHeld() const { return AttachedCharacter != nullptr; }
+	// Collision moved to the loose end every tick, set by the owner before play
+	void SetEndCollision(class UPrimitiveComponent* InEndCollision) { EndCollision = InEndCollision; }
+	bool IsEndInReach(const AActor* Actor) const;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+public:
+	UPROPERTY(EditAnywhere, Category = Hose)
+	float CableStartOffset = 300;
+	UPROPERTY(EditAnywhere, Category = Hose)
+	bool bUseGoodCable = true;
+	// Loops while a player drags the hose, played through ACobbleMachineAudio
+	UPROPERTY(EditAnywhere, Category = Audio)
+	class UAkAudioEvent* DragLoopEvent = nullptr;
+	UPROPERTY(EditAnywhere, Category = Audio)
+	float DragLoopLoudness = 0.5f;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UFUNCTION()
+	void OnRep_AttachedCharacter();
+
+private:
+	// Character carrying the end of the hose, replicated so every machine attaches the cable locally
+	UPROPERTY(ReplicatedUsing = OnRep_AttachedCharacter)
+	AActor* AttachedCharacter = nullptr;
+	UPROPERTY(Transient)
+	class UPrimitiveComponent* EndCollision = nullptr;
+	int32 MachineSoundId = INDEX_NONE;
+};
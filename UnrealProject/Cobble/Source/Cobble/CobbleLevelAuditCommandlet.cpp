@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleLevelAuditCommandlet.h"
+#include "CobbleMemory.h"
+#include "AssetRegistryModule.h"
+#include "CableComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SplineComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCobbleAudit, Log, All);
+
+namespace
+{
+	struct FClassCost
+	{
+		int32 Instances = 0;
+		int32 Components = 0;
+		int32 TickingActors = 0;
+		int32 TickingComponents = 0;
+		int32 OverlapComponents = 0;
+		int32 CableSegments = 0;
+		int32 SplinePoints = 0;
+		int64 EstimatedBytes = 0;
+	};
+
+	void AddActorCost(AActor* Actor, FClassCost& Cost)
+	{
+		Cost.Instances++;
+		Cost.EstimatedBytes += FCobbleMemory::EstimateActorBytes(Actor);
+		if (Actor->PrimaryActorTick.bCanEverTick && Actor->PrimaryActorTick.bStartWithTickEnabled)
+			Cost.TickingActors++;
+
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component == nullptr)
+				continue;
+			Cost.Components++;
+			if (Component->PrimaryComponentTick.bCanEverTick && Component->PrimaryComponentTick.bStartWithTickEnabled)
+				Cost.TickingComponents++;
+			if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component))
+			{
+				if (Primitive->GetGenerateOverlapEvents() || Primitive->GetCollisionProfileName() == TEXT("OverlapAll"))
+					Cost.OverlapComponents++;
+			}
+			if (UCableComponent* Cable = Cast<UCableComponent>(Component))
+				Cost.CableSegments += Cable->NumSegments;
+			if (USplineComponent* Spline = Cast<USplineComponent>(Component))
+				Cost.SplinePoints += Spline->GetNumberOfSplinePoints();
+		}
+	}
+}
+
+UCobbleLevelAuditCommandlet::UCobbleLevelAuditCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCobbleLevelAuditCommandlet::Main(const FString& Params)
+{
+	FString OutputDir = FPaths::ProjectSavedDir() / TEXT("Audit");
+	FParse::Value(*Params, TEXT("Output="), OutputDir);
+
+	int32 NumViolations = 0;
+	auto CheckBudget = [&NumViolations](const FString& MapName, const FString& ClassName, const TCHAR* Metric, int64 Value, int64 Limit)
+	{
+		if (Limit > 0 && Value > Limit)
+		{
+			UE_LOG(LogCobbleAudit, Error, TEXT("%s: %s %s is %lld, budget is %lld"), *MapName, *ClassName, Metric, Value, Limit);
+			NumViolations++;
+		}
+	};
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FString Csv = TEXT("Map,Class,Instances,Components,TickingActors,TickingComponents,OverlapComponents,CableSegments,SplinePoints,EstimatedBytes\n");
+
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart(TEXT("Maps"));
+	for (const FString& MapPackageName : FindMapPackages(Params))
+	{
+		UWorld* World = LoadMap(MapPackageName);
+		if (World == nullptr)
+		{
+			UE_LOG(LogCobbleAudit, Error, TEXT("Could not load %s"), *MapPackageName);
+			NumViolations++;
+			continue;
+		}
+
+		TMap<FString, FClassCost> Costs;
+		for (ULevel* Level : World->GetLevels())
+		{
+			for (AActor* Actor : Level->Actors)
+			{
+				UClass* CobbleClass = Actor != nullptr && !Actor->IsPendingKill() ? GetCobbleNativeClass(Actor->GetClass()) : nullptr;
+				if (CobbleClass != nullptr)
+				{
+					AddActorCost(Actor, Costs.FindOrAdd(CobbleClass->GetName()));
+				}
+			}
+		}
+		Costs.KeySort(TLess<FString>());
+
+		const FString MapName = FPackageName::GetShortName(MapPackageName);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Map"), MapName);
+		Writer->WriteObjectStart(TEXT("Classes"));
+		for (const TPair<FString, FClassCost>& Pair : Costs)
+		{
+			const FClassCost& Cost = Pair.Value;
+			Writer->WriteObjectStart(Pair.Key);
+			Writer->WriteValue(TEXT("Instances"), Cost.Instances);
+			Writer->WriteValue(TEXT("Components"), Cost.Components);
+			Writer->WriteValue(TEXT("TickingActors"), Cost.TickingActors);
+			Writer->WriteValue(TEXT("TickingComponents"), Cost.TickingComponents);
+			Writer->WriteValue(TEXT("OverlapComponents"), Cost.OverlapComponents);
+			Writer->WriteValue(TEXT("CableSegments"), Cost.CableSegments);
+			Writer->WriteValue(TEXT("SplinePoints"), Cost.SplinePoints);
+			Writer->WriteValue(TEXT("EstimatedBytes"), Cost.EstimatedBytes);
+			Writer->WriteObjectEnd();
+
+			Csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%d,%d,%d,%lld\n"), *MapName, *Pair.Key, Cost.Instances, Cost.Components, Cost.TickingActors,
+				Cost.TickingComponents, Cost.OverlapComponents, Cost.CableSegments, Cost.SplinePoints, Cost.EstimatedBytes);
+
+			for (const FCobbleAuditBudget& Budget : Budgets)
+			{
+				if (Budget.ClassName == Pair.Key)
+				{
+					CheckBudget(MapName, Pair.Key, TEXT("instances"), Cost.Instances, Budget.MaxInstances);
+					CheckBudget(MapName, Pair.Key, TEXT("ticking components"), Cost.TickingComponents, Budget.MaxTickingComponents);
+					CheckBudget(MapName, Pair.Key, TEXT("overlap components"), Cost.OverlapComponents, Budget.MaxOverlapComponents);
+					CheckBudget(MapName, Pair.Key, TEXT("cable segments"), Cost.CableSegments, Budget.MaxCableSegments);
+					CheckBudget(MapName, Pair.Key, TEXT("estimated bytes"), Cost.EstimatedBytes, Budget.MaxEstimatedBytes);
+				}
+			}
+		}
+		Writer->WriteObjectEnd();
+		Writer->WriteObjectEnd();
+
+		UE_LOG(LogCobbleAudit, Display, TEXT("Audited %s (%d Cobble classes)"), *MapName, Costs.Num());
+		UnloadMap(World);
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteValue(TEXT("BudgetViolations"), NumViolations);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FFileHelper::SaveStringToFile(Json, *(OutputDir / TEXT("LevelAudit.json")));
+	FFileHelper::SaveStringToFile(Csv, *(OutputDir / TEXT("LevelAudit.csv")));
+	UE_LOG(LogCobbleAudit, Display, TEXT("Wrote level audit to %s with %d budget violations"), *OutputDir, NumViolations);
+	return NumViolations > 0 ? 1 : 0;
+}
+
+TArray<FString> UCobbleLevelAuditCommandlet::FindMapPackages(const FString& Params)
+{
+	TArray<FString> MapPackages;
+	FString MapList;
+	if (FParse::Value(*Params, TEXT("Maps="), MapList, false))
+	{
+		TArray<FString> MapNames;
+		MapList.ParseIntoArray(MapNames, TEXT(","));
+		for (const FString& MapName : MapNames)
+		{
+			MapPackages.Add(MapName.StartsWith(TEXT("/")) ? MapName : TEXT("/Game/Levels/") + MapName);
+		}
+		return MapPackages;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByPath(TEXT("/Game/Levels"), Assets, true);
+	for (const FAssetData& Asset : Assets)
+	{
+		if (Asset.AssetClass == UWorld::StaticClass()->GetFName())
+			MapPackages.Add(Asset.PackageName.ToString());
+	}
+	MapPackages.Sort();
+	return MapPackages;
+}
+
+UWorld* UCobbleLevelAuditCommandlet::LoadMap(const FString& MapPackageName)
+{
+	UPackage* Package = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	UWorld* World = Package != nullptr ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (World == nullptr)
+		return nullptr;
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.RequiresHitProxies(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(false)
+			.SetTransactional(false));
+	}
+#if WITH_EDITOR
+	World->LoadSecondaryLevels(true);
+#endif
+	// Registering components gives bounds and overlaps the same state they have in game
+	World->UpdateWorldComponents(true, false);
+	return World;
+}
+
+void UCobbleLevelAuditCommandlet::UnloadMap(UWorld* World)
+{
+	World->RemoveFromRoot();
+	World->DestroyWorld(false);
+	CollectGarbage(RF_NoFlags);
+}
+
+bool UCobbleLevelAuditCommandlet::SaveAsset(UObject* Asset)
+{
+	bool bSaved = false;
+#if WITH_EDITOR
+	UPackage* Package = Asset->GetOutermost();
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+	bSaved = UPackage::SavePackage(Package, Asset, RF_Public | RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError);
+#endif
+	return bSaved;
+}
+
+UClass* UCobbleLevelAuditCommandlet::GetCobbleNativeClass(UClass* Class)
+{
+	static const FName CobblePackageName(TEXT("/Script/Cobble"));
+	for (; Class != nullptr; Class = Class->GetSuperClass())
+	{
+		if (Class->HasAnyClassFlags(CLASS_Native))
+			return Class->GetOutermost()->GetFName() == CobblePackageName ? Class : nullptr;
+	}
+	return nullptr;
+}
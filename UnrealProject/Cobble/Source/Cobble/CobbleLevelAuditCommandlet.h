@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CobbleLevelAuditCommandlet.generated.h"
+
+/*
+Limits for one Cobble class in one map. Zero means no limit. Subclasses (blueprints) count towards their native Cobble class.
+*/
+USTRUCT()
+struct FCobbleAuditBudget
+{
+	GENERATED_BODY()
+
+	// Native class name without the prefix, e.g. Gear, Lever or MovingPlatform
+	UPROPERTY(config)
+	FString ClassName;
+	UPROPERTY(config)
+	int32 MaxInstances = 0;
+	UPROPERTY(config)
+	int32 MaxTickingComponents = 0;
+	UPROPERTY(config)
+	int32 MaxOverlapComponents = 0;
+	UPROPERTY(config)
+	int32 MaxCableSegments = 0;
+	UPROPERTY(config)
+	int64 MaxEstimatedBytes = 0;
+};
+
+/**
+ * Loads maps and reports what each Cobble class costs in them: instances, components, ticking components, components that
+ * generate overlaps, cable segments, spline points and estimated memory. Writes LevelAudit.json and LevelAudit.csv and
+ * returns 1 if any budget in [/Script/Cobble.CobbleLevelAuditCommandlet] is exceeded, so it can gate the build pipeline.
+ *
+ * UE4Editor-Cmd Cobble.uproject -run=CobbleLevelAudit -unattended -nopause -nullrhi [-Maps=Lvl_A,Lvl_B] [-Output=Dir]
+ * Without -Maps every map under /Game/Levels is audited. Output defaults to Saved/Audit.
+ */
+UCLASS(config = Game)
+class COBBLE_API UCobbleLevelAuditCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCobbleLevelAuditCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+	// Every map under /Game/Levels, or the maps named in -Maps=. Shared with the other Cobble commandlets.
+	static TArray<FString> FindMapPackages(const FString& Params);
+	// Loads a map and its sublevels with components registered. Call UnloadMap when finished.
+	static UWorld* LoadMap(const FString& MapPackageName);
+	static void UnloadMap(UWorld* World);
+	// Saves the asset's package to its file under Content, false if it couldn't be written
+	static bool SaveAsset(UObject* Asset);
+	// The Cobble native class an actor's class derives from, nullptr for actors that aren't Cobble's
+	static UClass* GetCobbleNativeClass(UClass* Class);
+
+public:
+	UPROPERTY(config)
+	TArray<FCobbleAuditBudget> Budgets;
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleLevelExit.h"
+#include "CobbleLevelTransitions.h"
+#include "CobblePaperCharacter.h"
+#include "Components/BoxComponent.h"
+#include "Engine/GameInstance.h"
+
+ACobbleLevelExit::ACobbleLevelExit()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	Trigger = CreateDefaultSubobject<UBoxComponent>(TEXT("Trigger"));
+	Trigger->SetBoxExtent(FVector(100, 500, 500));
+	Trigger->SetCollisionProfileName("Trigger");
+	Trigger->SetHiddenInGame(true);
+	SetRootComponent(Trigger);
+}
+
+void ACobbleLevelExit::BeginPlay()
+{
+	Super::BeginPlay();
+	Trigger->OnComponentBeginOverlap.AddDynamic(this, &ACobbleLevelExit::OnTriggerBeginOverlap);
+	if (UCobbleLevelTransitions* Transitions = UGameInstance::GetSubsystem<UCobbleLevelTransitions>(GetGameInstance()))
+	{
+		Transitions->RegisterExit(this);
+	}
+}
+
+void ACobbleLevelExit::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCobbleLevelTransitions* Transitions = UGameInstance::GetSubsystem<UCobbleLevelTransitions>(GetGameInstance()))
+	{
+		Transitions->UnregisterExit(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACobbleLevelExit::OnTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (!HasAuthority() || !OtherActor->IsA<ACobblePaperCharacter>())
+		return;
+	if (UCobbleLevelTransitions* Transitions = UGameInstance::GetSubsystem<UCobbleLevelTransitions>(GetGameInstance()))
+	{
+		Transitions->TravelTo(GetWorld(), NextLevel);
+	}
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleLevelExit.generated.h"
+
+/**
+ * End of a level. Once a player gets within LevelPreloadDistance along the scroll axis the next map starts loading in the
+ * background, and when a player walks into the trigger the server seamless travels everyone there. See UCobbleLevelTransitions.
+ */
+UCLASS()
+class COBBLE_API ACobbleLevelExit : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleLevelExit();
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Level Transitions")
+	TSoftObjectPtr<UWorld> NextLevel;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(VisibleAnywhere)
+	class UBoxComponent* Trigger;
+
+private:
+	UFUNCTION()
+	void OnTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleLevelManifest.h"
+#include "CobbleSettings.h"
+#include "Gear.h"
+#include "GearHolder.h"
+#include "Lever.h"
+#include "MoveableBox.h"
+#include "MovingPlatform.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Components/SplineComponent.h"
+#include "Misc/PackageName.h"
+
+namespace
+{
+	// Rounded so float error between the baking editor and the game doesn't count as a change
+	uint32 HashVector(uint32 Hash, const FVector& Vector, float Precision)
+	{
+		const FIntVector Rounded(FMath::RoundToInt(Vector.X / Precision), FMath::RoundToInt(Vector.Y / Precision), FMath::RoundToInt(Vector.Z / Precision));
+		return FCrc::MemCrc32(&Rounded, sizeof(Rounded), Hash);
+	}
+
+	uint32 HashTransform(uint32 Hash, const FTransform& Transform)
+	{
+		Hash = HashVector(Hash, Transform.GetLocation(), 0.1f);
+		Hash = HashVector(Hash, Transform.GetRotation().Euler(), 0.01f);
+		return HashVector(Hash, Transform.GetScale3D(), 0.001f);
+	}
+}
+
+FString UCobbleLevelManifest::GetPackageName(const ULevel* Level)
+{
+	const FString LevelName = UWorld::RemovePIEPrefix(FPackageName::GetShortName(Level->GetOutermost()));
+	return GetDefault<UCobbleSettings>()->LevelManifestPath / (LevelName + TEXT("_Manifest"));
+}
+
+FString UCobbleLevelManifest::GetObjectPath(const ULevel* Level)
+{
+	const FString PackageName = GetPackageName(Level);
+	return PackageName + TEXT(".") + FPackageName::GetShortName(PackageName);
+}
+
+bool UCobbleLevelManifest::GetKind(const AActor* Actor, ECobbleManifestKind& OutKind)
+{
+	if (Actor->IsA<ALever>())
+		OutKind = ECobbleManifestKind::Lever;
+	else if (Actor->IsA<AGear>())
+		OutKind = ECobbleManifestKind::Gear;
+	else if (Actor->IsA<AMoveableBox>())
+		OutKind = ECobbleManifestKind::MoveableBox;
+	else if (Actor->IsA<AInteractable>())
+		OutKind = ECobbleManifestKind::Interactable;
+	else if (Actor->IsA<AMovingPlatform>())
+		OutKind = ECobbleManifestKind::MovingPlatform;
+	else if (Actor->IsA<AGearActivatedActor>())
+		OutKind = ECobbleManifestKind::GearActivated;
+	else if (Actor->IsA<AGearHolder>())
+		OutKind = ECobbleManifestKind::GearHolder;
+	else
+		return false;
+	return true;
+}
+
+uint32 UCobbleLevelManifest::GetFingerprint(const AActor* Actor)
+{
+	// The location is checked on its own, with a tolerance
+	FTransform ActorTransform = Actor->GetActorTransform();
+	ActorTransform.SetLocation(FVector::ZeroVector);
+	uint32 Hash = HashTransform(0, ActorTransform);
+	// Summed so the order of the component set doesn't matter. Only components saved with the actor count, editor only ones
+	// don't exist in a game and ones added at runtime weren't there when baking.
+	uint32 ComponentsHash = 0;
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		if (Component == nullptr || Component->IsEditorOnly()
+			|| (!Component->HasAnyFlags(RF_DefaultSubObject) && Component->CreationMethod == EComponentCreationMethod::Native))
+		{
+			continue;
+		}
+		uint32 ComponentHash = FCrc::StrCrc32(*Component->GetName());
+		const USceneComponent* SceneComponent = Cast<USceneComponent>(Component);
+		if (SceneComponent != nullptr && SceneComponent != Actor->GetRootComponent())
+			ComponentHash = HashTransform(ComponentHash, SceneComponent->GetRelativeTransform());
+		ComponentsHash += ComponentHash;
+	}
+	Hash = FCrc::MemCrc32(&ComponentsHash, sizeof(ComponentsHash), Hash);
+	const AMovingPlatform* Platform = Cast<AMovingPlatform>(Actor);
+	if (const USplineComponent* Spline = Platform != nullptr ? Platform->GetPath() : nullptr)
+	{
+		const int32 NumPoints = Spline->GetNumberOfSplinePoints();
+		Hash = FCrc::MemCrc32(&NumPoints, sizeof(NumPoints), Hash);
+		if (NumPoints > 0)
+		{
+			Hash = HashVector(Hash, Spline->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::Local), 0.1f);
+			Hash = HashVector(Hash, Spline->GetLocationAtSplinePoint(NumPoints - 1, ESplineCoordinateSpace::Local), 0.1f);
+		}
+	}
+	return Hash;
+}
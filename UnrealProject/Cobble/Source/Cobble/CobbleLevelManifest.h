@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "CobbleLevelManifest.generated.h"
+
+class ULevel;
+
+UENUM()
+enum class ECobbleManifestKind : uint8
+{
+	Interactable,
+	Gear,
+	MoveableBox,
+	Lever,
+	GearHolder,
+	GearActivated,
+	MovingPlatform
+};
+
+USTRUCT()
+struct FCobbleManifestActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Name;
+	UPROPERTY()
+	ECobbleManifestKind Kind = ECobbleManifestKind::Interactable;
+	// Where the actor was when baked. An actor found anywhere else isn't bound and initializes itself.
+	UPROPERTY()
+	FVector Location = FVector::ZeroVector;
+	// Of every component, in world space
+	UPROPERTY()
+	FBox Bounds = FBox(ForceInit);
+	// UCobbleLevelManifest::GetFingerprint when baked. An actor with a different one isn't bound.
+	UPROPERTY()
+	uint32 Fingerprint = 0;
+};
+
+// A gear holder and the gear activated actor it powers, indices into Actors
+USTRUCT()
+struct FCobbleManifestPower
+{
+	GENERATED_BODY()
+
+	// The actor owning the holder component
+	UPROPERTY()
+	int32 Holder = INDEX_NONE;
+	// Name of the holder component on that actor
+	UPROPERTY()
+	FName Component;
+	// INDEX_NONE for a holder that powers nothing
+	UPROPERTY()
+	int32 Powered = INDEX_NONE;
+};
+
+// A moving platform's spline sampled at even distances
+USTRUCT()
+struct FCobbleManifestPath
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Actor = INDEX_NONE;
+	UPROPERTY()
+	float Length = 0;
+	UPROPERTY()
+	float Spacing = 0;
+	// World locations every Spacing along the spline, the last one at Length
+	UPROPERTY()
+	TArray<FVector> Points;
+};
+
+USTRUCT()
+struct FCobbleManifestLever
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Actor = INDEX_NONE;
+	UPROPERTY()
+	bool bFlippedToTheLeft = false;
+	UPROPERTY()
+	float HoseGravityScale = 1;
+};
+
+/**
+ * The static puzzle structure of one level, baked by UCobbleLevelManifestCommandlet so the level's actors don't each work it
+ * out again at level start: the puzzle actors and their bounds, which gear holder powers what, the moving platform paths
+ * and the levers' starting state. ACobbleManifestBinding applies it to the whole level in one pass.
+ *
+ * Saved as <LevelManifestPath>/<Level>_Manifest, one per level package, sublevels included.
+ */
+UCLASS()
+class COBBLE_API UCobbleLevelManifest : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Package and object path of the level's manifest, without the PIE prefix
+	static FString GetPackageName(const ULevel* Level);
+	static FString GetObjectPath(const ULevel* Level);
+	// False for actors a manifest doesn't cover
+	static bool GetKind(const AActor* Actor, ECobbleManifestKind& OutKind);
+	// Hash of what the baked entries depend on besides the actor's location: its rotation and scale, its components and
+	// where they sit on the actor, and a platform's spline point count and end points
+	static uint32 GetFingerprint(const AActor* Actor);
+
+public:
+	UPROPERTY()
+	TArray<FCobbleManifestActor> Actors;
+	UPROPERTY()
+	TArray<FCobbleManifestPower> Powers;
+	UPROPERTY()
+	TArray<FCobbleManifestPath> Paths;
+	UPROPERTY()
+	TArray<FCobbleManifestLever> Levers;
+};
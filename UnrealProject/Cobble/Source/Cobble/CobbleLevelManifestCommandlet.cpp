@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleLevelManifestCommandlet.h"
+#include "CobbleLevelAuditCommandlet.h"
+#include "CobbleLevelManifest.h"
+#include "CobbleGearHolderComponent.h"
+#include "GearActivatedActor.h"
+#include "Lever.h"
+#include "MovingPlatform.h"
+#include "AssetRegistryModule.h"
+#include "Components/SplineComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCobbleManifest, Log, All);
+
+UCobbleLevelManifestCommandlet::UCobbleLevelManifestCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCobbleLevelManifestCommandlet::Main(const FString& Params)
+{
+	FString OutputDir = FPaths::ProjectSavedDir() / TEXT("Manifests");
+	FParse::Value(*Params, TEXT("Output="), OutputDir);
+	const bool bDryRun = FParse::Param(*Params, TEXT("DryRun"));
+
+	int32 NumFailed = 0;
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("DryRun"), bDryRun);
+	Writer->WriteArrayStart(TEXT("Levels"));
+	for (const FString& MapPackageName : UCobbleLevelAuditCommandlet::FindMapPackages(Params))
+	{
+		UWorld* World = UCobbleLevelAuditCommandlet::LoadMap(MapPackageName);
+		if (World == nullptr)
+		{
+			UE_LOG(LogCobbleManifest, Error, TEXT("Could not load %s"), *MapPackageName);
+			NumFailed++;
+			continue;
+		}
+
+		for (ULevel* Level : World->GetLevels())
+		{
+			if (Level == nullptr)
+				continue;
+			const FString PackageName = UCobbleLevelManifest::GetPackageName(Level);
+			const FString AssetName = FPackageName::GetShortName(PackageName);
+			UCobbleLevelManifest* Manifest = nullptr;
+			bool bCreated = false;
+			if (bDryRun)
+			{
+				Manifest = NewObject<UCobbleLevelManifest>(GetTransientPackage());
+			}
+			else
+			{
+				UPackage* Package = CreatePackage(nullptr, *PackageName);
+				Package->FullyLoad();
+				Manifest = FindObject<UCobbleLevelManifest>(Package, *AssetName);
+				bCreated = Manifest == nullptr;
+				if (bCreated)
+					Manifest = NewObject<UCobbleLevelManifest>(Package, *AssetName, RF_Public | RF_Standalone);
+			}
+			BakeLevel(Level, Manifest);
+
+			int32 NumPathPoints = 0;
+			for (const FCobbleManifestPath& Path : Manifest->Paths)
+				NumPathPoints += Path.Points.Num();
+			bool bSaved = false;
+			if (!bDryRun)
+			{
+				Manifest->MarkPackageDirty();
+				if (bCreated)
+					FAssetRegistryModule::AssetCreated(Manifest);
+				bSaved = UCobbleLevelAuditCommandlet::SaveAsset(Manifest);
+				if (!bSaved)
+				{
+					UE_LOG(LogCobbleManifest, Error, TEXT("Could not save %s"), *PackageName);
+					NumFailed++;
+				}
+			}
+
+			Writer->WriteObjectStart();
+			Writer->WriteValue(TEXT("Map"), FPackageName::GetShortName(MapPackageName));
+			Writer->WriteValue(TEXT("Level"), FPackageName::GetShortName(Level->GetOutermost()));
+			Writer->WriteValue(TEXT("Manifest"), PackageName);
+			Writer->WriteValue(TEXT("Actors"), Manifest->Actors.Num());
+			Writer->WriteValue(TEXT("Powers"), Manifest->Powers.Num());
+			Writer->WriteValue(TEXT("Paths"), Manifest->Paths.Num());
+			Writer->WriteValue(TEXT("PathPoints"), NumPathPoints);
+			Writer->WriteValue(TEXT("Levers"), Manifest->Levers.Num());
+			Writer->WriteValue(TEXT("Saved"), bSaved);
+			Writer->WriteObjectEnd();
+			UE_LOG(LogCobbleManifest, Display, TEXT("%s: %d actors, %d powers, %d paths (%d points), %d levers"), *AssetName,
+				Manifest->Actors.Num(), Manifest->Powers.Num(), Manifest->Paths.Num(), NumPathPoints, Manifest->Levers.Num());
+		}
+		UCobbleLevelAuditCommandlet::UnloadMap(World);
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteValue(TEXT("Failed"), NumFailed);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FFileHelper::SaveStringToFile(Json, *(OutputDir / TEXT("LevelManifests.json")));
+	UE_LOG(LogCobbleManifest, Display, TEXT("Wrote level manifest report to %s, %d failed"), *OutputDir, NumFailed);
+	return NumFailed > 0 ? 1 : 0;
+}
+
+void UCobbleLevelManifestCommandlet::BakeLevel(ULevel* Level, UCobbleLevelManifest* Manifest) const
+{
+	Manifest->Actors.Reset();
+	Manifest->Powers.Reset();
+	Manifest->Paths.Reset();
+	Manifest->Levers.Reset();
+
+	TArray<AActor*> Baked;
+	for (AActor* Actor : Level->Actors)
+	{
+		ECobbleManifestKind Kind;
+		if (Actor == nullptr || Actor->IsPendingKill() || !UCobbleLevelManifest::GetKind(Actor, Kind))
+			continue;
+		Baked.Add(Actor);
+		FCobbleManifestActor& Entry = Manifest->Actors.AddDefaulted_GetRef();
+		Entry.Name = Actor->GetFName();
+		Entry.Kind = Kind;
+		Entry.Location = Actor->GetActorLocation();
+		Entry.Bounds = Actor->GetComponentsBoundingBox(true);
+		Entry.Fingerprint = UCobbleLevelManifest::GetFingerprint(Actor);
+	}
+
+	for (int32 Index = 0; Index < Baked.Num(); Index++)
+	{
+		AActor* Actor = Baked[Index];
+		TInlineComponentArray<UCobbleGearHolderComponent*> Holders(Actor);
+		for (UCobbleGearHolderComponent* Holder : Holders)
+		{
+			const AGearActivatedActor* GearActivated = Cast<AGearActivatedActor>(Actor);
+			FCobbleManifestPower& Power = Manifest->Powers.AddDefaulted_GetRef();
+			Power.Holder = Index;
+			Power.Component = Holder->GetFName();
+			Power.Powered = GearActivated != nullptr && GearActivated->GetGearHolder() == Holder ? Index : INDEX_NONE;
+		}
+
+		if (const ALever* Lever = Cast<ALever>(Actor))
+		{
+			FCobbleManifestLever& Entry = Manifest->Levers.AddDefaulted_GetRef();
+			Entry.Actor = Index;
+			Entry.bFlippedToTheLeft = Lever->bIsFlippedToTheLeft;
+			Entry.HoseGravityScale = ALever::GetHoseGravityScale(Lever->bIsFlippedToTheLeft);
+		}
+
+		const AMovingPlatform* Platform = Cast<AMovingPlatform>(Actor);
+		const USplineComponent* Spline = Platform != nullptr ? Platform->GetPath() : nullptr;
+		const float Length = Spline != nullptr ? Spline->GetSplineLength() : 0;
+		if (Length > 0)
+		{
+			FCobbleManifestPath& Path = Manifest->Paths.AddDefaulted_GetRef();
+			Path.Actor = Index;
+			Path.Length = Length;
+			Path.Spacing = FMath::Max(PathSpacing, 1.f);
+			const int32 NumPoints = FMath::CeilToInt(Length / Path.Spacing) + 1;
+			Path.Points.Reserve(NumPoints);
+			for (int32 Point = 0; Point < NumPoints - 1; Point++)
+				Path.Points.Add(Spline->GetLocationAtDistanceAlongSpline(Point * Path.Spacing, ESplineCoordinateSpace::World));
+			Path.Points.Add(Spline->GetLocationAtDistanceAlongSpline(Length, ESplineCoordinateSpace::World));
+		}
+	}
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CobbleLevelManifestCommandlet.generated.h"
+
+class ULevel;
+class UCobbleLevelManifest;
+
+/**
+ * Bakes a UCobbleLevelManifest for every level of every map, sublevels included: the puzzle actors and their bounds, the
+ * gear holder power relations, each moving platform's path sampled every PathSpacing and the levers' starting state.
+ * Saved to LevelManifestPath in the Cobble settings, which packaging always cooks. LevelManifests.json lists the counts.
+ * Run it before cooking, after the levels change, it only needs the editor binaries and works headless:
+ *
+ * UE4Editor-Cmd Cobble.uproject -run=CobbleLevelManifest -unattended -nopause -nullrhi [-Maps=Lvl_A,Lvl_B] [-Output=Dir] [-DryRun]
+ * -DryRun bakes and reports without saving anything. Output defaults to Saved/Manifests.
+ */
+UCLASS(config = Game)
+class COBBLE_API UCobbleLevelManifestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCobbleLevelManifestCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+public:
+	// Distance between two baked points of a platform path. Platforms move in straight lines between them.
+	UPROPERTY(config)
+	float PathSpacing = 10;
+
+private:
+	void BakeLevel(ULevel* Level, UCobbleLevelManifest* Manifest) const;
+};
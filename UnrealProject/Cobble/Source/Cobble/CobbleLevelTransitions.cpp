@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleLevelTransitions.h"
+#include "CobbleLevelExit.h"
+#include "CobblePaperCharacter.h"
+#include "CobbleSettings.h"
+#include "CobbleTelemetry.h"
+#include "CobbleSideScroll.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	// Players walk towards an exit slowly compared to how long a map takes to load, so there is no need to look every frame
+	const float UpdateInterval = 0.5f;
+}
+
+void UCobbleLevelTransitions::Deinitialize()
+{
+	Exits.Reset();
+	PreloadedWorld = nullptr;
+	Super::Deinitialize();
+}
+
+bool UCobbleLevelTransitions::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && Exits.Num() > 0;
+}
+
+TStatId UCobbleLevelTransitions::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCobbleLevelTransitions, STATGROUP_Tickables);
+}
+
+void UCobbleLevelTransitions::Tick(float DeltaTime)
+{
+	COBBLE_TELEMETRY_SCOPE(Streaming);
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0)
+	{
+		TimeUntilUpdate = UpdateInterval;
+		UpdatePreloads();
+	}
+}
+
+void UCobbleLevelTransitions::RegisterExit(ACobbleLevelExit* Exit)
+{
+	if (Exit != nullptr)
+		Exits.AddUnique(Exit);
+}
+
+void UCobbleLevelTransitions::UnregisterExit(ACobbleLevelExit* Exit)
+{
+	Exits.RemoveAll([Exit](const TWeakObjectPtr<ACobbleLevelExit>& Entry) { return !Entry.IsValid() || Entry == Exit; });
+}
+
+void UCobbleLevelTransitions::UpdatePreloads()
+{
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (World == nullptr || World->IsPlayInEditor()) // PIE can't seamless travel, so there is nothing to preload for
+		return;
+	const float PreloadDistance = GetDefault<UCobbleSettings>()->LevelPreloadDistance;
+	// On the server this is every player, on a client just its own
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr;
+		if (Pawn == nullptr)
+			continue;
+		const FVector Axis = FCobbleSideScroll::GetScrollAxis(Pawn);
+		for (const TWeakObjectPtr<ACobbleLevelExit>& Exit : Exits)
+		{
+			if (Exit.IsValid() && FMath::Abs(FCobbleSideScroll::GetDistanceAlongAxis(Axis, Pawn->GetActorLocation(), Exit->GetActorLocation())) <= PreloadDistance)
+				Preload(Exit->NextLevel);
+		}
+	}
+}
+
+void UCobbleLevelTransitions::Preload(const TSoftObjectPtr<UWorld>& Level)
+{
+	const FString PackageName = Level.GetLongPackageName();
+	if (PackageName.IsEmpty() || PackageName == PreloadPackageName)
+		return;
+	PreloadPackageName = PackageName;
+	PreloadedWorld = nullptr;
+	PreloadStartTime = FPlatformTime::Seconds();
+	PreloadSeconds = 0;
+	UE_LOG(LogTemp, Log, TEXT("Preloading %s"), *PackageName);
+	LoadPackageAsync(PackageName, FLoadPackageAsyncDelegate::CreateUObject(this, &UCobbleLevelTransitions::OnPreloaded));
+}
+
+void UCobbleLevelTransitions::OnPreloaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+{
+	if (PackageName.ToString() != PreloadPackageName)
+		return;
+	if (Result != EAsyncLoadingResult::Succeeded || Package == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not preload %s"), *PreloadPackageName);
+		PreloadPackageName.Reset();
+		return;
+	}
+	PreloadedWorld = UWorld::FindWorldInPackage(Package);
+	PreloadSeconds = FPlatformTime::Seconds() - PreloadStartTime;
+	UE_LOG(LogTemp, Log, TEXT("Preloaded %s in %.2fs"), *PreloadPackageName, PreloadSeconds);
+}
+
+void UCobbleLevelTransitions::TravelTo(UWorld* World, const TSoftObjectPtr<UWorld>& Level)
+{
+	if (World == nullptr || Level.IsNull() || World->IsInSeamlessTravel() || TravelStartTime > 0)
+		return;
+	// Hoses and boxes belong to the level being left
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (ACobblePaperCharacter* Character = It->IsValid() ? Cast<ACobblePaperCharacter>((*It)->GetPawn()) : nullptr)
+			Character->DropHeldPickups();
+	}
+	TravelFromMap = World->GetMapName();
+	TravelToMap = Level.GetLongPackageName();
+	bTravelPreloaded = PreloadedWorld != nullptr && PreloadPackageName == TravelToMap;
+	TravelStartTime = FPlatformTime::Seconds();
+	World->ServerTravel(TravelToMap);
+}
+
+void UCobbleLevelTransitions::OnTravelFinished(UWorld* World)
+{
+	if (TravelStartTime <= 0)
+		return;
+	const double TransitionSeconds = FPlatformTime::Seconds() - TravelStartTime;
+	UE_LOG(LogTemp, Log, TEXT("Level transition %s -> %s took %.2fs (%s)"), *TravelFromMap, *TravelToMap, TransitionSeconds,
+		bTravelPreloaded ? TEXT("preloaded") : TEXT("not preloaded"));
+	if (!FApp::CanEverRender())
+		RecordTransition(TransitionSeconds);
+	TravelStartTime = 0;
+	PreloadPackageName.Reset();
+	PreloadedWorld = nullptr;
+}
+
+void UCobbleLevelTransitions::RecordTransition(double TransitionSeconds) const
+{
+	const FString Filename = FPaths::ProfilingDir() / TEXT("LevelTransitions.csv");
+	FString Line;
+	if (!IFileManager::Get().FileExists(*Filename))
+		Line = TEXT("Time,From,To,Preloaded,PreloadSeconds,TransitionSeconds\n");
+	Line += FString::Printf(TEXT("%s,%s,%s,%d,%.3f,%.3f\n"), *FDateTime::Now().ToString(), *TravelFromMap, *TravelToMap,
+		bTravelPreloaded ? 1 : 0, PreloadSeconds, TransitionSeconds);
+	FFileHelper::SaveStringToFile(Line, *Filename, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
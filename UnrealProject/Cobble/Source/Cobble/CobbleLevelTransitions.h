@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "UObject/UObjectGlobals.h"
+#include "CobbleLevelTransitions.generated.h"
+
+class ACobbleLevelExit;
+
+/**
+ * Moves the players from one map to the next without a blocking load.
+ * When a player gets within LevelPreloadDistance of an ACobbleLevelExit along the scroll axis its next map is loaded
+ * asynchronously and kept in memory. Reaching the exit seamless travels to it (see ACobbleGameModeBase), so the load
+ * behind the transition map is already done. Characters travel with their held gears, held pickups stay in the old level.
+ *
+ * Each transition is logged with how long it took and whether the map was preloaded. Runs that can't render (-nullrhi,
+ * dedicated servers, bots) also append it to Saved/Profiling/LevelTransitions.csv.
+ */
+UCLASS()
+class COBBLE_API UCobbleLevelTransitions : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterExit(ACobbleLevelExit* Exit);
+	void UnregisterExit(ACobbleLevelExit* Exit);
+
+	// Starts loading Level in the background. Does nothing if it is already loading or loaded.
+	void Preload(const TSoftObjectPtr<UWorld>& Level);
+	// Server only. Seamless travels every player to Level.
+	void TravelTo(UWorld* World, const TSoftObjectPtr<UWorld>& Level);
+	// Called by the game mode once the players have arrived
+	void OnTravelFinished(UWorld* World);
+
+private:
+	void UpdatePreloads();
+	void OnPreloaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result);
+	void RecordTransition(double TransitionSeconds) const;
+
+private:
+	TArray<TWeakObjectPtr<ACobbleLevelExit>> Exits;
+	float TimeUntilUpdate = 0;
+
+	FString PreloadPackageName;
+	double PreloadStartTime = 0;
+	double PreloadSeconds = 0;
+	// Referenced so the preloaded map survives the garbage collection on the way through the transition map
+	UPROPERTY()
+	UWorld* PreloadedWorld = nullptr;
+
+	FString TravelFromMap;
+	FString TravelToMap;
+	double TravelStartTime = 0;
+	bool bTravelPreloaded = false;
+};
@@ -0,0 +1,353 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleMachineAudio.h"
+#include "CobbleSettings.h"
+#include "CobbleTelemetry.h"
+#include "AkAudioEvent.h"
+#include "AkComponent.h"
+#include "Algo/Sort.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	// Which machines get an emitter only needs to keep up with the camera, positions are still updated every frame
+	const float AssignmentInterval = 0.1f;
+
+	TMap<const UWorld*, TWeakObjectPtr<ACobbleMachineAudio>> WorldManagers;
+
+	struct FCandidate
+	{
+		int32 SourceId;
+		float Score;
+		FVector Location;
+	};
+
+	FAutoConsoleCommandWithWorldAndArgs MachineAudioBenchCommand(
+		TEXT("Cobble.MachineAudioBench"),
+		TEXT("Times machine audio updates for each source count given, e.g. Cobble.MachineAudioBench 100 1000 10000"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(World);
+			if (MachineAudio == nullptr)
+				return;
+			for (const FString& Arg : Args)
+			{
+				const int32 NumSources = FCString::Atoi(*Arg);
+				if (NumSources > 0)
+				{
+					const double Microseconds = MachineAudio->RunBenchmark(NumSources, 200);
+					UE_LOG(LogTemp, Display, TEXT("Machine audio: %d sources, %.2f us per update"), NumSources, Microseconds);
+				}
+			}
+		}));
+}
+
+ACobbleMachineAudio::ACobbleMachineAudio()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("Root")));
+}
+
+ACobbleMachineAudio* ACobbleMachineAudio::Get(UWorld* World, bool bCreate)
+{
+	if (World == nullptr || !World->IsGameWorld() || World->GetNetMode() == NM_DedicatedServer)
+		return nullptr;
+	if (ACobbleMachineAudio* Manager = WorldManagers.FindRef(World).Get())
+		return Manager;
+	if (!bCreate || World->bIsTearingDown)
+		return nullptr;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACobbleMachineAudio* Manager = World->SpawnActor<ACobbleMachineAudio>(SpawnParams);
+	WorldManagers.Add(World, Manager);
+	return Manager;
+}
+
+void ACobbleMachineAudio::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WorldManagers.Remove(GetWorld());
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 ACobbleMachineAudio::RegisterSource(USceneComponent* Anchor, UAkAudioEvent* LoopEvent, float Loudness)
+{
+	FSource Source;
+	Source.Anchor = Anchor;
+	Source.LoopEvent = LoopEvent;
+	Source.Loudness = Loudness;
+	Source.Location = Anchor != nullptr ? Anchor->GetComponentLocation() : FVector::ZeroVector;
+	return Sources.Add(Source);
+}
+
+void ACobbleMachineAudio::UnregisterSource(int32 SourceId)
+{
+	if (Sources.IsValidIndex(SourceId))
+	{
+		SetSourceActive(SourceId, false);
+		Sources.RemoveAt(SourceId);
+	}
+}
+
+void ACobbleMachineAudio::SetSourceActive(int32 SourceId, bool bActive)
+{
+	if (!Sources.IsValidIndex(SourceId) || Sources[SourceId].bActive == bActive)
+		return;
+	FSource& Source = Sources[SourceId];
+	Source.bActive = bActive;
+	if (bActive)
+	{
+		if (Source.Anchor.IsValid())
+			Source.Location = Source.Anchor->GetComponentLocation();
+		AddToCell(SourceId);
+		if (Source.Anchor.IsValid() && Source.Anchor->Mobility == EComponentMobility::Movable)
+			MovingSources.Add(SourceId);
+	}
+	else
+	{
+		RemoveFromCell(SourceId);
+		MovingSources.RemoveSingleSwap(SourceId, false);
+		if (Source.Emitter != INDEX_NONE)
+			ReleaseEmitter(Source.Emitter);
+	}
+	// React to the change on the next frame rather than waiting for the interval
+	TimeUntilUpdate = 0;
+}
+
+void ACobbleMachineAudio::Tick(float DeltaTime)
+{
+	COBBLE_TELEMETRY_SCOPE(MachineAudio);
+	Super::Tick(DeltaTime);
+	FVector ListenerLocation;
+	if (!GetListenerLocation(ListenerLocation))
+		return;
+
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0)
+	{
+		TimeUntilUpdate = AssignmentInterval;
+		UpdateAssignments(ListenerLocation);
+	}
+	for (int32 i = 0; i < Emitters.Num(); i++)
+	{
+		if (EmitterSources[i] != INDEX_NONE)
+			Emitters[i]->SetWorldLocation(GetSourceLocation(Sources[EmitterSources[i]]));
+	}
+}
+
+void ACobbleMachineAudio::UpdateAssignments(const FVector& ListenerLocation)
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	const int32 PoolSize = FMath::Max(Settings->MachineEmitterPoolSize, 0);
+	while (Emitters.Num() < PoolSize)
+	{
+		UAkComponent* Emitter = NewObject<UAkComponent>(this);
+		Emitter->RegisterComponent();
+		Emitters.Add(Emitter);
+		EmitterSources.Add(INDEX_NONE);
+	}
+	UpdateMovingCells();
+
+	// Only the cells the ambience distance can reach, however long the level is
+	TArray<FCandidate> Candidates;
+	FVector AmbienceCentre = FVector::ZeroVector;
+	float AmbienceLoudness = 0;
+	const FIntPoint ListenerCell = GetCell(ListenerLocation);
+	const int32 CellRadius = FMath::CeilToInt(Settings->MachineAmbienceDistance / FMath::Max(Settings->MachineAudioCellSize, 1.f));
+	for (int32 X = ListenerCell.X - CellRadius; X <= ListenerCell.X + CellRadius; X++)
+	{
+		for (int32 Y = ListenerCell.Y - CellRadius; Y <= ListenerCell.Y + CellRadius; Y++)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+			if (Cell == nullptr)
+				continue;
+			for (int32 SourceId : *Cell)
+			{
+				const FSource& Source = Sources[SourceId];
+				const FVector Location = GetSourceLocation(Source);
+				const float Distance = FVector::Dist(Location, ListenerLocation);
+				// Loudness falls off with the square of distance in units of 10 meters
+				const float Score = Source.Loudness / (1 + FMath::Square(Distance / 1000));
+				if (Distance <= Settings->MachineAudibleDistance)
+				{
+					Candidates.Add({ SourceId, Score, Location });
+				}
+				else if (Distance <= Settings->MachineAmbienceDistance)
+				{
+					AmbienceCentre += Location * Score;
+					AmbienceLoudness += Score;
+				}
+			}
+		}
+	}
+
+	if (Candidates.Num() > PoolSize)
+	{
+		Algo::Sort(Candidates, [](const FCandidate& A, const FCandidate& B) { return A.Score > B.Score; });
+		for (int32 i = PoolSize; i < Candidates.Num(); i++)
+		{
+			AmbienceCentre += Candidates[i].Location * Candidates[i].Score;
+			AmbienceLoudness += Candidates[i].Score;
+		}
+		Candidates.SetNum(PoolSize, false);
+	}
+
+	// Keep emitters on sources that are still chosen so their loops don't restart
+	TArray<int32, TInlineAllocator<16>> Unassigned;
+	for (const FCandidate& Candidate : Candidates)
+	{
+		if (Sources[Candidate.SourceId].Emitter == INDEX_NONE)
+			Unassigned.Add(Candidate.SourceId);
+	}
+	for (int32 i = 0; i < Emitters.Num(); i++)
+	{
+		const int32 SourceId = EmitterSources[i];
+		if (SourceId != INDEX_NONE && !Candidates.ContainsByPredicate([SourceId](const FCandidate& Candidate) { return Candidate.SourceId == SourceId; }))
+			ReleaseEmitter(i);
+	}
+	for (int32 i = 0; i < Emitters.Num() && Unassigned.Num() > 0; i++)
+	{
+		if (EmitterSources[i] == INDEX_NONE)
+			AssignEmitter(i, Unassigned.Pop(false));
+	}
+
+	UpdateAmbience(AmbienceLoudness > 0 ? AmbienceCentre / AmbienceLoudness : ListenerLocation, AmbienceLoudness);
+}
+
+void ACobbleMachineAudio::AssignEmitter(int32 EmitterIndex, int32 SourceId)
+{
+	FSource& Source = Sources[SourceId];
+	UAkComponent* Emitter = Emitters[EmitterIndex];
+	EmitterSources[EmitterIndex] = SourceId;
+	Source.Emitter = EmitterIndex;
+	Emitter->SetWorldLocation(GetSourceLocation(Source));
+	if (Source.LoopEvent.IsValid())
+	{
+		Emitter->AkAudioEvent = Source.LoopEvent.Get();
+		Emitter->PostAssociatedAkEvent(0, FOnAkPostEventCallback());
+	}
+}
+
+void ACobbleMachineAudio::ReleaseEmitter(int32 EmitterIndex)
+{
+	const int32 SourceId = EmitterSources[EmitterIndex];
+	if (Sources.IsValidIndex(SourceId))
+		Sources[SourceId].Emitter = INDEX_NONE;
+	EmitterSources[EmitterIndex] = INDEX_NONE;
+	Emitters[EmitterIndex]->Stop();
+}
+
+void ACobbleMachineAudio::UpdateAmbience(const FVector& Location, float Loudness)
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	UAkAudioEvent* AmbienceEvent = Cast<UAkAudioEvent>(Settings->MachineAmbienceEvent.TryLoad());
+	if (AmbienceEvent == nullptr)
+		return;
+	if (AmbienceEmitter == nullptr)
+	{
+		AmbienceEmitter = NewObject<UAkComponent>(this);
+		AmbienceEmitter->RegisterComponent();
+		AmbienceEmitter->AkAudioEvent = AmbienceEvent;
+	}
+	AmbienceEmitter->SetWorldLocation(Location);
+	AmbienceEmitter->SetRTPCValue(nullptr, Loudness, 100, Settings->MachineAmbienceRTPC);
+	if (Loudness > 0 && !bAmbiencePlaying)
+	{
+		AmbienceEmitter->PostAssociatedAkEvent(0, FOnAkPostEventCallback());
+		bAmbiencePlaying = true;
+	}
+	else if (Loudness <= 0 && bAmbiencePlaying)
+	{
+		AmbienceEmitter->Stop();
+		bAmbiencePlaying = false;
+	}
+}
+
+double ACobbleMachineAudio::RunBenchmark(int32 NumSources, int32 NumUpdates)
+{
+	FVector ListenerLocation;
+	if (!GetListenerLocation(ListenerLocation))
+		ListenerLocation = FVector::ZeroVector;
+
+	// Same density as the stress maps, so more sources means a longer level rather than a more crowded one
+	const float LevelLength = NumSources * 400.f;
+	FRandomStream Random(NumSources);
+	TArray<int32> BenchSources;
+	for (int32 i = 0; i < NumSources; i++)
+	{
+		const int32 SourceId = RegisterSource(nullptr, nullptr, Random.FRandRange(0.5f, 2));
+		Sources[SourceId].Location = ListenerLocation + FVector(Random.FRandRange(-LevelLength / 2, LevelLength / 2), 0, Random.FRandRange(-1000, 1000));
+		SetSourceActive(SourceId, true);
+		BenchSources.Add(SourceId);
+	}
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	for (int32 i = 0; i < NumUpdates; i++)
+	{
+		UpdateAssignments(ListenerLocation);
+	}
+	const double Microseconds = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles) * 1000 / FMath::Max(NumUpdates, 1);
+
+	for (int32 SourceId : BenchSources)
+	{
+		UnregisterSource(SourceId);
+	}
+	return Microseconds;
+}
+
+FVector ACobbleMachineAudio::GetSourceLocation(const FSource& Source) const
+{
+	return Source.Anchor.IsValid() ? Source.Anchor->GetComponentLocation() : Source.Location;
+}
+
+FIntPoint ACobbleMachineAudio::GetCell(const FVector& Location) const
+{
+	const float CellSize = FMath::Max(GetDefault<UCobbleSettings>()->MachineAudioCellSize, 1.f);
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void ACobbleMachineAudio::AddToCell(int32 SourceId)
+{
+	FSource& Source = Sources[SourceId];
+	Source.Cell = GetCell(Source.Location);
+	Cells.FindOrAdd(Source.Cell).Add(SourceId);
+}
+
+void ACobbleMachineAudio::RemoveFromCell(int32 SourceId)
+{
+	const FSource& Source = Sources[SourceId];
+	if (TArray<int32>* Cell = Cells.Find(Source.Cell))
+	{
+		Cell->RemoveSingleSwap(SourceId, false);
+		if (Cell->Num() == 0)
+			Cells.Remove(Source.Cell);
+	}
+}
+
+void ACobbleMachineAudio::UpdateMovingCells()
+{
+	for (int32 SourceId : MovingSources)
+	{
+		FSource& Source = Sources[SourceId];
+		if (!Source.Anchor.IsValid())
+			continue;
+		Source.Location = Source.Anchor->GetComponentLocation();
+		if (GetCell(Source.Location) != Source.Cell)
+		{
+			RemoveFromCell(SourceId);
+			AddToCell(SourceId);
+		}
+	}
+}
+
+bool ACobbleMachineAudio::GetListenerLocation(FVector& OutLocation) const
+{
+	APlayerController* Controller = GetWorld()->GetFirstPlayerController();
+	if (Controller == nullptr || Controller->PlayerCameraManager == nullptr)
+		return false;
+	OutLocation = Controller->PlayerCameraManager->GetCameraLocation();
+	return true;
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleMachineAudio.generated.h"
+
+class UAkAudioEvent;
+class UAkComponent;
+
+/**
+ * Plays the loops of running machinery (turning gears, moving platforms, dragged hoses) through a small fixed pool of Wwise
+ * game objects instead of one emitter per machine.
+ *
+ * Machines register a source once and switch it on and off from the power state changes they already have. A few times a
+ * second the pool goes to the loudest active sources near the listener. Sources that are active but didn't get an emitter, or
+ * are further than MachineAudibleDistance, are merged into one ambience source placed at their loudness weighted centre, with
+ * their combined loudness in the MachineAmbienceRTPC parameter. Everything else is virtual: tracked, but with no Wwise game
+ * object. Active sources are kept in a grid so each update only looks at the cells around the listener, which keeps the cost
+ * flat as levels grow. Active sources with a movable anchor, like a dragged hose end or a platform, move between cells as
+ * they go. Cobble.MachineAudioBench 100 1000 10000 times updates with that many sources spread over a level.
+ */
+UCLASS(NotPlaceable)
+class COBBLE_API ACobbleMachineAudio : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleMachineAudio();
+
+	// The manager for a game world, spawned on first use if bCreate. nullptr on dedicated servers and outside game worlds.
+	static ACobbleMachineAudio* Get(UWorld* World, bool bCreate = true);
+
+	// Returns an id for the other calls. The source follows Anchor and starts inactive.
+	int32 RegisterSource(USceneComponent* Anchor, UAkAudioEvent* LoopEvent, float Loudness);
+	void UnregisterSource(int32 SourceId);
+	void SetSourceActive(int32 SourceId, bool bActive);
+
+	// Average microseconds per update with NumSources active sources spread along a level at the stress map spacing
+	double RunBenchmark(int32 NumSources, int32 NumUpdates);
+
+	virtual void Tick(float DeltaTime) override;
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FSource
+	{
+		TWeakObjectPtr<USceneComponent> Anchor;
+		TWeakObjectPtr<UAkAudioEvent> LoopEvent;
+		// Used when there is no anchor, and to pick the grid cell
+		FVector Location = FVector::ZeroVector;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		float Loudness = 1;
+		int32 Emitter = INDEX_NONE;
+		bool bActive = false;
+	};
+
+	void UpdateAssignments(const FVector& ListenerLocation);
+	void AssignEmitter(int32 EmitterIndex, int32 SourceId);
+	void ReleaseEmitter(int32 EmitterIndex);
+	void UpdateAmbience(const FVector& Location, float Loudness);
+	FVector GetSourceLocation(const FSource& Source) const;
+	FIntPoint GetCell(const FVector& Location) const;
+	void AddToCell(int32 SourceId);
+	void RemoveFromCell(int32 SourceId);
+	void UpdateMovingCells();
+	bool GetListenerLocation(FVector& OutLocation) const;
+
+private:
+	TSparseArray<FSource> Sources;
+	// Active sources only
+	TMap<FIntPoint, TArray<int32>> Cells;
+	// Active sources whose anchor can move, their cell is checked every update
+	TArray<int32> MovingSources;
+
+	UPROPERTY(Transient)
+	TArray<UAkComponent*> Emitters;
+	TArray<int32> EmitterSources;
+	UPROPERTY(Transient)
+	UAkComponent* AmbienceEmitter = nullptr;
+	bool bAmbiencePlaying = false;
+
+	float TimeUntilUpdate = 0;
+};
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleManifestBinding.h"
+#include "CobbleLevelManifest.h"
+#include "CobbleSettings.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleGearHolderComponent.h"
+#include "Lever.h"
+#include "MovingPlatform.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/PackageName.h"
+
+namespace
+{
+	// Baked locations are exact, this only allows for float error
+	const float LocationTolerance = 1;
+
+	TMap<const UWorld*, TWeakObjectPtr<ACobbleManifestBinding>> WorldManagers;
+
+	FAutoConsoleCommandWithWorld LevelManifestsCommand(
+		TEXT("Cobble.LevelManifests"),
+		TEXT("Lists how many puzzle actors each level's manifest bound and how long it took"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (ACobbleManifestBinding* Binding = ACobbleManifestBinding::Get(World, false))
+				Binding->LogLevels();
+		}));
+}
+
+ACobbleManifestBinding::ACobbleManifestBinding()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("Root")));
+}
+
+ACobbleManifestBinding* ACobbleManifestBinding::Get(UWorld* World, bool bCreate)
+{
+	// Levels played in the editor may have changed since the last bake, so only standalone games and cooked builds use manifests
+	if (World == nullptr || !World->IsGameWorld() || World->WorldType == EWorldType::PIE || !GetDefault<UCobbleSettings>()->bUseLevelManifests)
+		return nullptr;
+	if (ACobbleManifestBinding* Manager = WorldManagers.FindRef(World).Get())
+		return Manager;
+	if (!bCreate || World->bIsTearingDown)
+		return nullptr;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACobbleManifestBinding* Manager = World->SpawnActor<ACobbleManifestBinding>(SpawnParams);
+	WorldManagers.Add(World, Manager);
+	return Manager;
+}
+
+void ACobbleManifestBinding::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WorldManagers.Remove(GetWorld());
+	Super::EndPlay(EndPlayReason);
+}
+
+bool ACobbleManifestBinding::IsBound(AActor* Actor)
+{
+	ACobbleManifestBinding* Binding = Actor != nullptr ? Get(Actor->GetWorld()) : nullptr;
+	if (Binding == nullptr)
+		return false;
+	Binding->BindLevel(Actor->GetLevel());
+	return Binding->BoundActors.Contains(Actor);
+}
+
+void ACobbleManifestBinding::GetPowered(const AActor* Holder, TArray<AActor*>& OutPowered) const
+{
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<2>> Powered;
+	PoweredBy.MultiFind(Holder, Powered);
+	for (const TWeakObjectPtr<AActor>& Actor : Powered)
+	{
+		if (Actor.IsValid())
+			OutPowered.Add(Actor.Get());
+	}
+}
+
+UCobbleGearHolderComponent* ACobbleManifestBinding::FindGearHolder(AActor* Actor)
+{
+	if (Actor == nullptr)
+		return nullptr;
+	if (IsBound(Actor))
+		return Get(Actor->GetWorld())->GearHolders.FindRef(Actor).Get();
+	return Actor->FindComponentByClass<UCobbleGearHolderComponent>();
+}
+
+void ACobbleManifestBinding::BindLevel(ULevel* Level)
+{
+	if (Level == nullptr || BoundLevels.Contains(Level))
+		return;
+	BoundLevels.Add(Level);
+	const double StartTime = FPlatformTime::Seconds();
+	FLevelResult& Result = Results.AddDefaulted_GetRef();
+	Result.Name = UWorld::RemovePIEPrefix(FPackageName::GetShortName(Level->GetOutermost()));
+
+	UCobbleLevelManifest* Manifest = LoadObject<UCobbleLevelManifest>(nullptr, *UCobbleLevelManifest::GetObjectPath(Level), nullptr, LOAD_NoWarn | LOAD_Quiet);
+	if (Manifest == nullptr)
+		return;
+	Manifests.Add(Manifest);
+	Result.bHasManifest = true;
+	Result.NumBaked = Manifest->Actors.Num();
+
+	TMap<FName, AActor*> LevelActors;
+	LevelActors.Reserve(Level->Actors.Num());
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor != nullptr)
+			LevelActors.Add(Actor->GetFName(), Actor);
+	}
+	TArray<AActor*> Resolved;
+	Resolved.SetNumZeroed(Manifest->Actors.Num());
+	for (int32 Index = 0; Index < Manifest->Actors.Num(); Index++)
+	{
+		const FCobbleManifestActor& Entry = Manifest->Actors[Index];
+		AActor* Actor = LevelActors.FindRef(Entry.Name);
+		ECobbleManifestKind Kind;
+		if (Actor != nullptr && UCobbleLevelManifest::GetKind(Actor, Kind) && Kind == Entry.Kind
+			&& Actor->GetActorLocation().Equals(Entry.Location, LocationTolerance)
+			&& UCobbleLevelManifest::GetFingerprint(Actor) == Entry.Fingerprint)
+		{
+			Resolved[Index] = Actor;
+		}
+	}
+	auto GetResolved = [&Resolved](int32 Index) { return Resolved.IsValidIndex(Index) ? Resolved[Index] : nullptr; };
+
+	// A lever flipped since baking, like one replicated to a player joining late, sets itself up
+	for (const FCobbleManifestLever& Entry : Manifest->Levers)
+	{
+		ALever* Lever = Cast<ALever>(GetResolved(Entry.Actor));
+		if (Lever == nullptr)
+			continue;
+		if (Lever->bIsFlippedToTheLeft == Entry.bFlippedToTheLeft)
+			Lever->SetUpHoseForPlay(Entry.HoseGravityScale);
+		else
+			Resolved[Entry.Actor] = nullptr;
+	}
+	for (const FCobbleManifestPath& Entry : Manifest->Paths)
+	{
+		if (AMovingPlatform* Platform = Cast<AMovingPlatform>(GetResolved(Entry.Actor)))
+			Platform->SetBakedPath(Entry.Points, Entry.Spacing, Entry.Length);
+	}
+	for (const FCobbleManifestPower& Entry : Manifest->Powers)
+	{
+		AActor* Holder = GetResolved(Entry.Holder);
+		if (Holder == nullptr)
+			continue;
+		// A holder renamed since baking leaves its actor to set itself up
+		UCobbleGearHolderComponent* Component = FindObjectFast<UCobbleGearHolderComponent>(Holder, Entry.Component);
+		if (Component == nullptr)
+		{
+			Resolved[Entry.Holder] = nullptr;
+			continue;
+		}
+		GearHolders.Add(Holder, Component);
+		if (AActor* Powered = GetResolved(Entry.Powered))
+			PoweredBy.Add(Holder, Powered);
+	}
+
+	ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld());
+	for (int32 Index = 0; Index < Resolved.Num(); Index++)
+	{
+		AActor* Actor = Resolved[Index];
+		if (Actor == nullptr)
+			continue;
+		if (PhysicsRegions != nullptr)
+			PhysicsRegions->RegisterActor(Actor, Manifest->Actors[Index].Bounds);
+		BoundActors.Add(Actor);
+		Result.NumBound++;
+	}
+	Result.Milliseconds = (FPlatformTime::Seconds() - StartTime) * 1000;
+}
+
+void ACobbleManifestBinding::LogLevels() const
+{
+	for (const FLevelResult& Result : Results)
+	{
+		if (Result.bHasManifest)
+			UE_LOG(LogTemp, Display, TEXT("%s: bound %d of %d baked actors in %.2f ms"), *Result.Name, Result.NumBound, Result.NumBaked, Result.Milliseconds);
+		else
+			UE_LOG(LogTemp, Display, TEXT("%s: no manifest, actors initialize themselves"), *Result.Name);
+	}
+}
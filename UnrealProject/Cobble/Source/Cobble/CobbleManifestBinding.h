@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleManifestBinding.generated.h"
+
+class UCobbleLevelManifest;
+class UCobbleGearHolderComponent;
+
+/**
+ * Applies each level's UCobbleLevelManifest to the level's puzzle actors in one pass, the first time one of them begins play.
+ * Every actor in the manifest is registered with ACobblePhysicsRegions from its baked bounds, levers get their hose set up
+ * and moving platforms follow their baked path instead of evaluating the spline. The actors then skip doing it themselves.
+ * Each bound actor's gear holder and what it powers are kept for FCobblePuzzleSolver and the playtest bot to look up.
+ *
+ * An actor is only bound if it is still the kind it was baked as, in the place it was baked, with the same fingerprint (its
+ * components and where they sit, and a platform's spline ends) and a lever still flipped the same way. Anything else, and
+ * levels without a manifest, initialize themselves as before. The checks only catch edits to what they look at, so
+ * manifests must be rebaked after levels change, and play in editor never uses them. Cobble.LevelManifests lists what was
+ * bound.
+ */
+UCLASS(NotPlaceable)
+class COBBLE_API ACobbleManifestBinding : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleManifestBinding();
+
+	// The binding for a game world, spawned on first use if bCreate. nullptr in play in editor, outside game worlds or with
+	// manifests turned off.
+	static ACobbleManifestBinding* Get(UWorld* World, bool bCreate = true);
+	// Binds the actor's level if this is the first time it's asked about, then whether the manifest took care of the actor
+	static bool IsBound(AActor* Actor);
+
+	// The gear activated actors a holder's actor powers, from the manifest
+	void GetPowered(const AActor* Holder, TArray<AActor*>& OutPowered) const;
+	// The actor's gear holder component from the manifest when the actor is bound, otherwise looked up on the actor
+	static UCobbleGearHolderComponent* FindGearHolder(AActor* Actor);
+
+	void LogLevels() const;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FLevelResult
+	{
+		FString Name;
+		bool bHasManifest = false;
+		int32 NumBaked = 0;
+		int32 NumBound = 0;
+		double Milliseconds = 0;
+	};
+
+	void BindLevel(ULevel* Level);
+
+private:
+	UPROPERTY(Transient)
+	TArray<UCobbleLevelManifest*> Manifests;
+	TSet<TWeakObjectPtr<ULevel>> BoundLevels;
+	TSet<TWeakObjectPtr<AActor>> BoundActors;
+	TMultiMap<TWeakObjectPtr<const AActor>, TWeakObjectPtr<AActor>> PoweredBy;
+	TMap<TWeakObjectPtr<const AActor>, TWeakObjectPtr<UCobbleGearHolderComponent>> GearHolders;
+	TArray<FLevelResult> Results;
+};
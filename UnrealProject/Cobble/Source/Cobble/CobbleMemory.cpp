@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleMemory.h"
+#include "CobblePaperCharacter.h"
+#include "CobbleSettings.h"
+#include "GearActivatedActor.h"
+#include "Lever.h"
+#include "Interactable.h"
+#include "CableComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/ArchiveCountMem.h"
+
+DECLARE_STATS_GROUP(TEXT("Cobble"), STATGROUP_Cobble, STATCAT_Advanced);
+DECLARE_MEMORY_STAT(TEXT("Character"), STAT_CobbleCharacterMemory, STATGROUP_Cobble);
+DECLARE_MEMORY_STAT(TEXT("Interactables"), STAT_CobbleInteractablesMemory, STATGROUP_Cobble);
+DECLARE_MEMORY_STAT(TEXT("Hoses"), STAT_CobbleHosesMemory, STATGROUP_Cobble);
+DECLARE_MEMORY_STAT(TEXT("Platforms"), STAT_CobblePlatformsMemory, STATGROUP_Cobble);
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Character"), STAT_CobbleCharacterLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Interactables"), STAT_CobbleInteractablesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Hoses"), STAT_CobbleHosesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Platforms"), STAT_CobblePlatformsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Character"), STAT_CobbleCharacterSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Interactables"), STAT_CobbleInteractablesSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Hoses"), STAT_CobbleHosesSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("Cobble Platforms"), STAT_CobblePlatformsSummaryLLM, STATGROUP_LLM);
+#endif
+
+namespace
+{
+	const int32 NumTags = (int32)ECobbleMemoryTag::Count;
+	FDelegateHandle BudgetTickerHandle;
+	bool bWasOverBudget[NumTags] = {};
+
+	void SetMemoryStats(const TArray<int64>& Bytes)
+	{
+		SET_MEMORY_STAT(STAT_CobbleCharacterMemory, Bytes[(int32)ECobbleMemoryTag::Character]);
+		SET_MEMORY_STAT(STAT_CobbleInteractablesMemory, Bytes[(int32)ECobbleMemoryTag::Interactables]);
+		SET_MEMORY_STAT(STAT_CobbleHosesMemory, Bytes[(int32)ECobbleMemoryTag::Hoses]);
+		SET_MEMORY_STAT(STAT_CobblePlatformsMemory, Bytes[(int32)ECobbleMemoryTag::Platforms]);
+	}
+
+	bool IsLLMTracking()
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		return FLowLevelMemTracker::IsEnabled();
+#else
+		return false;
+#endif
+	}
+
+	// Only LLM numbers are cheap enough to check every few seconds
+	bool TickBudgetCheck(float DeltaTime)
+	{
+		if (IsLLMTracking())
+		{
+			FCobbleMemory::CheckBudgets(nullptr, false);
+		}
+		return true;
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs MemReportCommand(
+		TEXT("Cobble.MemReport"),
+		TEXT("Prints memory used by each Cobble subsystem against its budget."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			FCobbleMemory::CheckBudgets(World, true);
+		}));
+}
+
+void FCobbleMemory::Startup()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	Tracker.RegisterProjectTag((int32)GetLLMTag(ECobbleMemoryTag::Character), TEXT("CobbleCharacter"), GET_STATFNAME(STAT_CobbleCharacterLLM), GET_STATFNAME(STAT_CobbleCharacterSummaryLLM));
+	Tracker.RegisterProjectTag((int32)GetLLMTag(ECobbleMemoryTag::Interactables), TEXT("CobbleInteractables"), GET_STATFNAME(STAT_CobbleInteractablesLLM), GET_STATFNAME(STAT_CobbleInteractablesSummaryLLM));
+	Tracker.RegisterProjectTag((int32)GetLLMTag(ECobbleMemoryTag::Hoses), TEXT("CobbleHoses"), GET_STATFNAME(STAT_CobbleHosesLLM), GET_STATFNAME(STAT_CobbleHosesSummaryLLM));
+	Tracker.RegisterProjectTag((int32)GetLLMTag(ECobbleMemoryTag::Platforms), TEXT("CobblePlatforms"), GET_STATFNAME(STAT_CobblePlatformsLLM), GET_STATFNAME(STAT_CobblePlatformsSummaryLLM));
+#endif
+	const float Interval = GetDefault<UCobbleSettings>()->MemoryBudgetCheckInterval;
+	if (Interval > 0)
+	{
+		BudgetTickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickBudgetCheck), Interval);
+	}
+}
+
+void FCobbleMemory::Shutdown()
+{
+	if (BudgetTickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(BudgetTickerHandle);
+		BudgetTickerHandle.Reset();
+	}
+}
+
+const TCHAR* FCobbleMemory::GetTagName(ECobbleMemoryTag Tag)
+{
+	switch (Tag)
+	{
+	case ECobbleMemoryTag::Character: return TEXT("Character");
+	case ECobbleMemoryTag::Interactables: return TEXT("Interactables");
+	case ECobbleMemoryTag::Hoses: return TEXT("Hoses");
+	case ECobbleMemoryTag::Platforms: return TEXT("Platforms");
+	default: return TEXT("None");
+	}
+}
+
+int64 FCobbleMemory::GetBudgetBytes(ECobbleMemoryTag Tag)
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	switch (Tag)
+	{
+	case ECobbleMemoryTag::Character: return (int64)Settings->CharacterMemoryBudgetKB * 1024;
+	case ECobbleMemoryTag::Interactables: return (int64)Settings->InteractablesMemoryBudgetKB * 1024;
+	case ECobbleMemoryTag::Hoses: return (int64)Settings->HosesMemoryBudgetKB * 1024;
+	case ECobbleMemoryTag::Platforms: return (int64)Settings->PlatformsMemoryBudgetKB * 1024;
+	default: return 0;
+	}
+}
+
+TArray<int64> FCobbleMemory::GetSubsystemBytes(UWorld* World)
+{
+	TArray<int64> Bytes;
+	Bytes.SetNumZeroed(NumTags);
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	if (IsLLMTracking())
+	{
+		for (int32 i = 0; i < NumTags; i++)
+		{
+			Bytes[i] = FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, GetLLMTag((ECobbleMemoryTag)i));
+		}
+		return Bytes;
+	}
+#endif
+	if (World != nullptr)
+	{
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			const ECobbleMemoryTag Tag = GetTagForActor(*It);
+			if (Tag != ECobbleMemoryTag::Count)
+				Bytes[(int32)Tag] += EstimateActorBytes(*It);
+		}
+	}
+	return Bytes;
+}
+
+int32 FCobbleMemory::CheckBudgets(UWorld* World, bool bLogAll)
+{
+	const TArray<int64> Bytes = GetSubsystemBytes(World);
+	SetMemoryStats(Bytes);
+
+	if (bLogAll)
+		UE_LOG(LogTemp, Display, TEXT("Cobble memory (%s)"), IsLLMTracking() ? TEXT("LLM") : TEXT("estimated from actors"));
+	int32 NumOverBudget = 0;
+	for (int32 i = 0; i < NumTags; i++)
+	{
+		const ECobbleMemoryTag Tag = (ECobbleMemoryTag)i;
+		const int64 Budget = GetBudgetBytes(Tag);
+		const bool bOverBudget = Budget > 0 && Bytes[i] > Budget;
+		NumOverBudget += bOverBudget ? 1 : 0;
+		// Periodic checks only warn when a subsystem goes over, not every interval it stays over
+		if (bOverBudget && (bLogAll || !bWasOverBudget[i]))
+			UE_LOG(LogTemp, Warning, TEXT("Cobble memory: %s is over budget, %.1f KB of %.1f KB"), GetTagName(Tag), Bytes[i] / 1024.0, Budget / 1024.0);
+		else if (bLogAll)
+			UE_LOG(LogTemp, Display, TEXT("Cobble memory: %s %.1f KB of %.1f KB"), GetTagName(Tag), Bytes[i] / 1024.0, Budget / 1024.0);
+		bWasOverBudget[i] = bOverBudget;
+	}
+	return NumOverBudget;
+}
+
+ECobbleMemoryTag FCobbleMemory::GetTagForActor(const AActor* Actor)
+{
+	if (Actor->IsA<ACobblePaperCharacter>())
+		return ECobbleMemoryTag::Character;
+	// Matches the scope in the ALever constructor
+	if (Actor->IsA<ALever>())
+		return ECobbleMemoryTag::Hoses;
+	if (Actor->IsA<AGearActivatedActor>())
+		return ECobbleMemoryTag::Platforms;
+	if (Actor->IsA<AInteractable>())
+		return ECobbleMemoryTag::Interactables;
+	return ECobbleMemoryTag::Count;
+}
+
+int64 FCobbleMemory::EstimateActorBytes(AActor* Actor)
+{
+	FArchiveCountMem ActorMem(Actor);
+	int64 Bytes = ActorMem.GetMax() + Actor->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (Component == nullptr)
+			continue;
+		FArchiveCountMem ComponentMem(Component);
+		Bytes += ComponentMem.GetMax() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		// The simulation particles aren't a property so serialization doesn't see them
+		if (UCableComponent* Cable = Cast<UCableComponent>(Component))
+			Bytes += (Cable->NumSegments + 1) * sizeof(FCableParticle);
+	}
+	return Bytes;
+}
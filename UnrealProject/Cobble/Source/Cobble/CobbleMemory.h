@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+class AActor;
+class UWorld;
+
+// Gameplay subsystems Cobble reports and budgets memory for
+enum class ECobbleMemoryTag : uint8
+{
+	Character,
+	Interactables,
+	Hoses,
+	Platforms,
+	Count
+};
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+// Attributes allocations in the current scope to a Cobble subsystem when running with -llm
+#define COBBLE_LLM_SCOPE(Tag) LLM_SCOPE(FCobbleMemory::GetLLMTag(ECobbleMemoryTag::Tag))
+#else
+#define COBBLE_LLM_SCOPE(Tag)
+#endif
+
+/*
+Memory tracking for the Cobble gameplay systems.
+Run with -llm (and -llmcsv for a capture) and the Cobble subsystems show up as their own LLM tags and in stat LLM.
+Component registration and child actor spawns happen inside engine code, so only the parts of those that run in Cobble
+constructors are tagged.
+
+Cobble.MemReport prints every subsystem against its budget from Project Settings > Cobble > Memory and logs a warning for each
+one over budget. Headless: -ExecCmds="Cobble.MemReport". Without -llm the numbers are estimated from the Cobble actors in the
+world instead. With -llm budgets are also checked every MemoryBudgetCheckInterval seconds.
+*/
+struct COBBLE_API FCobbleMemory
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	static ELLMTag GetLLMTag(ECobbleMemoryTag Tag) { return (ELLMTag)((int32)ELLMTag::ProjectTagStart + (int32)Tag); }
+#endif
+	// Called by the module. Names the LLM tags and starts the periodic budget check.
+	static void Startup();
+	static void Shutdown();
+
+	static const TCHAR* GetTagName(ECobbleMemoryTag Tag);
+	static int64 GetBudgetBytes(ECobbleMemoryTag Tag);
+	// Bytes used by each subsystem, indexed by ECobbleMemoryTag
+	static TArray<int64> GetSubsystemBytes(UWorld* World);
+	// Logs a warning per subsystem over budget and returns how many there were
+	static int32 CheckBudgets(UWorld* World, bool bLogAll);
+
+	// Subsystem an actor's estimated memory counts towards, Count for actors that aren't Cobble's
+	static ECobbleMemoryTag GetTagForActor(const AActor* Actor);
+	// Serialized size of an actor and its components, plus resources they own exclusively and cable particle buffers
+	static int64 EstimateActorBytes(AActor* Actor);
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleNetworking.h"
+#include "CobbleSettings.h"
+#include "CobbleSideScroll.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	struct FCobbleNetClassStats
+	{
+		int64 ReplicationChecks = 0;
+		int64 StateChanges = 0;
+	};
+
+	TMap<FName, FCobbleNetClassStats> ClassStats;
+	double StatsStartTime = FPlatformTime::Seconds();
+
+	void ResetNetReport()
+	{
+		ClassStats.Reset();
+		StatsStartTime = FPlatformTime::Seconds();
+	}
+
+	void PrintNetReport(UWorld* World)
+	{
+		struct FClassRow
+		{
+			int32 Instances = 0;
+			int32 Awake = 0;
+			FCobbleNetClassStats Stats;
+		};
+		TMap<FName, FClassRow> Rows;
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			if (FCobbleNetClassStats* Stats = ClassStats.Find(It->GetClass()->GetFName()))
+			{
+				FClassRow& Row = Rows.FindOrAdd(It->GetClass()->GetFName());
+				Row.Instances++;
+				Row.Awake += It->NetDormancy <= DORM_Awake ? 1 : 0;
+				Row.Stats = *Stats;
+			}
+		}
+
+		const double Elapsed = FMath::Max(FPlatformTime::Seconds() - StatsStartTime, 0.001);
+		UE_LOG(LogTemp, Display, TEXT("Cobble net report over %.1fs"), Elapsed);
+		UE_LOG(LogTemp, Display, TEXT("%-32s %9s %6s %12s %10s %9s"), TEXT("Class"), TEXT("Instances"), TEXT("Awake"), TEXT("RepChecks"), TEXT("Changes"), TEXT("Checks/s"));
+		for (const TPair<FName, FClassRow>& Row : Rows)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%-32s %9d %6d %12lld %10lld %9.1f"), *Row.Key.ToString(), Row.Value.Instances, Row.Value.Awake,
+				Row.Value.Stats.ReplicationChecks, Row.Value.Stats.StateChanges, Row.Value.Stats.ReplicationChecks / Elapsed);
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs NetReportCommand(
+		TEXT("Cobble.NetReport"),
+		TEXT("Prints replication counters per Cobble actor class. Pass reset to clear them."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+				ResetNetReport();
+			else if (World != nullptr)
+				PrintNetReport(World);
+		}));
+}
+
+bool FCobbleNet::IsRelevantToCamera(const AActor* Actor, const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation)
+{
+	if (Actor->bAlwaysRelevant || Actor->IsOwnedBy(ViewTarget) || Actor->IsOwnedBy(RealViewer))
+		return true;
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	return FCobbleSideScroll::IsInCameraArea(FCobbleSideScroll::GetScrollAxis(ViewTarget), SrcLocation, Actor->GetActorLocation(),
+		Settings->NetRelevancyHalfWidth, Settings->NetRelevancyHalfHeight);
+}
+
+void FCobbleNet::MarkStateChanged(AActor* Actor)
+{
+	if (Actor == nullptr || !Actor->HasAuthority())
+		return;
+	Actor->FlushNetDormancy();
+	ClassStats.FindOrAdd(Actor->GetClass()->GetFName()).StateChanges++;
+}
+
+void FCobbleNet::RecordReplicationCheck(const AActor* Actor)
+{
+	ClassStats.FindOrAdd(Actor->GetClass()->GetFName()).ReplicationChecks++;
+}
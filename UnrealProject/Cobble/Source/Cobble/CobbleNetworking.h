@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+
+/*
+Replication helpers shared by the Cobble actors.
+Puzzle actors (gears, holders, levers, hoses, platforms) start net dormant and only wake up for a single update when their
+state changes, so a level full of idle machinery costs nothing to replicate.
+
+Testing co-op on one machine:
+	UE4Editor Cobble.uproject /Game/Levels/Lvl_Construciton_Intro?listen -game -log -windowed -ResX=960 -ResY=540
+	UE4Editor Cobble.uproject 127.0.0.1 -game -log -windowed -ResX=960 -ResY=540
+or in PIE set Number of Players to 2 and Net Mode to Play As Listen Server.
+
+Cobble.NetReport on the server prints, per actor class, how many instances are awake, how often they were considered for
+replication and how often their state changed. Cobble.NetReport reset clears the counters.
+For exact bytes per class run the server with -networkprofiler and open the capture in the NetworkProfiler tool.
+*/
+struct COBBLE_API FCobbleNet
+{
+	// Relevancy that follows the side scrolling camera of the viewer instead of a distance sphere
+	static bool IsRelevantToCamera(const AActor* Actor, const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation);
+
+	// Call on the server before changing replicated state so a dormant actor sends exactly one update
+	static void MarkStateChanged(AActor* Actor);
+
+	// Call from PreReplication so the net report knows how often the class is being looked at
+	static void RecordReplicationCheck(const AActor* Actor);
+};
@@ -7,14 +7,21 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "PaperFlipbook.h"
 #include "Engine/World.h"
-#include "TimerManager.h"
 #include "Components/BoxComponent.h"
 #include "PaperSpriteComponent.h"
 #include "InteractInterface.h"
 #include "PickupInterface.h"
 #include "Gear.h"
+#include "CobbleHoseComponent.h"
+#include "MoveableBox.h"
+#include "CobbleMemory.h"
+#include "CobbleHitchDetector.h"
+#include "CobbleTelemetry.h"
+#include "CobbleHeadless.h"
+#include "Net/UnrealNetwork.h"
 ACobblePaperCharacter::ACobblePaperCharacter()
 {	
+	COBBLE_LLM_SCOPE(Character);
 	PrimaryActorTick.bCanEverTick = true;
 	FlipbookComponent = GetSprite();
 	FlipbookComponent->CastShadow = true;
@@ -41,18 +48,40 @@ void ACobblePaperCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInp
 
 void ACobblePaperCharacter::BeginPlay()
 {
+	COBBLE_LLM_SCOPE(Character);
 	Super::BeginPlay();
+	HeldItems.SetNum(FMath::Max(NumHeldItemSlots, 1));
+}
+
+void ACobblePaperCharacter::PreRegisterAllComponents()
+{
+	Super::PreRegisterAllComponents();
+	if (FCobbleHeadless::IsEnabled(this))
+	{
+		FCobbleHeadless::SkipComponent(HighlightedGearComponent);
+		FCobbleHeadless::SkipComponent(PickedUpGearComponent);
+		FCobbleHeadless::HideComponent(FlipbookComponent);
+	}
 }
 
 void ACobblePaperCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {	
-	GetWorld()->GetTimerManager().ClearAllTimersForObject(this);
+	if (ACobbleScheduler* Scheduler = ACobbleScheduler::Get(GetWorld(), false))
+		Scheduler->CancelAll(this);
+	JumpAction.Reset();
+	InteractAction.Reset();
+	Super::EndPlay(EndPlayReason);
 }
 
 void ACobblePaperCharacter::Tick(float DeltaTime)
 {
+	COBBLE_LLM_SCOPE(Character);
+	COBBLE_TELEMETRY_SCOPE(Character);
 	Super::Tick(DeltaTime);
-	SearchForOverlappedInteractables();
+	if (IsLocallyControlled()) // Highlighting is only feedback for the player at this machine
+		SearchForOverlappedInteractables();
+	if (FCobbleHeadless::IsEnabled(this)) // Nobody sees the animation, the actions set their own flipbooks to time themselves
+		return;
 	RotateToMatchMovementDirection();
 	DoCobbleStateMachine();
 }
@@ -74,9 +103,9 @@ void ACobblePaperCharacter::SearchForOverlappedInteractables()
 					IInteractInterface* NewOverlappedActorInteractInterface = Cast<IInteractInterface>(a);
 					IInteractInterface* OldOverlappedActorInteractInterface = Cast<IInteractInterface>(OverlappedActor);
 
-					NewOverlappedActorInteractInterface->Highlight();
+					NewOverlappedActorInteractInterface->Highlight(this);
 					if (OldOverlappedActorInteractInterface != nullptr)
-						OldOverlappedActorInteractInterface->Unhighlight();
+						OldOverlappedActorInteractInterface->Unhighlight(this);
 					OverlappedActor = a;
 					break;
 				}
@@ -91,7 +120,7 @@ void ACobblePaperCharacter::SearchForOverlappedInteractables()
 	{
 		IInteractInterface* OldOverlappedActorInteractInterface = Cast<IInteractInterface>(OverlappedActor);
 		if (OldOverlappedActorInteractInterface != nullptr)
-			OldOverlappedActorInteractInterface->Unhighlight();
+			OldOverlappedActorInteractInterface->Unhighlight(this);
 		OverlappedActor = nullptr;
 	}
 }
@@ -131,8 +160,14 @@ void ACobblePaperCharacter::DoCobbleStateMachine()
 
 bool ACobblePaperCharacter::ShouldDoStateMachine()
 {
-	// If we have active timer handles then an animation is playing.
-	return !JumpTimerHandle.IsValid() && !InteractTimerHandle.IsValid();
+	// If we have active actions then an animation is playing.
+	return !IsActionActive(JumpAction) && !IsActionActive(InteractAction);
+}
+
+bool ACobblePaperCharacter::IsActionActive(const FCobbleActionHandle& Action) const
+{
+	const ACobbleScheduler* Scheduler = Action.IsValid() ? ACobbleScheduler::Get(GetWorld(), false) : nullptr;
+	return Scheduler != nullptr && Scheduler->IsActive(Action);
 }
 
 void ACobblePaperCharacter::RotateToMatchMovementDirection()
@@ -149,7 +184,7 @@ void ACobblePaperCharacter::RotateToMatchMovementDirection()
 
 void ACobblePaperCharacter::MoveHorizontal(float Value)
 {
-	if (InteractTimerHandle.IsValid())
+	if (IsActionActive(InteractAction))
 		return;
 	AddMovementInput(GetActorForwardVector(), Value);
 }
@@ -160,109 +195,223 @@ JUMPING
 void ACobblePaperCharacter::DoJump()
 {
 	Jump();
-	GetWorld()->GetTimerManager().ClearTimer(JumpTimerHandle);
 }
 
 void ACobblePaperCharacter::PreJump()
 {
-	if (!CanJump())
+	ACobbleScheduler* Scheduler = ACobbleScheduler::Get(GetWorld());
+	if (!CanJump() || Scheduler == nullptr)
 		return;
 	FlipbookComponent->SetFlipbook(PreJumpFlipbook);
-	GetWorld()->GetTimerManager().SetTimer(JumpTimerHandle, this, &ACobblePaperCharacter::DoJump, FlipbookComponent->GetFlipbookLength(), false);
+	Scheduler->Cancel(JumpAction);
+	JumpAction = Scheduler->Schedule(this, TEXT("Jump"), FlipbookComponent->GetFlipbookLength(), [this]() { DoJump(); });
+	FCobbleHitchDetector::RecordEvent(ECobbleEvent::JumpTimerStarted, this, FlipbookComponent->GetFlipbookLength());
 }
 
 bool ACobblePaperCharacter::CanJump()
 {
-	return Super::CanJump() && !GetMovementComponent()->IsFalling() && !InteractTimerHandle.IsValid();
+	return Super::CanJump() && !GetMovementComponent()->IsFalling() && !IsActionActive(InteractAction);
 }
 
 void ACobblePaperCharacter::Landed(const FHitResult& Hit)
 {
 	Super::Landed(Hit);
 	FlipbookComponent->SetFlipbook(LandingFlipbook);
-	GetWorld()->GetTimerManager().SetTimer(JumpTimerHandle, this, &ACobblePaperCharacter::PostLandedAnimation, FlipbookComponent->GetFlipbookLength(), false);
+	if (ACobbleScheduler* Scheduler = ACobbleScheduler::Get(GetWorld()))
+	{
+		Scheduler->Cancel(JumpAction);
+		JumpAction = Scheduler->Schedule(this, TEXT("Landing"), FlipbookComponent->GetFlipbookLength());
+	}
+	FCobbleHitchDetector::RecordEvent(ECobbleEvent::LandedTimerStarted, this, FlipbookComponent->GetFlipbookLength());
 }
 
-void ACobblePaperCharacter::PostLandedAnimation() { GetWorld()->GetTimerManager().ClearTimer(JumpTimerHandle); }
-
 /*
 INTERACTION
 */
 void ACobblePaperCharacter::Interact()
 {
-	if (HeldActor != nullptr)
+	// The animation plays straight away on the owning machine, the interaction itself happens on the server
+	if (!IsHoldingDroppableItem())
 	{
-		IPickupInterface* HeldActorInterface = Cast<IPickupInterface>(HeldActor);
-		if (HeldActorInterface != nullptr)
-		{
-			HeldActorInterface->Drop();
-			HeldActor = nullptr;
+		if (!CanInteract())
 			return;
+		FlipbookComponent->SetFlipbook(InteractFlipbook);
+		if (ACobbleScheduler* Scheduler = ACobbleScheduler::Get(GetWorld()))
+		{
+			Scheduler->Cancel(InteractAction);
+			InteractAction = Scheduler->Schedule(this, TEXT("Interact"), FlipbookComponent->GetFlipbookLength());
 		}
+		FCobbleHitchDetector::RecordEvent(ECobbleEvent::InteractTimerStarted, this, FlipbookComponent->GetFlipbookLength());
+	}
+	FCobbleTelemetry::Count(ECobbleCounter::Interactions);
+	ServerInteract(OverlappedActor);
+}
+
+bool ACobblePaperCharacter::ServerInteract_Validate(AActor* Target)
+{
+	return true;
+}
 
+void ACobblePaperCharacter::ServerInteract_Implementation(AActor* Target)
+{
+	for (int32 i = 0; i < HeldItems.Num(); i++)
+	{
+		if (HeldItems[i].Pickup != nullptr)
+		{
+			HeldItems[i].Pickup->Drop();
+			SetHeldItem(i, nullptr);
+			return;
+		}
 	}
-	if (!CanInteract())
+	if (!CanInteract() || Target == nullptr || !InteractCollision->IsOverlappingActor(Target))
 		return;
-	FlipbookComponent->SetFlipbook(InteractFlipbook);
-	GetWorld()->GetTimerManager().SetTimer(InteractTimerHandle, this, &ACobblePaperCharacter::PostInteract, FlipbookComponent->GetFlipbookLength(), false);
-	IInteractInterface* OverlappedActorInteractInterface = Cast<IInteractInterface>(OverlappedActor);
-	if (OverlappedActorInteractInterface != nullptr)
+	IInteractInterface* TargetInteractInterface = Cast<IInteractInterface>(Target);
+	if (TargetInteractInterface != nullptr)
 	{
-		OverlappedActorInteractInterface->Interact();
+		TargetInteractInterface->Interact(this);
 	}
 }
 
 bool ACobblePaperCharacter::CanInteract()
 {
-	return !GetMovementComponent()->IsFalling() && !JumpTimerHandle.IsValid();
+	return !GetMovementComponent()->IsFalling() && !IsActionActive(JumpAction);
 }
 
-void ACobblePaperCharacter::PostInteract()
+/*
+HELD ITEMS
+*/
+bool ACobblePaperCharacter::PickUpItem(AActor* Item)
 {
-	GetWorld()->GetTimerManager().ClearTimer(InteractTimerHandle);
+	if (Item == nullptr)
+		return false;
+	for (int32 i = 0; i < HeldItems.Num(); i++)
+	{
+		if (HeldItems[i].Item == nullptr)
+		{
+			SetHeldItem(i, Item);
+			return true;
+		}
+	}
+	return false;
 }
 
-bool ACobblePaperCharacter::ReceiveGear(AActor * Gear)
+AActor* ACobblePaperCharacter::ReleaseHeldItem(EHeldItemType Type)
 {
-	if (HeldActor == nullptr)
+	for (int32 i = 0; i < HeldItems.Num(); i++)
 	{
-		ShowHeldGear();
-		HeldActor = Gear;
-		return true;
+		if (HeldItems[i].Type == Type)
+		{
+			AActor* Item = HeldItems[i].Item;
+			SetHeldItem(i, nullptr);
+			return Item;
+		}
 	}
-	return false;
+	return nullptr;
 }
 
-bool ACobblePaperCharacter::TakeGear(AActor*& Gear)
+bool ACobblePaperCharacter::IsHoldingItem(EHeldItemType Type) const
 {
-	if (HeldActor != nullptr)
+	for (const FHeldItemSlot& Slot : HeldItems)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("TAKINGGEAR"));
-		Gear = HeldActor;
-		HeldActor = nullptr;
-		HideHeldGear();
-		return true;
+		if (Slot.Type == Type)
+			return true;
 	}
 	return false;
 }
 
-bool ACobblePaperCharacter::SetHeldActor(AActor * Other)
+bool ACobblePaperCharacter::HasFreeHeldItemSlot() const
+{
+	return IsHoldingItem(EHeldItemType::None);
+}
+
+bool ACobblePaperCharacter::IsHoldingDroppableItem() const
 {
-	if(HeldActor == nullptr)
+	for (const FHeldItemSlot& Slot : HeldItems)
 	{
-		HeldActor = Other;
-		return true;
+		if (Slot.Pickup != nullptr)
+			return true;
 	}
 	return false;
 }
 
+void ACobblePaperCharacter::DropHeldPickups()
+{
+	for (int32 i = 0; i < HeldItems.Num(); i++)
+	{
+		if (HeldItems[i].Pickup != nullptr)
+		{
+			HeldItems[i].Pickup->Drop();
+			SetHeldItem(i, nullptr);
+		}
+	}
+}
+
+void ACobblePaperCharacter::GetHeldItems(TArray<AActor*>& OutItems) const
+{
+	for (const FHeldItemSlot& Slot : HeldItems)
+	{
+		if (Slot.Item != nullptr)
+			OutItems.Add(Slot.Item);
+	}
+}
+
+void ACobblePaperCharacter::SetHeldItem(int32 SlotIndex, AActor* Item)
+{
+	HeldItems[SlotIndex].Item = Item;
+	RefreshHeldItemSlot(SlotIndex);
+}
+
+void ACobblePaperCharacter::OnRep_HeldItems()
+{
+	// Only Item replicates, so Type still holds what this machine last saw in the slot
+	for (int32 i = 0; i < HeldItems.Num(); i++)
+	{
+		RefreshHeldItemSlot(i);
+	}
+}
+
+void ACobblePaperCharacter::RefreshHeldItemSlot(int32 SlotIndex)
+{
+	FHeldItemSlot& Slot = HeldItems[SlotIndex];
+	const EHeldItemType OldType = Slot.Type;
+	Slot.Type = GetHeldItemTypeOf(Slot.Item);
+	Slot.Pickup = Cast<IPickupInterface>(Slot.Item);
+
+	if (IsHoldingItem(EHeldItemType::Gear))
+		ShowHeldGear();
+	else
+		HideHeldGear();
+
+	if (OldType != Slot.Type)
+		HeldItemChangedEvent.Broadcast(SlotIndex, OldType, Slot.Type);
+}
+
+void ACobblePaperCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(ACobblePaperCharacter, HeldItems);
+}
+
+EHeldItemType ACobblePaperCharacter::GetHeldItemTypeOf(AActor* Item)
+{
+	if (Item == nullptr)
+		return EHeldItemType::None;
+	if (Item->IsA<AGear>())
+		return EHeldItemType::Gear;
+	if (Item->FindComponentByClass<UCobbleHoseComponent>() != nullptr)
+		return EHeldItemType::Hose;
+	if (Item->IsA<AMoveableBox>())
+		return EHeldItemType::Box;
+	return EHeldItemType::Other;
+}
+
 /*
 GEAR HIGHLIGHTING
 */
 void ACobblePaperCharacter::ShowGearHighlight()
 {
-	if(HeldActor == nullptr)
-	HighlightedGearComponent->SetHiddenInGame(false);
+	if (HasFreeHeldItemSlot())
+		HighlightedGearComponent->SetHiddenInGame(false);
 }
 
 void ACobblePaperCharacter::HideGearHighlight()
@@ -280,11 +429,7 @@ void ACobblePaperCharacter::HideHeldGear()
 	PickedUpGearComponent->SetHiddenInGame(true);
 }
 
-bool ACobblePaperCharacter::IsPlayerHoldingGear()
+bool ACobblePaperCharacter::IsPlayerHoldingGear() const
 {
-	if (HeldActor == nullptr)
-		return false;
-	AGear* Gear = Cast<AGear>(HeldActor);
-	return Gear != nullptr;
+	return IsHoldingItem(EHeldItemType::Gear);
 }
-
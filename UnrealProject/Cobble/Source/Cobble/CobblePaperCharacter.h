@@ -4,8 +4,37 @@
 
 #include "CoreMinimal.h"
 #include "PaperCharacter.h"
+#include "CobbleScheduler.h"
 #include "CobblePaperCharacter.generated.h"
 
+/*
+Category of an item the player is holding. Worked out once when the item is picked up so that
+highlight logic never has to cast the held actor.
+*/
+UENUM()
+enum class EHeldItemType : uint8
+{
+	None,
+	Gear,
+	Hose,
+	Box,
+	Other
+};
+
+USTRUCT()
+struct FHeldItemSlot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AActor* Item = nullptr;
+	EHeldItemType Type = EHeldItemType::None;
+	class IPickupInterface* Pickup = nullptr; // Cached on pickup so dropping doesn't need to cast
+};
+
+// Slot index, type that was in the slot, type that is in the slot now
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnHeldItemChanged, int32, EHeldItemType, EHeldItemType);
+
 /**
  * 
  */
@@ -21,6 +50,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// Headless runs strip the gear sprites and the flipbook before they register, see FCobbleHeadless
+	virtual void PreRegisterAllComponents() override;
 
 public:
 	// Called every frame
@@ -41,11 +72,23 @@ public:
 	void ShowHeldGear();
 	void HideHeldGear();
 
-	bool IsPlayerHoldingGear();
-	bool ReceiveGear(AActor* Gear);
-	bool TakeGear(AActor*& Gear);
+	bool IsPlayerHoldingGear() const;
 
-	bool SetHeldActor(AActor* Other);
+	/*
+	Held items
+	PickUpItem - Puts the item in the first free slot, returns false if every slot is full.
+	ReleaseHeldItem - Empties the first slot holding an item of that type and returns the item.
+	All changes to the slots go through SetHeldItem so OnHeldItemChanged always fires.
+	*/
+	bool PickUpItem(AActor* Item);
+	AActor* ReleaseHeldItem(EHeldItemType Type);
+	bool IsHoldingItem(EHeldItemType Type) const;
+	bool HasFreeHeldItemSlot() const;
+	bool IsHoldingDroppableItem() const;
+	// Seamless travel. Pickups belong to the level and are dropped, the other held items travel with the character.
+	void DropHeldPickups();
+	void GetHeldItems(TArray<AActor*>& OutItems) const;
+	FOnHeldItemChanged& OnHeldItemChanged() { return HeldItemChangedEvent; }
 
 
 public:
@@ -67,6 +110,8 @@ public:
 	class UPaperSpriteComponent* HighlightedGearComponent;
 	UPROPERTY(VisibleAnywhere)
 	class UPaperSpriteComponent* PickedUpGearComponent;
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "1"))
+	int32 NumHeldItemSlots = 1;
 
 private:
 	void MoveHorizontal(float Value);
@@ -77,23 +122,19 @@ private:
 
 
 	/*
-	PreJump - Play prejump anim and start timer. 
-	DoJump - Called after pre jump - clears timer, does jump
+	PreJump - Play prejump anim and schedule the jump for when it ends. 
+	DoJump - Called after pre jump - does jump
 	Written by Rhys Sullivan
 	*/
 	void PreJump();
 	bool CanJump();
-	UFUNCTION()
 	void DoJump();
 
 	/*
-	Landed - Plays the landing animation & starts a timer for when that ends. 
-	PostLandedAnimation - After the landing timer ends, clear the timer. 
+	Landed - Plays the landing animation & holds the jump action open until it ends. 
 	Written by Rhys Sullivan
 	*/ 
 	void Landed(const FHitResult& Hit) override;
-	UFUNCTION()
-	void PostLandedAnimation();
 
 	/*
 	
@@ -101,15 +142,30 @@ private:
 	*/
 	void Interact();
 	bool CanInteract();
-	void PostInteract();
+	// True while the action is scheduled, which is while its animation plays
+	bool IsActionActive(const FCobbleActionHandle& Action) const;
+	// Runs the interaction on the server. Target is what the owning client has highlighted, it is checked against the server's overlaps.
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerInteract(AActor* Target);
 
 	void SearchForOverlappedInteractables();
+
+	void SetHeldItem(int32 SlotIndex, AActor* Item);
+	void RefreshHeldItemSlot(int32 SlotIndex);
+	UFUNCTION()
+	void OnRep_HeldItems();
+	static EHeldItemType GetHeldItemTypeOf(AActor* Item);
+
+	// Plays through the same input handlers a player does
+	friend class ACobbleBotController;
 private:
 	class UPaperFlipbookComponent* FlipbookComponent; // Reference to the flipbook pointer so we don't have to call GetSprite() over and over
-	FTimerHandle JumpTimerHandle; // Managers the timer for jumping related animations
-	FTimerHandle InteractTimerHandle;
+	FCobbleActionHandle JumpAction; // Jumping related animations, pre jump and landing
+	FCobbleActionHandle InteractAction;
 	UPROPERTY(VisibleAnywhere)
 	class UBoxComponent* InteractCollision;
 	AActor* OverlappedActor;
-	AActor* HeldActor;
+	UPROPERTY(ReplicatedUsing = OnRep_HeldItems)
+	TArray<FHeldItemSlot> HeldItems;
+	FOnHeldItemChanged HeldItemChangedEvent;
 };
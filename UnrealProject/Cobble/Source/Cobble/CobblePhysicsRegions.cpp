@@ -0,0 +1,342 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobblePhysicsRegions.h"
+#include "CobbleSettings.h"
+#include "CobbleHitchDetector.h"
+#include "CobbleTelemetry.h"
+#include "CobblePaperCharacter.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	// Which cells are active only needs to keep up with the players running across them
+	const float UpdateInterval = 0.25f;
+	// Actors covering more cells than this, like a platform with a very long path, are never pruned
+	const int32 MaxCellsPerActor = 64;
+
+	TMap<const UWorld*, TWeakObjectPtr<ACobblePhysicsRegions>> WorldManagers;
+
+	FAutoConsoleCommandWithWorld PhysicsRegionsCommand(
+		TEXT("Cobble.PhysicsRegions"),
+		TEXT("Lists how many puzzle actors and physics bodies are pruned from the physics scene"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (ACobblePhysicsRegions* Regions = ACobblePhysicsRegions::Get(World, false))
+				Regions->LogRegions();
+		}));
+}
+
+ACobblePhysicsRegions::ACobblePhysicsRegions()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("Root")));
+}
+
+ACobblePhysicsRegions* ACobblePhysicsRegions::Get(UWorld* World, bool bCreate)
+{
+	if (World == nullptr || !World->IsGameWorld() || !GetDefault<UCobbleSettings>()->bPrunePhysicsRegions)
+		return nullptr;
+	if (ACobblePhysicsRegions* Manager = WorldManagers.FindRef(World).Get())
+		return Manager;
+	if (!bCreate || World->bIsTearingDown)
+		return nullptr;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACobblePhysicsRegions* Manager = World->SpawnActor<ACobblePhysicsRegions>(SpawnParams);
+	Manager->CellSize = FMath::Max(GetDefault<UCobbleSettings>()->PhysicsRegionSize, 100.f);
+	WorldManagers.Add(World, Manager);
+	return Manager;
+}
+
+void ACobblePhysicsRegions::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WorldManagers.Remove(GetWorld());
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACobblePhysicsRegions::RegisterActor(AActor* Actor)
+{
+	if (Actor != nullptr)
+		RegisterActor(Actor, Actor->GetComponentsBoundingBox(true));
+}
+
+void ACobblePhysicsRegions::RegisterActor(AActor* Actor, const FBox& Bounds)
+{
+	if (Actor == nullptr || ActorEntries.Contains(Actor))
+		return;
+	FEntry Entry;
+	Entry.Actor = Actor;
+	const int32 EntryId = Entries.Add(Entry);
+	ActorEntries.Add(Actor, EntryId);
+	AddToCells(EntryId, Bounds);
+	// Decided on the next update, so nothing is pruned before the players have been looked for
+	PendingEntries.Add(EntryId);
+}
+
+void ACobblePhysicsRegions::UnregisterActor(AActor* Actor)
+{
+	int32 EntryId = INDEX_NONE;
+	if (!ActorEntries.RemoveAndCopyValue(Actor, EntryId))
+		return;
+	Restore(Entries[EntryId]);
+	RemoveFromCells(EntryId);
+	PendingEntries.Remove(EntryId);
+	Entries.RemoveAt(EntryId);
+}
+
+void ACobblePhysicsRegions::UpdateActorCells(AActor* Actor)
+{
+	if (const int32* EntryId = ActorEntries.Find(Actor))
+	{
+		RemoveFromCells(*EntryId);
+		AddToCells(*EntryId);
+		UpdateEntry(Entries[*EntryId]);
+	}
+}
+
+void ACobblePhysicsRegions::SetActorAwake(AActor* Actor, bool bAwake)
+{
+	const int32* EntryId = ActorEntries.Find(Actor);
+	if (EntryId == nullptr || Entries[*EntryId].bAwake == bAwake)
+		return;
+	Entries[*EntryId].bAwake = bAwake;
+	if (bAwake)
+		Restore(Entries[*EntryId]);
+	else
+		UpdateActorCells(Actor);
+}
+
+void ACobblePhysicsRegions::Wake(AActor* Actor)
+{
+	if (const int32* EntryId = ActorEntries.Find(Actor))
+	{
+		Restore(Entries[*EntryId]);
+		PendingEntries.AddUnique(*EntryId);
+	}
+}
+
+void ACobblePhysicsRegions::Tick(float DeltaTime)
+{
+	COBBLE_TELEMETRY_SCOPE(PhysicsRegions);
+	Super::Tick(DeltaTime);
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0)
+		return;
+	const bool bFoundPlayers = UpdateCells(UpdateInterval - TimeUntilUpdate);
+	TimeUntilUpdate = UpdateInterval;
+	// Nothing changes while the players are still spawning, or everything would be restored again straight after
+	if (!bFoundPlayers)
+		return;
+	for (int32 EntryId : PendingEntries)
+		UpdateEntry(Entries[EntryId]);
+	PendingEntries.Reset();
+}
+
+bool ACobblePhysicsRegions::UpdateCells(float DeltaTime)
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	const FVector Extent(Settings->PhysicsActiveHalfWidth, Settings->PhysicsActiveHalfWidth, Settings->PhysicsActiveHalfHeight);
+
+	// Only cells with puzzle actors in them are tracked, so empty space around the players costs nothing
+	TSet<FIntVector> WantedCells;
+	bool bFoundPlayers = false;
+	for (TActorIterator<ACobblePaperCharacter> It(GetWorld()); It; ++It)
+	{
+		bFoundPlayers = true;
+		const FIntVector Min = GetCell(It->GetActorLocation() - Extent);
+		const FIntVector Max = GetCell(It->GetActorLocation() + Extent);
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+			{
+				for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+				{
+					const FIntVector CellIndex(X, Y, Z);
+					if (Cells.Contains(CellIndex))
+						WantedCells.Add(CellIndex);
+				}
+			}
+		}
+	}
+	if (!bFoundPlayers)
+		return false;
+
+	for (const FIntVector& CellIndex : WantedCells)
+	{
+		FCell& Cell = Cells[CellIndex];
+		Cell.InactiveTime = 0;
+		SetCellActive(CellIndex, Cell, true);
+	}
+	TArray<FIntVector, TInlineAllocator<16>> ExpiredCells;
+	for (const FIntVector& CellIndex : ActiveCells)
+	{
+		if (WantedCells.Contains(CellIndex))
+			continue;
+		FCell& Cell = Cells[CellIndex];
+		Cell.InactiveTime += DeltaTime;
+		if (Cell.InactiveTime >= Settings->PhysicsRegionLinger)
+			ExpiredCells.Add(CellIndex);
+	}
+	for (const FIntVector& CellIndex : ExpiredCells)
+		SetCellActive(CellIndex, Cells[CellIndex], false);
+	return true;
+}
+
+void ACobblePhysicsRegions::SetCellActive(const FIntVector& CellIndex, FCell& Cell, bool bActive)
+{
+	if (Cell.bActive == bActive)
+		return;
+	Cell.bActive = bActive;
+	if (bActive)
+		ActiveCells.Add(CellIndex);
+	else
+		ActiveCells.Remove(CellIndex);
+	for (int32 EntryId : Cell.Entries)
+	{
+		Entries[EntryId].NumActiveCells += bActive ? 1 : -1;
+		UpdateEntry(Entries[EntryId]);
+	}
+}
+
+void ACobblePhysicsRegions::AddToCells(int32 EntryId)
+{
+	const TWeakObjectPtr<AActor>& Actor = Entries[EntryId].Actor;
+	AddToCells(EntryId, Actor.IsValid() ? Actor->GetComponentsBoundingBox(true) : FBox(ForceInit));
+}
+
+void ACobblePhysicsRegions::AddToCells(int32 EntryId, const FBox& Bounds)
+{
+	FEntry& Entry = Entries[EntryId];
+	if (!Bounds.IsValid)
+		return;
+	Entry.MinCell = GetCell(Bounds.Min);
+	Entry.MaxCell = GetCell(Bounds.Max);
+	const FIntVector Span = Entry.MaxCell - Entry.MinCell + FIntVector(1, 1, 1);
+	if (Span.X * Span.Y * Span.Z > MaxCellsPerActor)
+	{
+		Entry.MaxCell = Entry.MinCell - FIntVector(1, 1, 1);
+		Entry.bAwake = true;
+		return;
+	}
+	for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				FCell& Cell = Cells.FindOrAdd(FIntVector(X, Y, Z));
+				Cell.Entries.Add(EntryId);
+				Entry.NumActiveCells += Cell.bActive ? 1 : 0;
+			}
+		}
+	}
+}
+
+void ACobblePhysicsRegions::RemoveFromCells(int32 EntryId)
+{
+	FEntry& Entry = Entries[EntryId];
+	for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				const FIntVector CellIndex(X, Y, Z);
+				FCell* Cell = Cells.Find(CellIndex);
+				if (Cell == nullptr)
+					continue;
+				Cell->Entries.RemoveSwap(EntryId);
+				if (Cell->Entries.Num() == 0)
+				{
+					ActiveCells.Remove(CellIndex);
+					Cells.Remove(CellIndex);
+				}
+			}
+		}
+	}
+	Entry.MinCell = FIntVector::ZeroValue;
+	Entry.MaxCell = Entry.MinCell - FIntVector(1, 1, 1);
+	Entry.NumActiveCells = 0;
+}
+
+void ACobblePhysicsRegions::UpdateEntry(FEntry& Entry)
+{
+	const bool bNeeded = Entry.bAwake || Entry.NumActiveCells > 0;
+	if (bNeeded)
+		Restore(Entry);
+	else
+		Prune(Entry);
+}
+
+void ACobblePhysicsRegions::Prune(FEntry& Entry)
+{
+	AActor* Actor = Entry.Actor.Get();
+	if (Entry.bPruned || Actor == nullptr)
+		return;
+	Entry.bPruned = true;
+	TInlineComponentArray<UPrimitiveComponent*> Components(Actor);
+	for (UPrimitiveComponent* Component : Components)
+	{
+		const ECollisionEnabled::Type CollisionEnabled = Component->GetCollisionEnabled();
+		if (!Component->IsRegistered() || (CollisionEnabled == ECollisionEnabled::NoCollision && !Component->GetGenerateOverlapEvents()
+			&& !Component->IsPhysicsStateCreated()))
+		{
+			continue;
+		}
+		FPrunedComponent& Pruned = Entry.PrunedComponents.AddDefaulted_GetRef();
+		Pruned.Component = Component;
+		Pruned.CollisionEnabled = CollisionEnabled;
+		Pruned.bGenerateOverlapEvents = Component->GetGenerateOverlapEvents();
+		Component->SetGenerateOverlapEvents(false);
+		Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		// Without collision the body only stops answering queries, destroying it takes it out of the broadphase
+		if (Component->IsPhysicsStateCreated())
+			Component->DestroyPhysicsState();
+	}
+}
+
+void ACobblePhysicsRegions::Restore(FEntry& Entry)
+{
+	if (!Entry.bPruned)
+		return;
+	Entry.bPruned = false;
+	for (const FPrunedComponent& Pruned : Entry.PrunedComponents)
+	{
+		UPrimitiveComponent* Component = Pruned.Component.Get();
+		if (Component == nullptr || !Component->IsRegistered())
+			continue;
+		Component->SetCollisionEnabled(Pruned.CollisionEnabled);
+		if (!Component->IsPhysicsStateCreated())
+			Component->RecreatePhysicsState();
+		// Last, so anything already inside gets its begin overlap
+		Component->SetGenerateOverlapEvents(Pruned.bGenerateOverlapEvents);
+		if (Pruned.bGenerateOverlapEvents)
+			Component->UpdateOverlaps();
+	}
+	FCobbleHitchDetector::RecordEvent(ECobbleEvent::PhysicsRegionRestored, Entry.Actor.Get(), Entry.PrunedComponents.Num());
+	Entry.PrunedComponents.Reset();
+}
+
+FIntVector ACobblePhysicsRegions::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void ACobblePhysicsRegions::LogRegions() const
+{
+	int32 NumPruned = 0;
+	int32 NumAwake = 0;
+	int32 NumComponents = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		NumPruned += Entry.bPruned ? 1 : 0;
+		NumAwake += Entry.bAwake ? 1 : 0;
+		NumComponents += Entry.PrunedComponents.Num();
+	}
+	UE_LOG(LogTemp, Display, TEXT("Physics regions: %d actors, %d pruned with %d components, %d awake, %d of %d cells active"),
+		Entries.Num(), NumPruned, NumComponents, NumAwake, ActiveCells.Num(), Cells.Num());
+}
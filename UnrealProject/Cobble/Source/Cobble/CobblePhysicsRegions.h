@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobblePhysicsRegions.generated.h"
+
+/**
+ * Takes puzzle actors far from every player out of the physics scene, so the broadphase and overlap bookkeeping only hold
+ * what is around the players instead of the whole level.
+ *
+ * The level is split into a grid of PhysicsRegionSize cells. A cell is active while it is inside the box around any player
+ * character, and stays active for PhysicsRegionLinger seconds after, so walking back and forth over an edge doesn't toggle
+ * it every update. Puzzle actors register the cells their bounds cover. When none of them are active, the actor's
+ * primitives stop generating overlaps, lose their collision and have their physics bodies destroyed. The settings are kept
+ * and put back as they were when a cell comes back, only physics changes, so puzzle state is untouched.
+ *
+ * Awake actors are never pruned, e.g. a falling box or a lever whose hose a player is carrying. Wake restores an actor straight
+ * away, which is called before a power change so gameplay code changing collision works on the real settings.
+ * Cobble.PhysicsRegions lists the counts.
+ */
+UCLASS(NotPlaceable)
+class COBBLE_API ACobblePhysicsRegions : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobblePhysicsRegions();
+
+	// The manager for a game world, spawned on first use if bCreate. nullptr outside game worlds or with pruning turned off.
+	static ACobblePhysicsRegions* Get(UWorld* World, bool bCreate = true);
+
+	// Covers the cells of the actor's bounds, including components without collision like a platform's path
+	void RegisterActor(AActor* Actor);
+	// With bounds already known, like those baked into a level manifest
+	void RegisterActor(AActor* Actor, const FBox& Bounds);
+	void UnregisterActor(AActor* Actor);
+	// Picks the cells again after the actor was moved somewhere else, like a gear put in a holder
+	void UpdateActorCells(AActor* Actor);
+	// Going to sleep picks the cells again, the actor may have moved while awake
+	void SetActorAwake(AActor* Actor, bool bAwake);
+	// Restores the actor now if it is pruned. It is pruned again on the next update if it still isn't needed.
+	void Wake(AActor* Actor);
+
+	void LogRegions() const;
+
+	virtual void Tick(float DeltaTime) override;
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FPrunedComponent
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		ECollisionEnabled::Type CollisionEnabled = ECollisionEnabled::NoCollision;
+		bool bGenerateOverlapEvents = false;
+	};
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		FIntVector MinCell = FIntVector::ZeroValue;
+		FIntVector MaxCell = FIntVector(-1, -1, -1); // Below MinCell while the entry covers no cells
+		int32 NumActiveCells = 0;
+		bool bAwake = false;
+		bool bPruned = false;
+		TArray<FPrunedComponent, TInlineAllocator<4>> PrunedComponents;
+	};
+	struct FCell
+	{
+		TArray<int32> Entries;
+		bool bActive = false;
+		float InactiveTime = 0;
+	};
+
+	// False if there are no player characters yet
+	bool UpdateCells(float DeltaTime);
+	void SetCellActive(const FIntVector& CellIndex, FCell& Cell, bool bActive);
+	void AddToCells(int32 EntryId);
+	void AddToCells(int32 EntryId, const FBox& Bounds);
+	void RemoveFromCells(int32 EntryId);
+	void UpdateEntry(FEntry& Entry);
+	void Prune(FEntry& Entry);
+	void Restore(FEntry& Entry);
+	FIntVector GetCell(const FVector& Location) const;
+
+private:
+	TSparseArray<FEntry> Entries;
+	TMap<const AActor*, int32> ActorEntries;
+	TMap<FIntVector, FCell> Cells;
+	TSet<FIntVector> ActiveCells;
+	// Registered or woken since the last update, decided on the next one
+	TArray<int32> PendingEntries;
+	float TimeUntilUpdate = 0;
+	float CellSize = 1;
+};
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobblePuzzleCheckCommandlet.h"
+#include "CobbleLevelAuditCommandlet.h"
+#include "CobblePuzzleSolver.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCobblePuzzle, Log, All);
+
+UCobblePuzzleCheckCommandlet::UCobblePuzzleCheckCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCobblePuzzleCheckCommandlet::Main(const FString& Params)
+{
+	FString OutputDir = FPaths::ProjectSavedDir() / TEXT("Puzzles");
+	FParse::Value(*Params, TEXT("Output="), OutputDir);
+	int32 NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	FParse::Value(*Params, TEXT("Threads="), NumWorkers);
+
+	FCobblePuzzleReach Reach;
+	Reach.MaxGap = MaxGap;
+	Reach.MaxJumpHeight = MaxJumpHeight;
+
+	int32 NumFailed = 0;
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart(TEXT("Maps"));
+	for (const FString& MapPackageName : UCobbleLevelAuditCommandlet::FindMapPackages(Params))
+	{
+		const FString MapName = FPackageName::GetShortName(MapPackageName);
+		UWorld* World = UCobbleLevelAuditCommandlet::LoadMap(MapPackageName);
+		if (World == nullptr)
+		{
+			UE_LOG(LogCobblePuzzle, Error, TEXT("Could not load %s"), *MapPackageName);
+			NumFailed++;
+			continue;
+		}
+
+		FCobblePuzzleGraph Graph;
+		FString Error;
+		const bool bExtracted = FCobblePuzzleSolver::ExtractGraph(World, Reach, Graph, Error);
+		UCobbleLevelAuditCommandlet::UnloadMap(World);
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Map"), MapName);
+		if (!bExtracted)
+		{
+			UE_LOG(LogCobblePuzzle, Error, TEXT("%s: %s"), *MapName, *Error);
+			Writer->WriteValue(TEXT("Error"), Error);
+			Writer->WriteObjectEnd();
+			NumFailed++;
+			continue;
+		}
+
+		const FCobblePuzzleSolution Solution = FCobblePuzzleSolver::Solve(Graph, NumWorkers, MaxStates);
+		Writer->WriteValue(TEXT("Solvable"), Solution.bSolved);
+		Writer->WriteValue(TEXT("SearchComplete"), Solution.bComplete);
+		Writer->WriteValue(TEXT("Sites"), Graph.Sites.Num());
+		Writer->WriteValue(TEXT("Edges"), Graph.GetNumEdges());
+		Writer->WriteValue(TEXT("Gears"), Graph.Gears.Num());
+		Writer->WriteValue(TEXT("GearHolders"), Graph.Holders.Num());
+		Writer->WriteValue(TEXT("Levers"), Graph.Levers.Num());
+		Writer->WriteValue(TEXT("StatesVisited"), Solution.StatesVisited);
+		Writer->WriteValue(TEXT("Workers"), Solution.NumWorkers);
+		Writer->WriteValue(TEXT("Seconds"), Solution.Seconds);
+		Writer->WriteArrayStart(TEXT("Steps"));
+		for (const FString& Step : Solution.Steps)
+			Writer->WriteValue(Step);
+		Writer->WriteArrayEnd();
+		Writer->WriteObjectEnd();
+
+		if (Solution.bSolved)
+		{
+			UE_LOG(LogCobblePuzzle, Display, TEXT("%s: solvable in %d steps (%lld states, %.2fs on %d workers)"), *MapName,
+				Solution.Steps.Num(), Solution.StatesVisited, Solution.Seconds, Solution.NumWorkers);
+			for (const FString& Step : Solution.Steps)
+				UE_LOG(LogCobblePuzzle, Display, TEXT("    %s"), *Step);
+		}
+		else if (Solution.bComplete)
+		{
+			UE_LOG(LogCobblePuzzle, Error, TEXT("%s: not solvable, all %lld states searched"), *MapName, Solution.StatesVisited);
+			NumFailed++;
+		}
+		else
+		{
+			UE_LOG(LogCobblePuzzle, Error, TEXT("%s: no solution in the first %lld states, raise MaxStates"), *MapName, Solution.StatesVisited);
+			NumFailed++;
+		}
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteValue(TEXT("Failed"), NumFailed);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FFileHelper::SaveStringToFile(Json, *(OutputDir / TEXT("PuzzleCheck.json")));
+	UE_LOG(LogCobblePuzzle, Display, TEXT("Wrote puzzle check to %s, %d maps failed"), *OutputDir, NumFailed);
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CobblePuzzleCheckCommandlet.generated.h"
+
+/**
+ * Checks every puzzle can be finished without a playtest. Each map is turned into a puzzle graph (see FCobblePuzzleSolver)
+ * and searched for the shortest sequence of interactions that gets the player to the goal: an actor tagged PuzzleGoal, or
+ * the far end of the level along the scroll axis. Gear activated actors tagged PuzzleGate block the way past them until
+ * powered. Writes PuzzleCheck.json with the solution for each map and returns 1 if any map can't be solved.
+ *
+ * UE4Editor-Cmd Cobble.uproject -run=CobblePuzzleCheck -unattended -nopause -nullrhi [-Maps=Lvl_A,Lvl_B] [-Threads=N] [-Output=Dir]
+ * Without -Maps every map under /Game/Levels is checked. Threads defaults to every task graph worker, output to Saved/Puzzles.
+ */
+UCLASS(config = Game)
+class COBBLE_API UCobblePuzzleCheckCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCobblePuzzleCheckCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+public:
+	// Furthest apart along the scroll axis two places can be for the player to get between them unaided
+	UPROPERTY(config)
+	float MaxGap = 400;
+	// Highest the player can jump up onto something
+	UPROPERTY(config)
+	float MaxJumpHeight = 250;
+	// A map is reported as unproven rather than searched forever past this many states
+	UPROPERTY(config)
+	int64 MaxStates = 50000000;
+};
@@ -0,0 +1,666 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobblePuzzleSolver.h"
+#include "CobbleSideScroll.h"
+#include "CobbleManifestBinding.h"
+#include "Gear.h"
+#include "GearHolder.h"
+#include "CobbleGearHolderComponent.h"
+#include "GearActivatedActor.h"
+#include "Lever.h"
+#include "MovingPlatform.h"
+#include "Components/SplineComponent.h"
+#include "GameFramework/PlayerStart.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/Atomic.h"
+#include "Misc/AutomationTest.h"
+
+namespace
+{
+	enum class EPuzzleAction : uint8
+	{
+		None,
+		PickUpGear,
+		TakeGearFromHolder,
+		PlaceGear
+	};
+
+	struct FPuzzleAction
+	{
+		EPuzzleAction Type = EPuzzleAction::None;
+		uint16 Target = 0; // Gear or holder depending on the type
+		uint16 Gear = 0;
+	};
+
+	/*
+	Byte layout: player site (two bytes), held gear + 1 (zero when empty handed), then one byte per gear saying where it is.
+	Levers are left out, nothing in the graph depends on which way they are flipped.
+	*/
+	const int32 HeldGearByte = 2;
+	const int32 FirstGearByte = 3;
+	const uint8 GearAtStart = 0; // Otherwise holder + 1
+	const uint8 GearHeld = 255;
+
+	struct FPuzzleState
+	{
+		TArray<uint8, TInlineAllocator<32>> Bytes;
+		uint32 Hash = 0;
+
+		int32 GetPlayerSite() const { return Bytes[0] | (Bytes[1] << 8); }
+		void SetPlayerSite(int32 Site) { Bytes[0] = Site & 0xff; Bytes[1] = (Site >> 8) & 0xff; }
+		void UpdateHash() { Hash = FCrc::MemCrc32(Bytes.GetData(), Bytes.Num()); }
+		bool operator==(const FPuzzleState& Other) const { return Hash == Other.Hash && Bytes == Other.Bytes; }
+		friend uint32 GetTypeHash(const FPuzzleState& State) { return State.Hash; }
+	};
+
+	const uint64 NoNode = MAX_uint64;
+
+	struct FSearchNode
+	{
+		uint64 Parent = NoNode;
+		FPuzzleAction Action;
+	};
+
+	struct FFrontierEntry
+	{
+		FPuzzleState State;
+		uint64 Node = NoNode;
+	};
+
+	// Every state seen so far, split by hash so workers adding states at the same time rarely share a lock
+	class FVisitedStates
+	{
+	public:
+		static const int32 NumShards = 64;
+
+		// Returns false if the state was already visited
+		bool Add(const FPuzzleState& State, const FSearchNode& Node, uint64& OutRef)
+		{
+			const int32 ShardIndex = State.Hash % NumShards;
+			FShard& Shard = Shards[ShardIndex];
+			FScopeLock Lock(&Shard.Lock);
+			bool bAlreadyVisited = false;
+			Shard.States.Add(State, &bAlreadyVisited);
+			if (bAlreadyVisited)
+				return false;
+			OutRef = ((uint64)ShardIndex << 32) | (uint64)Shard.Nodes.Add(Node);
+			return true;
+		}
+
+		// Only safe once the workers are done
+		const FSearchNode& Get(uint64 Ref) const
+		{
+			return Shards[Ref >> 32].Nodes[Ref & MAX_uint32];
+		}
+
+	private:
+		struct FShard
+		{
+			FCriticalSection Lock;
+			TSet<FPuzzleState> States;
+			TArray<FSearchNode> Nodes;
+		};
+		FShard Shards[NumShards];
+	};
+
+	// Works out what the player can do from a state. One per worker, it keeps scratch memory between states.
+	class FPuzzleExpander
+	{
+	public:
+		explicit FPuzzleExpander(const FCobblePuzzleGraph& InGraph)
+			: Graph(InGraph)
+		{
+			IncomingEdges.SetNum(Graph.Sites.Num());
+			for (int32 From = 0; From < Graph.Edges.Num(); From++)
+			{
+				for (const FCobblePuzzleEdge& Edge : Graph.Edges[From])
+					IncomingEdges[Edge.To].Add(FIncomingEdge{ From, &Edge });
+			}
+		}
+
+		FPuzzleState MakeStartState()
+		{
+			FPuzzleState State;
+			State.Bytes.SetNumZeroed(FirstGearByte + Graph.Gears.Num());
+			State.SetPlayerSite(Graph.StartSite);
+			for (int32 Gear = 0; Gear < Graph.Gears.Num(); Gear++)
+			{
+				if (Graph.Gears[Gear].StartHolder != INDEX_NONE)
+					State.Bytes[FirstGearByte + Gear] = Graph.Gears[Gear].StartHolder + 1;
+			}
+			return State;
+		}
+
+		/*
+		Moves the player to the lowest numbered site they can both reach and get back from, then hashes the state. Returns true
+		if the goal is reachable. Drops only go one way, so a site the player can reach but not return from is somewhere else,
+		while every site they can go to and come back from reaches exactly the same sites.
+		*/
+		bool Canonicalize(FPuzzleState& State)
+		{
+			UpdateReachable(State, CanonicalScratch);
+			const TBitArray<>& CanonicalReachable = CanonicalScratch.Reachable;
+			const int32 PlayerSite = State.GetPlayerSite();
+			int32 LowestSite = PlayerSite;
+			ReturnsToPlayer.Init(false, Graph.Sites.Num());
+			ReturnsToPlayer[PlayerSite] = true;
+			Stack.Reset();
+			Stack.Add(PlayerSite);
+			while (Stack.Num() > 0)
+			{
+				const int32 Site = Stack.Pop(false);
+				for (const FIncomingEdge& Incoming : IncomingEdges[Site])
+				{
+					// Any way back to the player only passes through sites the player can reach
+					if (ReturnsToPlayer[Incoming.From] || !CanonicalReachable[Incoming.From] || !IsOpen(*Incoming.Edge, CanonicalScratch.Powered))
+						continue;
+					ReturnsToPlayer[Incoming.From] = true;
+					LowestSite = FMath::Min(LowestSite, Incoming.From);
+					Stack.Add(Incoming.From);
+				}
+			}
+			State.SetPlayerSite(LowestSite);
+			State.UpdateHash();
+			return CanonicalReachable[Graph.GoalSite];
+		}
+
+		// Calls Visit with every canonical state one interaction away and whether the goal is reachable from it
+		void Expand(const FPuzzleState& State, TFunctionRef<void(const FPuzzleState&, const FPuzzleAction&, bool)> Visit)
+		{
+			UpdateReachable(State, Current);
+			const TArray<int32>& HolderGears = Current.HolderGears;
+			const TBitArray<>& Reachable = Current.Reachable;
+			const uint8 HeldGear = State.Bytes[HeldGearByte];
+			auto Emit = [this, &Visit](FPuzzleState& Child, int32 PlayerSite, EPuzzleAction Type, int32 Target, int32 Gear)
+			{
+				Child.SetPlayerSite(PlayerSite);
+				const bool bGoal = Canonicalize(Child);
+				FPuzzleAction Action;
+				Action.Type = Type;
+				Action.Target = (uint16)Target;
+				Action.Gear = (uint16)Gear;
+				Visit(Child, Action, bGoal);
+			};
+
+			if (HeldGear == 0)
+			{
+				for (int32 Gear = 0; Gear < Graph.Gears.Num(); Gear++)
+				{
+					if (State.Bytes[FirstGearByte + Gear] == GearAtStart && Reachable[Graph.Gears[Gear].Site])
+					{
+						FPuzzleState Child = State;
+						Child.Bytes[FirstGearByte + Gear] = GearHeld;
+						Child.Bytes[HeldGearByte] = Gear + 1;
+						Emit(Child, Graph.Gears[Gear].Site, EPuzzleAction::PickUpGear, Gear, Gear);
+					}
+				}
+				for (int32 Holder = 0; Holder < Graph.Holders.Num(); Holder++)
+				{
+					const int32 Gear = HolderGears[Holder];
+					if (Gear != INDEX_NONE && Reachable[Graph.Holders[Holder].Site])
+					{
+						FPuzzleState Child = State;
+						Child.Bytes[FirstGearByte + Gear] = GearHeld;
+						Child.Bytes[HeldGearByte] = Gear + 1;
+						Emit(Child, Graph.Holders[Holder].Site, EPuzzleAction::TakeGearFromHolder, Holder, Gear);
+					}
+				}
+			}
+			else
+			{
+				const int32 Gear = HeldGear - 1;
+				for (int32 Holder = 0; Holder < Graph.Holders.Num(); Holder++)
+				{
+					if (HolderGears[Holder] == INDEX_NONE && Reachable[Graph.Holders[Holder].Site])
+					{
+						FPuzzleState Child = State;
+						Child.Bytes[FirstGearByte + Gear] = Holder + 1;
+						Child.Bytes[HeldGearByte] = 0;
+						Emit(Child, Graph.Holders[Holder].Site, EPuzzleAction::PlaceGear, Holder, Gear);
+					}
+				}
+			}
+		}
+
+	private:
+		// What a state looks like once its gears are resolved to holders, powered actors and reachable sites
+		struct FResolvedState
+		{
+			TArray<int32> HolderGears;
+			TBitArray<> Powered;
+			TBitArray<> Reachable;
+		};
+
+		struct FIncomingEdge
+		{
+			int32 From;
+			const FCobblePuzzleEdge* Edge;
+		};
+
+		static bool IsOpen(const FCobblePuzzleEdge& Edge, const TBitArray<>& Powered)
+		{
+			for (int32 Required : Edge.RequiresPowered)
+			{
+				if (!Powered[Required])
+					return false;
+			}
+			return true;
+		}
+
+		void UpdateReachable(const FPuzzleState& State, FResolvedState& Out)
+		{
+			TArray<int32>& HolderGears = Out.HolderGears;
+			TBitArray<>& Powered = Out.Powered;
+			TBitArray<>& OutReachable = Out.Reachable;
+			HolderGears.Init(INDEX_NONE, Graph.Holders.Num());
+			for (int32 Gear = 0; Gear < Graph.Gears.Num(); Gear++)
+			{
+				const uint8 Where = State.Bytes[FirstGearByte + Gear];
+				if (Where != GearAtStart && Where != GearHeld)
+					HolderGears[Where - 1] = Gear;
+			}
+			Powered.Init(false, Graph.Powered.Num());
+			for (int32 Index = 0; Index < Graph.Powered.Num(); Index++)
+			{
+				const int32 Holder = Graph.Powered[Index].Holder;
+				Powered[Index] = Holder != INDEX_NONE && HolderGears[Holder] != INDEX_NONE;
+			}
+
+			OutReachable.Init(false, Graph.Sites.Num());
+			Stack.Reset();
+			Stack.Add(State.GetPlayerSite());
+			OutReachable[State.GetPlayerSite()] = true;
+			while (Stack.Num() > 0)
+			{
+				const int32 Site = Stack.Pop(false);
+				for (const FCobblePuzzleEdge& Edge : Graph.Edges[Site])
+				{
+					if (OutReachable[Edge.To])
+						continue;
+					if (IsOpen(Edge, Powered))
+					{
+						OutReachable[Edge.To] = true;
+						Stack.Add(Edge.To);
+					}
+				}
+			}
+		}
+
+	private:
+		const FCobblePuzzleGraph& Graph;
+		FResolvedState Current; // The state being expanded
+		FResolvedState CanonicalScratch;
+		TArray<TArray<FIncomingEdge>> IncomingEdges; // Per site, the edges that lead to it
+		TBitArray<> ReturnsToPlayer;
+		TArray<int32> Stack;
+	};
+
+	FString DescribeAction(const FCobblePuzzleGraph& Graph, const FPuzzleAction& Action)
+	{
+		switch (Action.Type)
+		{
+		case EPuzzleAction::PickUpGear:
+			return FString::Printf(TEXT("Pick up %s"), *Graph.Gears[Action.Gear].Name);
+		case EPuzzleAction::TakeGearFromHolder:
+			return FString::Printf(TEXT("Take %s out of %s"), *Graph.Gears[Action.Gear].Name, *Graph.Holders[Action.Target].Name);
+		case EPuzzleAction::PlaceGear:
+			return FString::Printf(TEXT("Put %s in %s"), *Graph.Gears[Action.Gear].Name, *Graph.Holders[Action.Target].Name);
+		default:
+			return FString();
+		}
+	}
+
+	int32 GetActionSite(const FCobblePuzzleGraph& Graph, const FPuzzleAction& Action)
+	{
+		switch (Action.Type)
+		{
+		case EPuzzleAction::PickUpGear:
+			return Graph.Gears[Action.Gear].Site;
+		case EPuzzleAction::TakeGearFromHolder:
+		case EPuzzleAction::PlaceGear:
+			return Graph.Holders[Action.Target].Site;
+		default:
+			return INDEX_NONE;
+		}
+	}
+
+	void AddRequirement(FCobblePuzzleEdge& Edge, int32 Powered)
+	{
+		if (Powered != INDEX_NONE)
+			Edge.RequiresPowered.AddUnique(Powered);
+	}
+}
+
+int32 FCobblePuzzleGraph::GetNumEdges() const
+{
+	int32 NumEdges = 0;
+	for (const TArray<FCobblePuzzleEdge>& SiteEdges : Edges)
+		NumEdges += SiteEdges.Num();
+	return NumEdges;
+}
+
+bool FCobblePuzzleSolver::ExtractGraph(UWorld* World, const FCobblePuzzleReach& Reach, FCobblePuzzleGraph& OutGraph, FString& OutError)
+{
+	static const FName GoalTag(TEXT("PuzzleGoal"));
+	static const FName GateTag(TEXT("PuzzleGate"));
+	OutGraph = FCobblePuzzleGraph();
+
+	APlayerStart* PlayerStart = nullptr;
+	AActor* GoalActor = nullptr;
+	TArray<AGear*> Gears;
+	TArray<UCobbleGearHolderComponent*> Holders;
+	TArray<int32> HolderPowers; // Per holder, index into PoweredActors
+	TArray<ALever*> Levers;
+	TArray<AActor*> PoweredActors;
+	auto AddHolder = [&](UCobbleGearHolderComponent* Holder, AActor* Powered)
+	{
+		Holders.Add(Holder);
+		const bool bInPuzzle = Powered != nullptr && (Powered->IsA<AMovingPlatform>() || Powered->ActorHasTag(GateTag));
+		HolderPowers.Add(bInPuzzle ? PoweredActors.AddUnique(Powered) : INDEX_NONE);
+	};
+	// In a game world, actors bound from the level manifest take their holder and what it powers from it
+	ACobbleManifestBinding* Binding = ACobbleManifestBinding::Get(World, false);
+	TArray<AActor*> BoundPowered;
+	for (ULevel* Level : World->GetLevels())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			if (Actor == nullptr || Actor->IsPendingKill())
+				continue;
+			if (Actor->ActorHasTag(GoalTag))
+				GoalActor = Actor;
+			if (APlayerStart* Start = Cast<APlayerStart>(Actor))
+			{
+				if (PlayerStart == nullptr)
+					PlayerStart = Start;
+			}
+			else if (AGear* Gear = Cast<AGear>(Actor))
+				Gears.Add(Gear);
+			else if (ALever* Lever = Cast<ALever>(Actor))
+				Levers.Add(Lever);
+			else if (Binding != nullptr && ACobbleManifestBinding::IsBound(Actor))
+			{
+				if (UCobbleGearHolderComponent* Holder = ACobbleManifestBinding::FindGearHolder(Actor))
+				{
+					BoundPowered.Reset();
+					Binding->GetPowered(Actor, BoundPowered);
+					AddHolder(Holder, BoundPowered.Num() > 0 ? BoundPowered[0] : nullptr);
+				}
+			}
+			else if (AGearHolder* Holder = Cast<AGearHolder>(Actor))
+				AddHolder(Holder->GetGearHolder(), nullptr);
+			else if (AGearActivatedActor* GearActivated = Cast<AGearActivatedActor>(Actor))
+				AddHolder(GearActivated->GetGearHolder(), GearActivated);
+		}
+	}
+	if (PlayerStart == nullptr)
+	{
+		OutError = TEXT("No player start");
+		return false;
+	}
+	if (Gears.Num() > MaxGears || Holders.Num() > MaxHolders)
+	{
+		OutError = FString::Printf(TEXT("%d gears and %d holders, the solver handles up to %d gears and %d holders"), Gears.Num(), Holders.Num(), MaxGears, MaxHolders);
+		return false;
+	}
+
+	const FVector Axis = FCobbleSideScroll::GetScrollAxis(PlayerStart);
+	const FVector Origin = PlayerStart->GetActorLocation();
+	TArray<int32> SiteRequires; // Powered actor a site only exists while powered, the far end of a platform path
+	auto AddSite = [&OutGraph, &SiteRequires](const FString& Name, const FVector& Location, int32 RequiresPowered = INDEX_NONE)
+	{
+		FCobblePuzzleSite Site;
+		Site.Name = Name;
+		Site.Location = Location;
+		SiteRequires.Add(RequiresPowered);
+		return OutGraph.Sites.Add(Site);
+	};
+	OutGraph.StartSite = AddSite(PlayerStart->GetName(), Origin);
+
+	TArray<TPair<int32, int32>> PlatformPaths;
+	TArray<TPair<int32, float>> Gates;
+	for (int32 Index = 0; Index < PoweredActors.Num(); Index++)
+	{
+		AActor* Actor = PoweredActors[Index];
+		FCobblePuzzleGraph::FPowered Powered;
+		Powered.Name = Actor->GetName();
+		if (AMovingPlatform* Platform = Cast<AMovingPlatform>(Actor))
+		{
+			// An unpowered platform is taken to be at the start of its path, the far end only exists while it runs
+			const USplineComponent* Path = Platform->GetPath();
+			const int32 LastPoint = Path->GetNumberOfSplinePoints() - 1;
+			Powered.bIsPlatform = true;
+			const int32 StartSite = AddSite(Powered.Name + TEXT(" start"), Path->GetLocationAtSplinePoint(0, ESplineCoordinateSpace::World));
+			const int32 EndSite = AddSite(Powered.Name + TEXT(" end"), Path->GetLocationAtSplinePoint(LastPoint, ESplineCoordinateSpace::World), Index);
+			PlatformPaths.Emplace(StartSite, EndSite);
+		}
+		else
+		{
+			Gates.Emplace(Index, FCobbleSideScroll::GetDistanceAlongAxis(Axis, Origin, Actor->GetActorLocation()));
+		}
+		OutGraph.Powered.Add(Powered);
+	}
+
+	for (AGear* Gear : Gears)
+	{
+		FCobblePuzzleGraph::FGear& Entry = OutGraph.Gears.AddDefaulted_GetRef();
+		Entry.Name = Gear->GetName();
+		Entry.Site = AddSite(Entry.Name, Gear->GetActorLocation());
+	}
+	for (int32 Index = 0; Index < Holders.Num(); Index++)
+	{
+		FCobblePuzzleGraph::FHolder& Entry = OutGraph.Holders.AddDefaulted_GetRef();
+		Entry.Name = Holders[Index]->GetOwner()->GetName();
+		Entry.Site = AddSite(Entry.Name, Holders[Index]->GetComponentLocation());
+		Entry.Powers = HolderPowers[Index];
+		if (Entry.Powers != INDEX_NONE)
+			OutGraph.Powered[Entry.Powers].Holder = Index;
+		const int32 StartingGear = Gears.Find(Holders[Index]->StartingGear);
+		if (StartingGear != INDEX_NONE)
+			OutGraph.Gears[StartingGear].StartHolder = Index;
+	}
+	for (ALever* Lever : Levers)
+	{
+		FCobblePuzzleGraph::FLever& Entry = OutGraph.Levers.AddDefaulted_GetRef();
+		Entry.Name = Lever->GetName();
+		Entry.Site = AddSite(Entry.Name, Lever->GetActorLocation());
+	}
+
+	if (GoalActor != nullptr)
+	{
+		OutGraph.GoalSite = AddSite(GoalActor->GetName(), GoalActor->GetActorLocation());
+	}
+	else
+	{
+		// Without a tagged goal the puzzle is finished by getting to the far end of the level
+		float FurthestDistance = -MAX_flt;
+		for (int32 Site = 0; Site < OutGraph.Sites.Num(); Site++)
+		{
+			const float Distance = FCobbleSideScroll::GetDistanceAlongAxis(Axis, Origin, OutGraph.Sites[Site].Location);
+			if (Distance > FurthestDistance && SiteRequires[Site] == INDEX_NONE)
+			{
+				FurthestDistance = Distance;
+				OutGraph.GoalSite = Site;
+			}
+		}
+	}
+	if (OutGraph.Sites.Num() > MaxSites)
+	{
+		OutError = FString::Printf(TEXT("%d sites, the solver handles up to %d"), OutGraph.Sites.Num(), MaxSites);
+		return false;
+	}
+
+	OutGraph.Edges.SetNum(OutGraph.Sites.Num());
+	for (int32 From = 0; From < OutGraph.Sites.Num(); From++)
+	{
+		const FVector& FromLocation = OutGraph.Sites[From].Location;
+		const float FromDistance = FCobbleSideScroll::GetDistanceAlongAxis(Axis, Origin, FromLocation);
+		for (int32 To = 0; To < OutGraph.Sites.Num(); To++)
+		{
+			const FVector& ToLocation = OutGraph.Sites[To].Location;
+			const float ToDistance = FCobbleSideScroll::GetDistanceAlongAxis(Axis, Origin, ToLocation);
+			if (From == To || FMath::Abs(ToDistance - FromDistance) > Reach.MaxGap || ToLocation.Z - FromLocation.Z > Reach.MaxJumpHeight)
+				continue;
+			FCobblePuzzleEdge Edge;
+			Edge.To = To;
+			AddRequirement(Edge, SiteRequires[From]);
+			AddRequirement(Edge, SiteRequires[To]);
+			for (const TPair<int32, float>& Gate : Gates)
+			{
+				if (Gate.Value > FMath::Min(FromDistance, ToDistance) && Gate.Value < FMath::Max(FromDistance, ToDistance))
+					AddRequirement(Edge, Gate.Key);
+			}
+			OutGraph.Edges[From].Add(Edge);
+		}
+	}
+	for (const TPair<int32, int32>& Path : PlatformPaths)
+	{
+		// Riding the platform
+		FCobblePuzzleEdge Edge;
+		Edge.RequiresPowered.Add(SiteRequires[Path.Value]);
+		Edge.To = Path.Value;
+		OutGraph.Edges[Path.Key].Add(Edge);
+		Edge.To = Path.Key;
+		OutGraph.Edges[Path.Value].Add(Edge);
+	}
+	return true;
+}
+
+FCobblePuzzleSolution FCobblePuzzleSolver::Solve(const FCobblePuzzleGraph& Graph, int32 NumWorkers, int64 MaxStates)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 ChunkSize = 256;
+	FCobblePuzzleSolution Solution;
+	Solution.NumWorkers = FMath::Max(NumWorkers, 1);
+
+	TUniquePtr<FVisitedStates> Visited = MakeUnique<FVisitedStates>();
+	FPuzzleExpander StartExpander(Graph);
+	FFrontierEntry Start;
+	Start.State = StartExpander.MakeStartState();
+	const bool bStartIsGoal = StartExpander.Canonicalize(Start.State);
+	Visited->Add(Start.State, FSearchNode(), Start.Node);
+
+	TAtomic<uint64> GoalNode(bStartIsGoal ? Start.Node : NoNode);
+	TAtomic<int64> StatesVisited(1);
+	TArray<FFrontierEntry> Frontier;
+	Frontier.Add(Start);
+	TArray<TArray<FFrontierEntry>> WorkerFrontiers;
+	WorkerFrontiers.SetNum(Solution.NumWorkers);
+
+	// One depth at a time, so any goal found at a depth is as close as a goal can be
+	while (Frontier.Num() > 0 && GoalNode.Load() == NoNode)
+	{
+		if (StatesVisited.Load() >= MaxStates)
+		{
+			Solution.bComplete = false;
+			break;
+		}
+		TAtomic<int32> Cursor(0);
+		ParallelFor(Solution.NumWorkers, [&](int32 Worker)
+		{
+			FPuzzleExpander Expander(Graph);
+			TArray<FFrontierEntry>& Next = WorkerFrontiers[Worker];
+			for (;;)
+			{
+				const int32 Begin = Cursor.AddExchange(ChunkSize);
+				if (Begin >= Frontier.Num() || GoalNode.Load() != NoNode)
+					break;
+				const int32 End = FMath::Min(Begin + ChunkSize, Frontier.Num());
+				for (int32 Index = Begin; Index < End; Index++)
+				{
+					FSearchNode Node;
+					Node.Parent = Frontier[Index].Node;
+					Expander.Expand(Frontier[Index].State, [&](const FPuzzleState& Child, const FPuzzleAction& Action, bool bGoal)
+					{
+						Node.Action = Action;
+						uint64 ChildNode;
+						if (!Visited->Add(Child, Node, ChildNode))
+							return;
+						StatesVisited++;
+						if (bGoal)
+						{
+							uint64 Expected = NoNode;
+							GoalNode.CompareExchange(Expected, ChildNode);
+						}
+						FFrontierEntry& Entry = Next.AddDefaulted_GetRef();
+						Entry.State = Child;
+						Entry.Node = ChildNode;
+					});
+				}
+			}
+		}, Solution.NumWorkers == 1);
+
+		Frontier.Reset();
+		for (TArray<FFrontierEntry>& Next : WorkerFrontiers)
+		{
+			Frontier.Append(MoveTemp(Next));
+			Next.Reset();
+		}
+	}
+
+	Solution.StatesVisited = StatesVisited.Load();
+	Solution.bSolved = GoalNode.Load() != NoNode;
+	if (Solution.bSolved)
+	{
+		for (uint64 Node = GoalNode.Load(); Visited->Get(Node).Parent != NoNode; Node = Visited->Get(Node).Parent)
+		{
+			Solution.Steps.Insert(DescribeAction(Graph, Visited->Get(Node).Action), 0);
+			Solution.StepSites.Insert(GetActionSite(Graph, Visited->Get(Node).Action), 0);
+		}
+		Solution.Steps.Add(FString::Printf(TEXT("Go to %s"), *Graph.Sites[Graph.GoalSite].Name));
+		Solution.StepSites.Add(Graph.GoalSite);
+	}
+	Solution.Seconds = FPlatformTime::Seconds() - StartTime;
+	return Solution;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCobblePuzzleSolverDropTest, "Cobble.PuzzleSolver.DropOnlyLedge", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCobblePuzzleSolverDropTest::RunTest(const FString& Parameters)
+{
+	// A pit the player can drop into but not climb out of, and a drop in front of the goal that needs a gate powered.
+	// The pit is the lowest numbered site, so it must not stand in for the start.
+	FCobblePuzzleGraph Graph;
+	for (const TCHAR* Name : { TEXT("Pit"), TEXT("Start"), TEXT("Gear"), TEXT("Holder"), TEXT("Goal") })
+		Graph.Sites.AddDefaulted_GetRef().Name = Name;
+	Graph.StartSite = 1;
+	Graph.GoalSite = 4;
+	Graph.Edges.SetNum(Graph.Sites.Num());
+	auto AddEdge = [&Graph](int32 From, int32 To, int32 RequiresPowered = INDEX_NONE)
+	{
+		FCobblePuzzleEdge& Edge = Graph.Edges[From].AddDefaulted_GetRef();
+		Edge.To = To;
+		AddRequirement(Edge, RequiresPowered);
+	};
+	AddEdge(1, 0);
+	AddEdge(1, 2);
+	AddEdge(2, 1);
+	AddEdge(1, 3);
+	AddEdge(3, 1);
+	AddEdge(3, 4, 0);
+
+	FCobblePuzzleGraph::FGear& Gear = Graph.Gears.AddDefaulted_GetRef();
+	Gear.Name = TEXT("Gear");
+	Gear.Site = 2;
+	FCobblePuzzleGraph::FHolder& Holder = Graph.Holders.AddDefaulted_GetRef();
+	Holder.Name = TEXT("Holder");
+	Holder.Site = 3;
+	Holder.Powers = 0;
+	FCobblePuzzleGraph::FPowered& Gate = Graph.Powered.AddDefaulted_GetRef();
+	Gate.Name = TEXT("Gate");
+	Gate.Holder = 0;
+
+	const FCobblePuzzleSolution Solution = FCobblePuzzleSolver::Solve(Graph, 1, 1000);
+	TestTrue(TEXT("Solved"), Solution.bSolved);
+	TestEqual(TEXT("Steps"), Solution.Steps.Num(), 3);
+	return true;
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+// How far the player can get between two places without help, used to connect the sites of a puzzle graph
+struct FCobblePuzzleReach
+{
+	// Furthest apart along the scroll axis two places can be for the player to get from one to the other
+	float MaxGap = 400;
+	// Highest the player can climb between two places, dropping down is never limited
+	float MaxJumpHeight = 250;
+};
+
+// A place the player can stand: the player start, the goal, an interactable or one end of a platform path
+struct FCobblePuzzleSite
+{
+	FString Name;
+	FVector Location = FVector::ZeroVector;
+};
+
+// The player can get from one site to another while every listed gear activated actor is powered
+struct FCobblePuzzleEdge
+{
+	int32 To = INDEX_NONE;
+	TArray<int32, TInlineAllocator<2>> RequiresPowered;
+};
+
+struct FCobblePuzzleGraph
+{
+	struct FGear
+	{
+		FString Name;
+		int32 Site = INDEX_NONE;
+		int32 StartHolder = INDEX_NONE; // Holder the gear is seated in when the level starts
+	};
+	struct FHolder
+	{
+		FString Name;
+		int32 Site = INDEX_NONE;
+		int32 Powers = INDEX_NONE; // Gear activated actor this holder belongs to
+	};
+	struct FLever
+	{
+		FString Name;
+		int32 Site = INDEX_NONE;
+	};
+	// A moving platform, or a gear activated actor tagged PuzzleGate that blocks the way past it until powered
+	struct FPowered
+	{
+		FString Name;
+		int32 Holder = INDEX_NONE;
+		bool bIsPlatform = false;
+	};
+
+	TArray<FCobblePuzzleSite> Sites;
+	TArray<TArray<FCobblePuzzleEdge>> Edges; // Outgoing edges per site
+	TArray<FGear> Gears;
+	TArray<FHolder> Holders;
+	TArray<FLever> Levers;
+	TArray<FPowered> Powered;
+	int32 StartSite = INDEX_NONE;
+	int32 GoalSite = INDEX_NONE;
+
+	int32 GetNumEdges() const;
+};
+
+struct FCobblePuzzleSolution
+{
+	bool bSolved = false;
+	// False when the search hit its state limit before finishing, so an unsolved result is not proof
+	bool bComplete = true;
+	TArray<FString> Steps;
+	// Site each step happens at, the last one is the goal
+	TArray<int32> StepSites;
+	int64 StatesVisited = 0;
+	int32 NumWorkers = 0;
+	double Seconds = 0;
+};
+
+/*
+Checks that a Cobble puzzle can be finished. ExtractGraph turns a loaded map into sites the player can move between,
+gears, gear holders, the actors they power and levers. Solve searches every arrangement of gears breadth first, one depth
+at a time, so the first solution found is one with the fewest interactions. Levers are sites only, no edge depends on them.
+In a game world, actors bound from the level manifest take their gear holder and what it powers from the manifest.
+
+Each depth is expanded by NumWorkers task graph workers that pull chunks of the frontier from a shared cursor, so a worker
+that finishes early takes over what is left instead of idling. Visited states are deduplicated in hash sharded sets, each
+with its own lock, so workers rarely wait on each other. The player's position is stored as the lowest numbered site they
+can both reach and get back from, which merges states that only differ by where the player is standing without merging
+the two sides of a drop.
+*/
+struct COBBLE_API FCobblePuzzleSolver
+{
+	// Gears, holders and sites are stored in a byte each (sites in two), ExtractGraph fails past these
+	static const int32 MaxGears = 254;
+	static const int32 MaxHolders = 254;
+	static const int32 MaxSites = 65535;
+
+	static bool ExtractGraph(UWorld* World, const FCobblePuzzleReach& Reach, FCobblePuzzleGraph& OutGraph, FString& OutError);
+	static FCobblePuzzleSolution Solve(const FCobblePuzzleGraph& Graph, int32 NumWorkers, int64 MaxStates);
+};
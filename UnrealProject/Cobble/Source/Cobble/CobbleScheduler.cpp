@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleScheduler.h"
+#include "CobbleTelemetry.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	TMap<const UWorld*, TWeakObjectPtr<ACobbleScheduler>> WorldSchedulers;
+
+	FAutoConsoleCommandWithWorld ActionsCommand(
+		TEXT("Cobble.Actions"),
+		TEXT("Lists the scheduled gameplay actions with their owner, next step and time left"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (ACobbleScheduler* Scheduler = ACobbleScheduler::Get(World, false))
+				Scheduler->LogActions();
+		}));
+}
+
+ACobbleScheduler::ACobbleScheduler()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	SetRootComponent(CreateDefaultSubobject<USceneComponent>(TEXT("Root")));
+}
+
+ACobbleScheduler* ACobbleScheduler::Get(UWorld* World, bool bCreate)
+{
+	if (World == nullptr || !World->IsGameWorld())
+		return nullptr;
+	if (ACobbleScheduler* Scheduler = WorldSchedulers.FindRef(World).Get())
+		return Scheduler;
+	if (!bCreate || World->bIsTearingDown)
+		return nullptr;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACobbleScheduler* Scheduler = World->SpawnActor<ACobbleScheduler>(SpawnParams);
+	WorldSchedulers.Add(World, Scheduler);
+	return Scheduler;
+}
+
+void ACobbleScheduler::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WorldSchedulers.Remove(GetWorld());
+	Actions.Empty();
+	OwnerActions.Empty();
+	DueHeap.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+FCobbleActionHandle ACobbleScheduler::Schedule(const UObject* Owner, FName Name, float Delay, TFunction<void()> Function)
+{
+	FCobbleActionHandle Handle;
+	Handle.Id = NextId++;
+	FAction& Action = Actions.Add(Handle.Id);
+	Action.Owner = Owner;
+	Action.OwnerKey = Owner;
+	FStep& Step = Action.Steps.AddDefaulted_GetRef();
+	Step.Name = Name;
+	Step.Delay = Delay;
+	Step.Function = MoveTemp(Function);
+	OwnerActions.Add(Owner, Handle.Id);
+	Push(Handle.Id, Action, GetTime() + FMath::Max(Delay, 0.0f));
+	return Handle;
+}
+
+bool ACobbleScheduler::Then(const FCobbleActionHandle& Handle, FName Name, float Delay, TFunction<void()> Function)
+{
+	FAction* Action = Actions.Find(Handle.Id);
+	if (Action == nullptr)
+		return false;
+	FStep& Step = Action->Steps.AddDefaulted_GetRef();
+	Step.Name = Name;
+	Step.Delay = Delay;
+	Step.Function = MoveTemp(Function);
+	return true;
+}
+
+bool ACobbleScheduler::IsActive(const FCobbleActionHandle& Handle) const
+{
+	return Handle.IsValid() && Actions.Contains(Handle.Id);
+}
+
+void ACobbleScheduler::Cancel(FCobbleActionHandle& Handle)
+{
+	if (Handle.IsValid())
+		Remove(Handle.Id);
+	Handle.Reset();
+}
+
+void ACobbleScheduler::CancelAll(const UObject* Owner)
+{
+	TArray<uint64, TInlineAllocator<4>> Ids;
+	OwnerActions.MultiFind(Owner, Ids);
+	for (uint64 Id : Ids)
+		Remove(Id);
+}
+
+void ACobbleScheduler::Push(uint64 Id, FAction& Action, double DueTime)
+{
+	Action.DueTime = DueTime;
+	Action.Sequence = NextSequence++;
+	DueHeap.HeapPush({ DueTime, Action.Sequence, Id });
+}
+
+void ACobbleScheduler::Remove(uint64 Id)
+{
+	FAction Action;
+	if (Actions.RemoveAndCopyValue(Id, Action))
+		OwnerActions.RemoveSingle(Action.OwnerKey, Id);
+
+	// Cancelled actions stay in the heap until they come up, rebuild it if they start to outnumber the live ones
+	if (DueHeap.Num() > 64 && DueHeap.Num() > 4 * Actions.Num())
+	{
+		DueHeap.Reset();
+		for (const TPair<uint64, FAction>& Pair : Actions)
+			DueHeap.Add({ Pair.Value.DueTime, Pair.Value.Sequence, Pair.Key });
+		DueHeap.Heapify();
+	}
+}
+
+double ACobbleScheduler::GetTime() const
+{
+	return GetWorld()->GetTimeSeconds();
+}
+
+void ACobbleScheduler::Tick(float DeltaTime)
+{
+	COBBLE_TELEMETRY_SCOPE(Scheduler);
+	Super::Tick(DeltaTime);
+	const double Now = GetTime();
+	// Actions scheduled while running this pass wait for the next one, even with no delay
+	const uint64 PassSequence = NextSequence;
+	while (DueHeap.Num() > 0 && DueHeap.HeapTop().DueTime <= Now && DueHeap.HeapTop().Sequence < PassSequence)
+	{
+		FDueEntry Entry;
+		DueHeap.HeapPop(Entry, false);
+		FAction* Action = Actions.Find(Entry.Id);
+		if (Action == nullptr || Action->Sequence != Entry.Sequence)
+			continue;
+		if (!Action->Owner.IsValid())
+		{
+			Remove(Entry.Id);
+			continue;
+		}
+
+		// The function can schedule, chain or cancel, which can move or remove the action
+		TFunction<void()> Function = MoveTemp(Action->Steps[Action->NextStep].Function);
+		Action->NextStep++;
+		if (Function)
+			Function();
+
+		Action = Actions.Find(Entry.Id);
+		if (Action == nullptr)
+			continue;
+		if (Action->NextStep < Action->Steps.Num())
+			Push(Entry.Id, *Action, Entry.DueTime + FMath::Max(Action->Steps[Action->NextStep].Delay, 0.0f));
+		else
+			Remove(Entry.Id);
+	}
+}
+
+void ACobbleScheduler::LogActions() const
+{
+	const double Now = GetTime();
+	UE_LOG(LogTemp, Display, TEXT("Cobble actions: %d scheduled, %d heap entries"), Actions.Num(), DueHeap.Num());
+	for (const TPair<uint64, FAction>& Pair : Actions)
+	{
+		const FAction& Action = Pair.Value;
+		const FStep& Step = Action.Steps[FMath::Min(Action.NextStep, Action.Steps.Num() - 1)];
+		UE_LOG(LogTemp, Display, TEXT("  %s: %s (step %d of %d) in %.3fs"), *GetNameSafe(Action.Owner.Get()), *Step.Name.ToString(),
+			Action.NextStep + 1, Action.Steps.Num(), Action.DueTime - Now);
+	}
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleScheduler.generated.h"
+
+// Refers to an action on the world's ACobbleScheduler. Stays safe to use after the action has run or been cancelled.
+struct FCobbleActionHandle
+{
+	uint64 Id = 0;
+
+	bool IsValid() const { return Id != 0; }
+	void Reset() { Id = 0; }
+};
+
+/**
+ * Runs short delayed gameplay actions, like waiting out an animation before jumping, for every actor in a world.
+ *
+ * An action is one or more steps, each run a delay after the one before it, so "play the pre jump animation, then jump"
+ * is one action with one handle. Due actions sit in a min heap by time and run together in one pass per frame, cancelled
+ * ones are left in the heap and skipped when they come up. Actions belong to an owner and stop when the owner goes away,
+ * CancelAll cancels everything an owner has scheduled. A step with no function just holds the action open, which is how
+ * gameplay locks that only last as long as an animation are written. Cobble.Actions lists what is scheduled.
+ */
+UCLASS(NotPlaceable)
+class COBBLE_API ACobbleScheduler : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleScheduler();
+
+	// The scheduler for a game world, spawned on first use if bCreate. nullptr outside game worlds.
+	static ACobbleScheduler* Get(UWorld* World, bool bCreate = true);
+
+	// Runs Function Delay seconds from now. Name shows up in Cobble.Actions.
+	FCobbleActionHandle Schedule(const UObject* Owner, FName Name, float Delay, TFunction<void()> Function = nullptr);
+	// Adds a step that runs Delay seconds after the last step of the action. False if the action has already finished.
+	bool Then(const FCobbleActionHandle& Handle, FName Name, float Delay, TFunction<void()> Function = nullptr);
+	bool IsActive(const FCobbleActionHandle& Handle) const;
+	void Cancel(FCobbleActionHandle& Handle);
+	void CancelAll(const UObject* Owner);
+
+	void LogActions() const;
+
+	virtual void Tick(float DeltaTime) override;
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FStep
+	{
+		FName Name;
+		float Delay = 0;
+		TFunction<void()> Function;
+	};
+	struct FAction
+	{
+		TWeakObjectPtr<const UObject> Owner;
+		const UObject* OwnerKey = nullptr; // Owner as it was when scheduled, the key in OwnerActions
+		TArray<FStep, TInlineAllocator<2>> Steps;
+		int32 NextStep = 0;
+		double DueTime = 0;
+		uint64 Sequence = 0; // Matches the heap entry that is still live for this action
+	};
+	struct FDueEntry
+	{
+		double DueTime;
+		uint64 Sequence;
+		uint64 Id;
+
+		bool operator<(const FDueEntry& Other) const
+		{
+			return DueTime < Other.DueTime || (DueTime == Other.DueTime && Sequence < Other.Sequence);
+		}
+	};
+
+	void Push(uint64 Id, FAction& Action, double DueTime);
+	void Remove(uint64 Id);
+	double GetTime() const;
+
+private:
+	TMap<uint64, FAction> Actions;
+	TMultiMap<const UObject*, uint64> OwnerActions;
+	TArray<FDueEntry> DueHeap;
+	uint64 NextId = 1;
+	uint64 NextSequence = 0;
+};
@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "CobbleSettings.generated.h"
+
+/**
+ * Project wide settings for the Cobble gameplay systems. Shows up under Project Settings > Game > Cobble.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Cobble"))
+class COBBLE_API UCobbleSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	/*
+	Networking
+	Puzzle actors are only relevant to a client while they are inside this box around its camera.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = Networking)
+	float NetRelevancyHalfWidth = 4000;
+	UPROPERTY(config, EditAnywhere, Category = Networking)
+	float NetRelevancyHalfHeight = 3000;
+
+	/*
+	Memory
+	Budgets per gameplay subsystem, see Cobble.MemReport. Zero means no budget.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = Memory)
+	int32 CharacterMemoryBudgetKB = 512;
+	UPROPERTY(config, EditAnywhere, Category = Memory)
+	int32 InteractablesMemoryBudgetKB = 4096;
+	UPROPERTY(config, EditAnywhere, Category = Memory)
+	int32 HosesMemoryBudgetKB = 2048;
+	UPROPERTY(config, EditAnywhere, Category = Memory)
+	int32 PlatformsMemoryBudgetKB = 2048;
+	// Seconds between budget checks while running with -llm. Zero turns the periodic check off.
+	UPROPERTY(config, EditAnywhere, Category = Memory)
+	float MemoryBudgetCheckInterval = 5;
+
+	/*
+	Hitches
+	Frames slower than the budget write a report of the recent gameplay events to Saved/Hitches.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = Hitches)
+	bool bEnableHitchDetector = true;
+	UPROPERTY(config, EditAnywhere, Category = Hitches)
+	float HitchBudgetMs = 50;
+	// How many frames before the hitch go in the report
+	UPROPERTY(config, EditAnywhere, Category = Hitches)
+	int32 HitchReportFrames = 60;
+	// Minimum seconds between reports, so one long stall doesn't write a report per frame
+	UPROPERTY(config, EditAnywhere, Category = Hitches)
+	float HitchReportCooldown = 5;
+
+	/*
+	Audio
+	Audio zones load this far ahead of the players along the scroll axis and unload once they are well behind.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = Audio)
+	float AudioLoadAhead = 6000;
+	UPROPERTY(config, EditAnywhere, Category = Audio)
+	float AudioKeepBehind = 1000;
+	// Extra distance past AudioKeepBehind before a zone is released
+	UPROPERTY(config, EditAnywhere, Category = Audio)
+	float AudioUnloadBehind = 3000;
+	// Estimated audio memory resident from audio zones. Zero means no budget.
+	UPROPERTY(config, EditAnywhere, Category = Audio)
+	int32 AudioResidentBudgetKB = 32768;
+
+	/*
+	Machine Audio
+	Machinery loops share a fixed pool of emitters, see ACobbleMachineAudio.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = "Machine Audio")
+	int32 MachineEmitterPoolSize = 8;
+	// Active machines closer than this can get an emitter of their own
+	UPROPERTY(config, EditAnywhere, Category = "Machine Audio")
+	float MachineAudibleDistance = 4000;
+	// Active machines closer than this without an emitter feed the ambience source
+	UPROPERTY(config, EditAnywhere, Category = "Machine Audio")
+	float MachineAmbienceDistance = 12000;
+	UPROPERTY(config, EditAnywhere, Category = "Machine Audio")
+	float MachineAudioCellSize = 2000;
+	UPROPERTY(config, EditAnywhere, Category = "Machine Audio", meta = (AllowedClasses = "AkAudioEvent"))
+	FSoftObjectPath MachineAmbienceEvent;
+	// Set on the ambience source to the combined loudness of the machines it stands in for
+	UPROPERTY(config, EditAnywhere, Category = "Machine Audio")
+	FString MachineAmbienceRTPC = TEXT("MachineryDensity");
+
+	/*
+	Level Transitions
+	The next map starts loading in the background once a player is this close to a level exit along the scroll axis.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = "Level Transitions")
+	float LevelPreloadDistance = 5000;
+
+	/*
+	Fixed Step
+	Machines simulate at a fixed rate and draw in between steps, see ACobbleFixedStep.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = "Fixed Step")
+	bool bFixedStepGameplay = false;
+	// Steps per second
+	UPROPERTY(config, EditAnywhere, Category = "Fixed Step")
+	float FixedStepRate = 60;
+	// Time a frame needs past this many steps is dropped
+	UPROPERTY(config, EditAnywhere, Category = "Fixed Step")
+	int32 MaxFixedStepsPerFrame = 4;
+
+	/*
+	Texture Streaming
+	Textures of the level ahead of each player are primed before the camera gets there, see UCobbleTextureStreaming.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = "Texture Streaming")
+	bool bPredictiveTextureStreaming = true;
+	// Half the stretch of level the camera shows along the scroll axis. Only textures past it are primed, the streamer
+	// already handles what is on screen.
+	UPROPERTY(config, EditAnywhere, Category = "Texture Streaming")
+	float TextureCameraHalfWidth = 2000;
+	UPROPERTY(config, EditAnywhere, Category = "Texture Streaming")
+	float TextureLookAhead = 3000;
+	UPROPERTY(config, EditAnywhere, Category = "Texture Streaming")
+	float TextureKeepBehind = 1000;
+	// Seconds of travel at the player's current speed added to the look ahead
+	UPROPERTY(config, EditAnywhere, Category = "Texture Streaming")
+	float TextureLeadSeconds = 1.5f;
+
+	/*
+	Physics Regions
+	Puzzle actors outside the box around every player are taken out of the physics scene, see ACobblePhysicsRegions.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = "Physics Regions")
+	bool bPrunePhysicsRegions = true;
+	UPROPERTY(config, EditAnywhere, Category = "Physics Regions")
+	float PhysicsRegionSize = 2000;
+	UPROPERTY(config, EditAnywhere, Category = "Physics Regions")
+	float PhysicsActiveHalfWidth = 5000;
+	UPROPERTY(config, EditAnywhere, Category = "Physics Regions")
+	float PhysicsActiveHalfHeight = 3000;
+	// Seconds a region stays in the physics scene after the last player left it
+	UPROPERTY(config, EditAnywhere, Category = "Physics Regions")
+	float PhysicsRegionLinger = 2;
+
+	/*
+	Telemetry
+	Frame and gameplay metrics written to Saved/Telemetry, see FCobbleTelemetry.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = Telemetry)
+	bool bEnableTelemetry = true;
+	UPROPERTY(config, EditAnywhere, Category = Telemetry)
+	float TelemetryFlushSeconds = 10;
+	// Size the file rotates at
+	UPROPERTY(config, EditAnywhere, Category = Telemetry)
+	int32 TelemetryMaxFileKB = 1024;
+	// Including the one being written
+	UPROPERTY(config, EditAnywhere, Category = Telemetry)
+	int32 TelemetryMaxFiles = 4;
+	// Local port to serve the totals on for a collector to scrape, 0 for none
+	UPROPERTY(config, EditAnywhere, Category = Telemetry)
+	int32 TelemetryPort = 0;
+	// Game thread microseconds per frame telemetry may cost
+	UPROPERTY(config, EditAnywhere, Category = Telemetry)
+	float TelemetryOverheadBudgetUs = 50;
+
+	/*
+	Level Manifests
+	Puzzle actors are set up from their level's baked manifest in one pass, see ACobbleManifestBinding and
+	UCobbleLevelManifestCommandlet.
+	*/
+	UPROPERTY(config, EditAnywhere, Category = "Level Manifests")
+	bool bUseLevelManifests = true;
+	// Where the manifests are saved and loaded from, it must be cooked, see DirectoriesToAlwaysCook
+	UPROPERTY(config, EditAnywhere, Category = "Level Manifests")
+	FString LevelManifestPath = TEXT("/Game/Manifests");
+};
\ No newline at end of file
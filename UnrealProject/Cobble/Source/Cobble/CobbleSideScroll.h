@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+/*
+Helpers for the side scrolling layout of Cobble levels.
+The player runs along their actor forward vector (the sprite is flipped, not the actor), so that is the axis the camera follows.
+*/
+struct FCobbleSideScroll
+{
+	// Axis the camera scrolls along, flattened so jumping doesn't change it
+	static FVector GetScrollAxis(const AActor* Viewer)
+	{
+		if (Viewer != nullptr)
+		{
+			FVector Axis = Viewer->GetActorForwardVector();
+			Axis.Z = 0;
+			if (Axis.Normalize())
+				return Axis;
+		}
+		return FVector::ForwardVector;
+	}
+
+	// How far along the scroll axis Location is, measured from Origin
+	static float GetDistanceAlongAxis(const FVector& Axis, const FVector& Origin, const FVector& Location)
+	{
+		return FVector::DotProduct(Location - Origin, Axis);
+	}
+
+	// True if Location is inside the box of the level the camera can see, ignoring depth into the screen
+	static bool IsInCameraArea(const FVector& Axis, const FVector& CameraLocation, const FVector& Location, float HalfWidth, float HalfHeight)
+	{
+		return FMath::Abs(GetDistanceAlongAxis(Axis, CameraLocation, Location)) <= HalfWidth
+			&& FMath::Abs(Location.Z - CameraLocation.Z) <= HalfHeight;
+	}
+};
@@ -0,0 +1,490 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleSpriteAtlasCommandlet.h"
+#include "CobbleLevelAuditCommandlet.h"
+#include "PaperSprite.h"
+#include "PaperFlipbook.h"
+#include "AssetRegistryModule.h"
+#include "Engine/Level.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+#include "UObject/UnrealType.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCobbleAtlas, Log, All);
+
+namespace
+{
+	const TCHAR* SharedGroup = TEXT("Shared");
+
+	void AddSpriteOrFlipbook(UObject* Value, TSet<UPaperSprite*>& OutSprites)
+	{
+		if (UPaperSprite* Sprite = Cast<UPaperSprite>(Value))
+		{
+			OutSprites.Add(Sprite);
+		}
+		else if (UPaperFlipbook* Flipbook = Cast<UPaperFlipbook>(Value))
+		{
+			for (int32 i = 0; i < Flipbook->GetNumKeyFrames(); i++)
+			{
+				if (UPaperSprite* Frame = Flipbook->GetKeyFrameChecked(i).Sprite)
+					OutSprites.Add(Frame);
+			}
+		}
+	}
+
+	void GatherProperties(UObject* Object, TSet<UPaperSprite*>& OutSprites)
+	{
+		for (TFieldIterator<UProperty> It(Object->GetClass()); It; ++It)
+		{
+			if (UObjectProperty* ObjectProperty = Cast<UObjectProperty>(*It))
+			{
+				AddSpriteOrFlipbook(ObjectProperty->GetObjectPropertyValue_InContainer(Object), OutSprites);
+			}
+			else if (UArrayProperty* ArrayProperty = Cast<UArrayProperty>(*It))
+			{
+				UObjectProperty* Inner = Cast<UObjectProperty>(ArrayProperty->Inner);
+				if (Inner == nullptr)
+					continue;
+				FScriptArrayHelper_InContainer Array(ArrayProperty, Object);
+				for (int32 i = 0; i < Array.Num(); i++)
+					AddSpriteOrFlipbook(Inner->GetObjectPropertyValue(Array.GetRawPtr(i)), OutSprites);
+			}
+		}
+	}
+
+	// Sprites can only share an atlas if their textures would have been imported the same way
+	FString GetSettingsKey(const UTexture2D* Texture)
+	{
+		return FString::Printf(TEXT("%d_%d_%d_%d"), Texture->SRGB ? 1 : 0, (int32)Texture->Filter, (int32)Texture->CompressionSettings, (int32)Texture->LODGroup);
+	}
+}
+
+UCobbleSpriteAtlasCommandlet::UCobbleSpriteAtlasCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCobbleSpriteAtlasCommandlet::Main(const FString& Params)
+{
+	FString OutputDir = FPaths::ProjectSavedDir() / TEXT("Atlases");
+	FParse::Value(*Params, TEXT("Output="), OutputDir);
+	const bool bDryRun = FParse::Param(*Params, TEXT("DryRun"));
+	int32 NumErrors = 0;
+
+	// Each sprite belongs to the one map or character that uses it, or to the shared group when several do
+	TMap<UPaperSprite*, FString> SpriteGroups;
+	TArray<FString> GroupNames;
+	auto AddGroup = [&](const FString& GroupName, const TSet<UPaperSprite*>& Sprites)
+	{
+		GroupNames.AddUnique(GroupName);
+		for (UPaperSprite* Sprite : Sprites)
+		{
+			FString* Existing = SpriteGroups.Find(Sprite);
+			if (Existing == nullptr)
+			{
+				SpriteGroups.Add(Sprite, GroupName);
+				GatheredSprites.Add(Sprite);
+			}
+			else if (*Existing != GroupName)
+			{
+				*Existing = SharedGroup;
+				GroupNames.AddUnique(SharedGroup);
+			}
+		}
+	};
+
+	for (const FString& MapPackageName : UCobbleLevelAuditCommandlet::FindMapPackages(Params))
+	{
+		UWorld* World = UCobbleLevelAuditCommandlet::LoadMap(MapPackageName);
+		if (World == nullptr)
+		{
+			UE_LOG(LogCobbleAtlas, Error, TEXT("Could not load %s"), *MapPackageName);
+			NumErrors++;
+			continue;
+		}
+		TSet<UPaperSprite*> Sprites;
+		for (ULevel* Level : World->GetLevels())
+		{
+			for (AActor* Actor : Level->Actors)
+			{
+				if (Actor != nullptr && !Actor->IsPendingKill())
+					GatherSprites(Actor, Sprites);
+			}
+		}
+		AddGroup(FPackageName::GetShortName(MapPackageName), Sprites);
+		UCobbleLevelAuditCommandlet::UnloadMap(World);
+	}
+	for (const TSoftClassPtr<AActor>& CharacterClass : CharacterClasses)
+	{
+		UClass* Class = CharacterClass.LoadSynchronous();
+		if (Class == nullptr)
+		{
+			UE_LOG(LogCobbleAtlas, Error, TEXT("Could not load character class %s"), *CharacterClass.ToString());
+			NumErrors++;
+			continue;
+		}
+		TSet<UPaperSprite*> Sprites;
+		GatherSprites(Class->GetDefaultObject(), Sprites);
+		FString GroupName = Class->GetName();
+		GroupName.RemoveFromEnd(TEXT("_C"));
+		AddGroup(GroupName, Sprites);
+	}
+
+	TMap<FString, TMap<FString, TArray<FPackedSprite>>> Buckets;
+	int32 NumSkipped = 0;
+	for (const TPair<UPaperSprite*, FString>& Pair : SpriteGroups)
+	{
+		FString Reason;
+		if (!CanPack(Pair.Key, Reason))
+		{
+			UE_LOG(LogCobbleAtlas, Display, TEXT("Skipping %s: %s"), *Pair.Key->GetPathName(), *Reason);
+			NumSkipped++;
+			continue;
+		}
+#if WITH_EDITOR
+		FPackedSprite Packed;
+		Packed.Sprite = Pair.Key;
+		Packed.SourceMin = FIntPoint(FMath::RoundToInt(Pair.Key->GetSourceUV().X), FMath::RoundToInt(Pair.Key->GetSourceUV().Y));
+		Packed.Size = FIntPoint(FMath::RoundToInt(Pair.Key->GetSourceSize().X), FMath::RoundToInt(Pair.Key->GetSourceSize().Y));
+		Buckets.FindOrAdd(Pair.Value).FindOrAdd(GetSettingsKey(Pair.Key->GetSourceTexture())).Add(Packed);
+#endif
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FString Csv = TEXT("Group,Sprites,TexturesBefore,BytesBefore,TexturesAfter,BytesAfter\n");
+	FGroupResult Total;
+	Total.Name = TEXT("Total");
+	TSet<UObject*> SpritesToSave;
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("DryRun"), bDryRun);
+	Writer->WriteValue(TEXT("SkippedSprites"), NumSkipped);
+	Writer->WriteArrayStart(TEXT("Groups"));
+	GroupNames.Sort();
+	for (const FString& GroupName : GroupNames)
+	{
+		const TMap<FString, TArray<FPackedSprite>>* GroupBuckets = Buckets.Find(GroupName);
+		if (GroupBuckets == nullptr)
+			continue;
+
+		FGroupResult Result;
+		Result.Name = GroupName;
+		TSet<UTexture2D*> SourceTextures;
+		int32 PageIndex = 0;
+		for (const TPair<FString, TArray<FPackedSprite>>& Bucket : *GroupBuckets)
+		{
+#if WITH_EDITOR
+			TArray<FPackedSprite> Sprites = Bucket.Value;
+			for (const FPackedSprite& Packed : Sprites)
+				SourceTextures.Add(Packed.Sprite->GetSourceTexture());
+			const UTexture2D* Template = Sprites[0].Sprite->GetSourceTexture();
+			const TArray<FIntPoint> PageSizes = Pack(Sprites);
+			Result.NumSprites += Sprites.Num();
+			for (int32 Page = 0; Page < PageSizes.Num(); Page++, PageIndex++)
+			{
+				Result.TexturesAfter++;
+				Result.BytesAfter += EstimateTextureBytes(Template, PageSizes[Page]);
+				if (bDryRun)
+					continue;
+
+				const FString AssetName = FString::Printf(TEXT("Atlas_%s_%d"), *GroupName, PageIndex);
+				UTexture2D* Atlas = BakePage(AssetName, PageSizes[Page], Page, Sprites);
+				if (Atlas == nullptr || !UCobbleLevelAuditCommandlet::SaveAsset(Atlas))
+				{
+					UE_LOG(LogCobbleAtlas, Error, TEXT("Could not save %s"), *AssetName);
+					NumErrors++;
+					continue;
+				}
+				for (const FPackedSprite& Packed : Sprites)
+				{
+					if (Packed.Page != Page)
+						continue;
+					if (BakeSprite(Packed.Sprite, Atlas, Packed.AtlasMin, Packed.Size))
+					{
+						SpritesToSave.Add(Packed.Sprite);
+					}
+					else
+					{
+						UE_LOG(LogCobbleAtlas, Error, TEXT("Could not bake %s into %s"), *Packed.Sprite->GetPathName(), *AssetName);
+						NumErrors++;
+					}
+				}
+			}
+#endif
+		}
+		for (const UTexture2D* Texture : SourceTextures)
+		{
+			Result.TexturesBefore++;
+			Result.BytesBefore += EstimateTextureBytes(Texture, FIntPoint(Texture->Source.GetSizeX(), Texture->Source.GetSizeY()));
+		}
+
+		UE_LOG(LogCobbleAtlas, Display, TEXT("%s: %d sprites from %d textures (%lld KB) into %d atlases (%lld KB)"), *GroupName,
+			Result.NumSprites, Result.TexturesBefore, Result.BytesBefore / 1024, Result.TexturesAfter, Result.BytesAfter / 1024);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Group"), GroupName);
+		Writer->WriteValue(TEXT("Sprites"), Result.NumSprites);
+		Writer->WriteValue(TEXT("TexturesBefore"), Result.TexturesBefore);
+		Writer->WriteValue(TEXT("BytesBefore"), Result.BytesBefore);
+		Writer->WriteValue(TEXT("TexturesAfter"), Result.TexturesAfter);
+		Writer->WriteValue(TEXT("BytesAfter"), Result.BytesAfter);
+		Writer->WriteObjectEnd();
+		Csv += FString::Printf(TEXT("%s,%d,%d,%lld,%d,%lld\n"), *GroupName, Result.NumSprites, Result.TexturesBefore, Result.BytesBefore,
+			Result.TexturesAfter, Result.BytesAfter);
+
+		Total.NumSprites += Result.NumSprites;
+		Total.TexturesBefore += Result.TexturesBefore;
+		Total.BytesBefore += Result.BytesBefore;
+		Total.TexturesAfter += Result.TexturesAfter;
+		Total.BytesAfter += Result.BytesAfter;
+	}
+	Writer->WriteArrayEnd();
+
+	for (UObject* Sprite : SpritesToSave)
+	{
+		if (!UCobbleLevelAuditCommandlet::SaveAsset(Sprite))
+		{
+			UE_LOG(LogCobbleAtlas, Error, TEXT("Could not save %s"), *Sprite->GetPathName());
+			NumErrors++;
+		}
+	}
+
+	Writer->WriteValue(TEXT("BytesSaved"), Total.BytesBefore - Total.BytesAfter);
+	Writer->WriteValue(TEXT("Errors"), NumErrors);
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	Csv += FString::Printf(TEXT("%s,%d,%d,%lld,%d,%lld\n"), *Total.Name, Total.NumSprites, Total.TexturesBefore, Total.BytesBefore,
+		Total.TexturesAfter, Total.BytesAfter);
+	FFileHelper::SaveStringToFile(Json, *(OutputDir / TEXT("SpriteAtlases.json")));
+	FFileHelper::SaveStringToFile(Csv, *(OutputDir / TEXT("SpriteAtlases.csv")));
+
+	UE_LOG(LogCobbleAtlas, Display, TEXT("%d sprites, %d textures (%lld KB) before, %d atlases (%lld KB) after, %d skipped, %d errors"),
+		Total.NumSprites, Total.TexturesBefore, Total.BytesBefore / 1024, Total.TexturesAfter, Total.BytesAfter / 1024, NumSkipped, NumErrors);
+	GatheredSprites.Empty();
+	return NumErrors > 0 ? 1 : 0;
+}
+
+void UCobbleSpriteAtlasCommandlet::GatherSprites(UObject* Object, TSet<UPaperSprite*>& OutSprites)
+{
+	GatherProperties(Object, OutSprites);
+	if (AActor* Actor = Cast<AActor>(Object))
+	{
+		TInlineComponentArray<UActorComponent*> Components(Actor);
+		for (UActorComponent* Component : Components)
+			GatherProperties(Component, OutSprites);
+	}
+}
+
+bool UCobbleSpriteAtlasCommandlet::CanPack(UPaperSprite* Sprite, FString& OutReason) const
+{
+#if WITH_EDITOR
+	const UTexture2D* Texture = Sprite->GetSourceTexture();
+	const FVector2D Size = Sprite->GetSourceSize();
+	if (!Sprite->GetOutermost()->GetName().StartsWith(TEXT("/Game/")))
+		OutReason = TEXT("not project content");
+	else if (Texture == nullptr)
+		OutReason = TEXT("no source texture");
+	else if (Texture->Source.GetFormat() != TSF_BGRA8 || Texture->Source.GetNumSlices() != 1)
+		OutReason = TEXT("source art is not 8 bit BGRA");
+	else if (Size.X < 1 || Size.Y < 1 || FMath::Max(Size.X, Size.Y) + Padding * 2 > MaxAtlasSize)
+		OutReason = FString::Printf(TEXT("%dx%d does not fit an atlas"), FMath::RoundToInt(Size.X), FMath::RoundToInt(Size.Y));
+	return OutReason.IsEmpty();
+#else
+	OutReason = TEXT("needs editor data");
+	return false;
+#endif
+}
+
+TArray<FIntPoint> UCobbleSpriteAtlasCommandlet::Pack(TArray<FPackedSprite>& Sprites) const
+{
+	struct FShelf
+	{
+		int32 Y = 0;
+		int32 Height = 0;
+		int32 Used = 0;
+	};
+	struct FPage
+	{
+		TArray<FShelf> Shelves;
+		int32 Height = 0;
+		int32 Width = 0;
+	};
+
+	// Tallest first so each shelf is filled with sprites of about its own height
+	Sprites.Sort([](const FPackedSprite& A, const FPackedSprite& B)
+	{
+		return A.Size.Y != B.Size.Y ? A.Size.Y > B.Size.Y : A.Size.X > B.Size.X;
+	});
+
+	TArray<FPage> Pages;
+	for (FPackedSprite& Sprite : Sprites)
+	{
+		const FIntPoint Padded = Sprite.Size + FIntPoint(Padding * 2, Padding * 2);
+		FIntPoint Placed(INDEX_NONE, INDEX_NONE);
+		for (int32 PageIndex = 0; PageIndex < Pages.Num() && Placed.X == INDEX_NONE; PageIndex++)
+		{
+			FPage& Page = Pages[PageIndex];
+			for (FShelf& Shelf : Page.Shelves)
+			{
+				if (Shelf.Height >= Padded.Y && Shelf.Used + Padded.X <= MaxAtlasSize)
+				{
+					Placed = FIntPoint(Shelf.Used, Shelf.Y);
+					Shelf.Used += Padded.X;
+					break;
+				}
+			}
+			if (Placed.X == INDEX_NONE && Page.Height + Padded.Y <= MaxAtlasSize)
+			{
+				FShelf& Shelf = Page.Shelves.AddDefaulted_GetRef();
+				Shelf.Y = Page.Height;
+				Shelf.Height = Padded.Y;
+				Shelf.Used = Padded.X;
+				Page.Height += Padded.Y;
+				Placed = FIntPoint(0, Shelf.Y);
+			}
+			if (Placed.X != INDEX_NONE)
+			{
+				Sprite.Page = PageIndex;
+				Page.Width = FMath::Max(Page.Width, Placed.X + Padded.X);
+			}
+		}
+		if (Placed.X == INDEX_NONE)
+		{
+			FPage& Page = Pages.AddDefaulted_GetRef();
+			FShelf& Shelf = Page.Shelves.AddDefaulted_GetRef();
+			Shelf.Height = Padded.Y;
+			Shelf.Used = Padded.X;
+			Page.Height = Padded.Y;
+			Page.Width = Padded.X;
+			Placed = FIntPoint::ZeroValue;
+			Sprite.Page = Pages.Num() - 1;
+		}
+		Sprite.AtlasMin = Placed + FIntPoint(Padding, Padding);
+	}
+
+	// Power of two pages so the atlases keep their mips and stream like any other texture
+	TArray<FIntPoint> PageSizes;
+	for (const FPage& Page : Pages)
+		PageSizes.Add(FIntPoint(FMath::RoundUpToPowerOfTwo(Page.Width), FMath::RoundUpToPowerOfTwo(Page.Height)));
+	return PageSizes;
+}
+
+UTexture2D* UCobbleSpriteAtlasCommandlet::BakePage(const FString& AssetName, const FIntPoint& PageSize, int32 Page, const TArray<FPackedSprite>& Sprites) const
+{
+#if WITH_EDITOR
+	TArray<uint8> Pixels;
+	Pixels.SetNumZeroed(PageSize.X * PageSize.Y * 4);
+	UTexture2D* Template = nullptr;
+	for (const FPackedSprite& Packed : Sprites)
+	{
+		if (Packed.Page != Page)
+			continue;
+		UTexture2D* Source = Packed.Sprite->GetSourceTexture();
+		Template = Template != nullptr ? Template : Source;
+		const int32 SourceWidth = Source->Source.GetSizeX();
+		const int32 SourceHeight = Source->Source.GetSizeY();
+		const uint8* SourcePixels = Source->Source.LockMip(0);
+		if (SourcePixels == nullptr)
+			return nullptr;
+		// The padding repeats the sprite's edge pixels
+		for (int32 Y = -Padding; Y < Packed.Size.Y + Padding; Y++)
+		{
+			const int32 SourceY = FMath::Clamp(Packed.SourceMin.Y + FMath::Clamp(Y, 0, Packed.Size.Y - 1), 0, SourceHeight - 1);
+			for (int32 X = -Padding; X < Packed.Size.X + Padding; X++)
+			{
+				const int32 SourceX = FMath::Clamp(Packed.SourceMin.X + FMath::Clamp(X, 0, Packed.Size.X - 1), 0, SourceWidth - 1);
+				const int32 AtlasIndex = ((Packed.AtlasMin.Y + Y) * PageSize.X + Packed.AtlasMin.X + X) * 4;
+				FMemory::Memcpy(&Pixels[AtlasIndex], &SourcePixels[(SourceY * SourceWidth + SourceX) * 4], 4);
+			}
+		}
+		Source->Source.UnlockMip(0);
+	}
+	if (Template == nullptr)
+		return nullptr;
+
+	const FString PackageName = OutputPath / AssetName;
+	UPackage* Package = CreatePackage(nullptr, *PackageName);
+	Package->FullyLoad();
+	UTexture2D* Atlas = FindObject<UTexture2D>(Package, *AssetName);
+	const bool bCreated = Atlas == nullptr;
+	if (bCreated)
+		Atlas = NewObject<UTexture2D>(Package, *AssetName, RF_Public | RF_Standalone);
+
+	Atlas->Modify();
+	Atlas->Source.Init(PageSize.X, PageSize.Y, 1, 1, TSF_BGRA8, Pixels.GetData());
+	Atlas->SRGB = Template->SRGB;
+	Atlas->Filter = Template->Filter;
+	Atlas->CompressionSettings = Template->CompressionSettings;
+	Atlas->CompressionNoAlpha = false;
+	Atlas->LODGroup = Template->LODGroup;
+	Atlas->MipGenSettings = Template->MipGenSettings;
+	Atlas->AddressX = TA_Clamp;
+	Atlas->AddressY = TA_Clamp;
+	Atlas->PostEditChange();
+	if (bCreated)
+		FAssetRegistryModule::AssetCreated(Atlas);
+	return Atlas;
+#else
+	return nullptr;
+#endif
+}
+
+bool UCobbleSpriteAtlasCommandlet::BakeSprite(UPaperSprite* Sprite, UTexture2D* Atlas, const FIntPoint& AtlasMin, const FIntPoint& Size)
+{
+#if WITH_EDITOR
+	// The baked texture is what Paper2D's own atlas groups write, it has no setter outside the Paper2D editor module
+	UObjectProperty* TextureProperty = FindField<UObjectProperty>(UPaperSprite::StaticClass(), TEXT("BakedSourceTexture"));
+	UStructProperty* UVProperty = FindField<UStructProperty>(UPaperSprite::StaticClass(), TEXT("BakedSourceUV"));
+	UStructProperty* DimensionProperty = FindField<UStructProperty>(UPaperSprite::StaticClass(), TEXT("BakedSourceDimension"));
+	if (TextureProperty == nullptr || UVProperty == nullptr || DimensionProperty == nullptr)
+		return false;
+
+	Sprite->Modify();
+	TextureProperty->SetObjectPropertyValue_InContainer(Sprite, Atlas);
+	*UVProperty->ContainerPtrToValuePtr<FVector2D>(Sprite) = FVector2D(AtlasMin);
+	*DimensionProperty->ContainerPtrToValuePtr<FVector2D>(Sprite) = FVector2D(Size);
+	Sprite->RebuildRenderData();
+	Sprite->MarkPackageDirty();
+	return true;
+#else
+	return false;
+#endif
+}
+
+int64 UCobbleSpriteAtlasCommandlet::EstimateTextureBytes(const UTexture2D* Texture, const FIntPoint& Size)
+{
+	int64 Bytes = (int64)Size.X * Size.Y;
+	switch (Texture->CompressionSettings)
+	{
+	case TC_EditorIcon:
+	case TC_VectorDisplacementmap:
+		Bytes *= 4; // BGRA8
+		break;
+	case TC_HDR:
+	case TC_HDR_Compressed:
+		Bytes *= 8;
+		break;
+	case TC_Grayscale:
+	case TC_Alpha:
+	case TC_Displacementmap:
+		break;
+	default:
+		Bytes = Texture->CompressionNoAlpha ? Bytes / 2 : Bytes; // DXT1 or DXT5
+		break;
+	}
+#if WITH_EDITORONLY_DATA
+	if (Texture->MipGenSettings == TMGS_NoMipmaps)
+		return Bytes;
+#endif
+	return Bytes * 4 / 3;
+}
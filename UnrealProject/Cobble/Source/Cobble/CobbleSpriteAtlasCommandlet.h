@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CobbleSpriteAtlasCommandlet.generated.h"
+
+class UPaperSprite;
+class UTexture2D;
+
+/**
+ * Packs the sprites each map and each character uses into atlas textures and bakes the sprites to draw from them, so a level
+ * binds a handful of textures instead of one per sprite and sprites that share an atlas can batch. Sprites used by more than
+ * one map or character go into a shared atlas. Only sprites under /Game with 8 bit BGRA source art are packed, anything else
+ * keeps its own texture and is listed as skipped.
+ *
+ * Atlases are saved as /Game/Art/Atlases/Atlas_<Group>_<Page>. Sprites keep their source texture and region for editing, only
+ * their baked texture and UVs change, so running again after art changes rebuilds everything from the source textures.
+ * SpriteAtlases.json and SpriteAtlases.csv list the texture count and estimated memory of each group before and after.
+ * Run it before cooking, it only needs the editor binaries and works headless:
+ *
+ * UE4Editor-Cmd Cobble.uproject -run=CobbleSpriteAtlas -unattended -nopause -nullrhi [-Maps=Lvl_A,Lvl_B] [-Output=Dir] [-DryRun]
+ * -DryRun packs and reports without saving anything. Output defaults to Saved/Atlases.
+ */
+UCLASS(config = Game)
+class COBBLE_API UCobbleSpriteAtlasCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCobbleSpriteAtlasCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+public:
+	// Width and height limit of one atlas page
+	UPROPERTY(config)
+	int32 MaxAtlasSize = 2048;
+	// Pixels around each sprite filled with its edge, so filtering and mips don't pick up the neighbouring sprite
+	UPROPERTY(config)
+	int32 Padding = 2;
+	UPROPERTY(config)
+	FString OutputPath = TEXT("/Game/Art/Atlases");
+	// Characters are spawned by the game mode rather than placed in maps, so their sprites are gathered from these
+	UPROPERTY(config)
+	TArray<TSoftClassPtr<AActor>> CharacterClasses;
+
+private:
+	struct FPackedSprite
+	{
+		UPaperSprite* Sprite = nullptr;
+		FIntPoint SourceMin = FIntPoint::ZeroValue;
+		FIntPoint Size = FIntPoint::ZeroValue;
+		int32 Page = 0;
+		FIntPoint AtlasMin = FIntPoint::ZeroValue;
+	};
+	struct FGroupResult
+	{
+		FString Name;
+		int32 NumSprites = 0;
+		int32 TexturesBefore = 0;
+		int64 BytesBefore = 0;
+		int32 TexturesAfter = 0;
+		int64 BytesAfter = 0;
+	};
+
+	// Sprites referenced by the object's properties, or by its components' properties for an actor, including flipbook frames
+	static void GatherSprites(UObject* Object, TSet<UPaperSprite*>& OutSprites);
+	bool CanPack(UPaperSprite* Sprite, FString& OutReason) const;
+	// Shelf packs the sprites into pages no bigger than MaxAtlasSize, returns the size of each page
+	TArray<FIntPoint> Pack(TArray<FPackedSprite>& Sprites) const;
+	UTexture2D* BakePage(const FString& AssetName, const FIntPoint& PageSize, int32 Page, const TArray<FPackedSprite>& Sprites) const;
+	static bool BakeSprite(UPaperSprite* Sprite, UTexture2D* Atlas, const FIntPoint& AtlasMin, const FIntPoint& Size);
+	// Rough cooked size of a texture with the settings of Texture, mips included
+	static int64 EstimateTextureBytes(const UTexture2D* Texture, const FIntPoint& Size);
+
+private:
+	// Keeps the sprites of unloaded maps around until they are baked
+	UPROPERTY(Transient)
+	TArray<UPaperSprite*> GatheredSprites;
+};
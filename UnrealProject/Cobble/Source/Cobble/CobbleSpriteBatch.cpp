@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleSpriteBatch.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "PaperSprite.h"
+#include "PaperSpriteComponent.h"
+
+namespace
+{
+	TMap<TWeakObjectPtr<ULevel>, TWeakObjectPtr<ACobbleSpriteBatch>> LevelBatches;
+
+	TAutoConsoleVariable<int32> CVarSpriteBatching(
+		TEXT("Cobble.SpriteBatching"),
+		1,
+		TEXT("Draw static puzzle sprites through one grouped sprite component per level. Only affects sprites merged after it changes."));
+}
+
+ACobbleSpriteBatch::ACobbleSpriteBatch()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	Batch = CreateDefaultSubobject<UPaperGroupedSpriteComponent>(TEXT("Batch"));
+	Batch->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Batch->SetGenerateOverlapEvents(false);
+	SetRootComponent(Batch);
+}
+
+void ACobbleSpriteBatch::Merge(UPaperSpriteComponent* Sprite)
+{
+	if (CVarSpriteBatching.GetValueOnGameThread() == 0 || !CanMerge(Sprite) || IsMerged(Sprite))
+		return;
+	if (ACobbleSpriteBatch* LevelBatch = GetForLevel(Sprite->GetComponentLevel(), true))
+		LevelBatch->AddSprite(Sprite);
+}
+
+void ACobbleSpriteBatch::Split(UPaperSpriteComponent* Sprite)
+{
+	if (Sprite == nullptr || !IsMerged(Sprite))
+		return;
+	if (ACobbleSpriteBatch* LevelBatch = GetForLevel(Sprite->GetComponentLevel(), false))
+		LevelBatch->RemoveSprite(Sprite);
+}
+
+bool ACobbleSpriteBatch::IsMerged(const UPaperSpriteComponent* Sprite)
+{
+	ACobbleSpriteBatch* LevelBatch = Sprite != nullptr ? GetForLevel(Sprite->GetComponentLevel(), false) : nullptr;
+	return LevelBatch != nullptr && LevelBatch->MergedSpriteSet.Contains(Sprite);
+}
+
+bool ACobbleSpriteBatch::CanMerge(const UPaperSpriteComponent* Sprite)
+{
+	if (Sprite == nullptr || Sprite->GetSprite() == nullptr || !Sprite->IsVisible() || Sprite->GetComponentLevel() == nullptr)
+		return false;
+	UWorld* World = Sprite->GetWorld();
+	if (World == nullptr || !World->IsGameWorld() || World->GetNetMode() == NM_DedicatedServer)
+		return false;
+	for (const USceneComponent* Parent = Sprite->GetAttachParent(); Parent != nullptr; Parent = Parent->GetAttachParent())
+	{
+		if (Parent->GetOwner() != Sprite->GetOwner() && Parent->Mobility != EComponentMobility::Static)
+			return false;
+	}
+	// The batch draws every instance with its sprite's default material
+	return Sprite->GetMaterial(0) == Sprite->GetSprite()->GetDefaultMaterial();
+}
+
+ACobbleSpriteBatch* ACobbleSpriteBatch::GetForLevel(ULevel* Level, bool bCreate)
+{
+	if (Level == nullptr)
+		return nullptr;
+	if (ACobbleSpriteBatch* LevelBatch = LevelBatches.FindRef(Level).Get())
+		return LevelBatch;
+	UWorld* World = Level->GetWorld();
+	if (!bCreate || World == nullptr || World->bIsTearingDown)
+		return nullptr;
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.OverrideLevel = Level;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACobbleSpriteBatch* LevelBatch = World->SpawnActor<ACobbleSpriteBatch>(SpawnParams);
+	LevelBatches.Add(Level, LevelBatch);
+	return LevelBatch;
+}
+
+void ACobbleSpriteBatch::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	LevelBatches.Remove(GetLevel());
+	for (const TWeakObjectPtr<UPaperSpriteComponent>& Sprite : MergedSprites)
+	{
+		if (Sprite.IsValid())
+			Sprite->SetVisibility(true);
+	}
+	MergedSprites.Reset();
+	MergedSpriteSet.Reset();
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACobbleSpriteBatch::AddSprite(UPaperSpriteComponent* Sprite)
+{
+	Batch->AddInstance(Sprite->GetComponentTransform(), Sprite->GetSprite(), true, Sprite->GetSpriteColor());
+	MergedSprites.Add(Sprite);
+	MergedSpriteSet.Add(Sprite);
+	// No scene proxy while invisible, collision and overlaps are unaffected
+	Sprite->SetVisibility(false);
+}
+
+void ACobbleSpriteBatch::RemoveSprite(UPaperSpriteComponent* Sprite)
+{
+	const int32 Index = MergedSprites.IndexOfByKey(Sprite);
+	if (Index != INDEX_NONE)
+	{
+		Batch->RemoveInstance(Index);
+		MergedSprites.RemoveAt(Index);
+	}
+	MergedSpriteSet.Remove(Sprite);
+	Sprite->SetVisibility(true);
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CobbleSpriteBatch.generated.h"
+
+class UPaperGroupedSpriteComponent;
+class UPaperSpriteComponent;
+
+/**
+ * Draws the static sprites of one level (or sublevel) as instances of a single grouped sprite component, so idle puzzle
+ * sprites share one scene proxy and a draw call per material instead of one each.
+ *
+ * Merge hides a sprite component's rendering (its collision stays) and adds an instance in its place. Anything about to
+ * hide, move, rotate or swap a merged sprite must Split it first, which gives the sprite back its own component. Merge it
+ * again once it is still. A sprite attached under another actor's movable component is never merged, since that actor can
+ * move it without splitting it. One batch actor is spawned per level on first use and goes away with the level.
+ */
+UCLASS(NotPlaceable, Transient)
+class COBBLE_API ACobbleSpriteBatch : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACobbleSpriteBatch();
+
+	static void Merge(UPaperSpriteComponent* Sprite);
+	static void Split(UPaperSpriteComponent* Sprite);
+	static bool IsMerged(const UPaperSpriteComponent* Sprite);
+
+	int32 GetNumMergedSprites() const { return MergedSprites.Num(); }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	static ACobbleSpriteBatch* GetForLevel(ULevel* Level, bool bCreate);
+	static bool CanMerge(const UPaperSpriteComponent* Sprite);
+	void AddSprite(UPaperSpriteComponent* Sprite);
+	void RemoveSprite(UPaperSpriteComponent* Sprite);
+
+private:
+	UPROPERTY(VisibleAnywhere)
+	UPaperGroupedSpriteComponent* Batch;
+	// Instance index is the index in this array
+	TArray<TWeakObjectPtr<UPaperSpriteComponent>> MergedSprites;
+	TSet<TWeakObjectPtr<const UPaperSpriteComponent>> MergedSpriteSet;
+};
@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleStressLevelCommandlet.h"
+#include "CobbleLevelAuditCommandlet.h"
+#include "Gear.h"
+#include "GearHolder.h"
+#include "CobbleGearHolderComponent.h"
+#include "Lever.h"
+#include "MoveableBox.h"
+#include "MovingPlatform.h"
+#include "Components/SplineComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerStart.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCobbleStress, Log, All);
+
+UCobbleStressLevelCommandlet::UCobbleStressLevelCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCobbleStressLevelCommandlet::Main(const FString& Params)
+{
+	FString OutputPath = TEXT("/Game/Stress");
+	FString DensityList = TEXT("10,100");
+	FString LayoutList = TEXT("Grid");
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Density="), DensityList, false);
+	FParse::Value(*Params, TEXT("Layout="), LayoutList, false);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	TArray<FString> Densities;
+	TArray<FString> Layouts;
+	DensityList.ParseIntoArray(Densities, TEXT(","));
+	LayoutList.ParseIntoArray(Layouts, TEXT(","));
+
+	int32 NumFailed = 0;
+	for (const FString& LayoutName : Layouts)
+	{
+		const int64 LayoutValue = StaticEnum<ECobbleStressLayout>()->GetValueByNameString(LayoutName);
+		if (LayoutValue == INDEX_NONE)
+		{
+			UE_LOG(LogCobbleStress, Error, TEXT("Unknown layout %s, expected Line, Grid or Scatter"), *LayoutName);
+			NumFailed++;
+			continue;
+		}
+		for (const FString& DensityString : Densities)
+		{
+			const int32 Density = FCString::Atoi(*DensityString);
+			if (Density <= 0)
+			{
+				UE_LOG(LogCobbleStress, Error, TEXT("Density must be a positive whole number, got %s"), *DensityString);
+				NumFailed++;
+				continue;
+			}
+			const FString PackageName = FString::Printf(TEXT("%s/Lvl_Stress_%s_x%d"), *OutputPath, *LayoutName, Density);
+			if (!GenerateMap(PackageName, (ECobbleStressLayout)LayoutValue, Density, Seed))
+				NumFailed++;
+		}
+	}
+	return NumFailed > 0 ? 1 : 0;
+}
+
+bool UCobbleStressLevelCommandlet::GenerateMap(const FString& PackageName, ECobbleStressLayout Layout, int32 Density, int32 Seed)
+{
+	UClass* Gear = LoadPuzzleClass(GearClass, AGear::StaticClass());
+	UClass* GearHolder = LoadPuzzleClass(GearHolderClass, AGearHolder::StaticClass());
+	UClass* MovingPlatform = LoadPuzzleClass(MovingPlatformClass, AMovingPlatform::StaticClass());
+	UClass* Lever = LoadPuzzleClass(LeverClass, ALever::StaticClass());
+	UClass* MoveableBox = LoadPuzzleClass(MoveableBoxClass, AMoveableBox::StaticClass());
+
+	// One entry per actor to spawn, shuffled so every type is spread over the whole map
+	TArray<UClass*> Spawns;
+	Spawns.Reserve(Density * (BaseCounts.Gears + BaseCounts.GearHolders + BaseCounts.StraightPlatforms + BaseCounts.CurvedPlatforms + BaseCounts.Levers + BaseCounts.MoveableBoxes));
+	for (int32 i = 0; i < Density; i++)
+	{
+		for (int32 j = 0; j < BaseCounts.Gears; j++) Spawns.Add(Gear);
+		for (int32 j = 0; j < BaseCounts.GearHolders; j++) Spawns.Add(GearHolder);
+		for (int32 j = 0; j < BaseCounts.StraightPlatforms + BaseCounts.CurvedPlatforms; j++) Spawns.Add(MovingPlatform);
+		for (int32 j = 0; j < BaseCounts.Levers; j++) Spawns.Add(Lever);
+		for (int32 j = 0; j < BaseCounts.MoveableBoxes; j++) Spawns.Add(MoveableBox);
+	}
+	FRandomStream Random(Seed);
+	for (int32 i = Spawns.Num() - 1; i > 0; i--)
+	{
+		Spawns.Swap(i, Random.RandRange(0, i));
+	}
+
+	UPackage* Package = CreatePackage(nullptr, *PackageName);
+	UWorld* World = UWorld::CreateWorld(EWorldType::Editor, false, FName(*FPackageName::GetShortName(PackageName)), Package);
+	World->SetFlags(RF_Public | RF_Standalone);
+
+	const int32 Columns = Layout == ECobbleStressLayout::Line ? Spawns.Num() : FMath::Max(GridColumns, 1);
+	const int32 Rows = FMath::DivideAndRoundUp(Spawns.Num(), Columns);
+	const float Width = Columns * Spacing;
+	int32 NumStraightPlatforms = 0;
+	int32 NumPlatforms = 0;
+	int32 NumPowered = 0;
+	for (int32 i = 0; i < Spawns.Num(); i++)
+	{
+		FVector Location((i % Columns) * Spacing, 0, (i / Columns) * RowHeight);
+		if (Layout == ECobbleStressLayout::Scatter)
+		{
+			Location = FVector(Random.FRandRange(0, Width), 0, Random.FRandRange(0, Rows * RowHeight));
+		}
+		AActor* Actor = SpawnPuzzleActor(World, Spawns[i], Location);
+		if (Actor != nullptr && Spawns[i] == MovingPlatform)
+		{
+			// Keep the straight to curved ratio of the base counts
+			const bool bStraight = NumStraightPlatforms * (BaseCounts.StraightPlatforms + BaseCounts.CurvedPlatforms) < (NumPlatforms + 1) * BaseCounts.StraightPlatforms;
+			ConfigurePlatform(Actor, bStraight, Random);
+			NumStraightPlatforms += bStraight ? 1 : 0;
+			NumPlatforms++;
+		}
+		else if (ALever* SpawnedLever = Cast<ALever>(Actor))
+		{
+			SpawnedLever->bIsFlippedToTheLeft = Random.FRand() < 0.5f;
+		}
+		UCobbleGearHolderComponent* Holder = Actor != nullptr ? Actor->FindComponentByClass<UCobbleGearHolderComponent>() : nullptr;
+		if (Holder != nullptr && Random.FRand() < PoweredShare)
+		{
+			SeatStartingGear(World, Gear, Holder);
+			NumPowered++;
+		}
+	}
+
+	// Somewhere to stand and somewhere to start, so the map can be played headless straight away
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	World->SpawnActor<APlayerStart>(FVector(0, 0, 200), FRotator::ZeroRotator, SpawnParams);
+	if (UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube")))
+	{
+		AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(FVector(Width / 2, 0, -150), FRotator::ZeroRotator, SpawnParams);
+		Floor->GetStaticMeshComponent()->SetStaticMesh(Cube);
+		Floor->SetActorScale3D(FVector((Width + 2000) / 100, 20, 1));
+	}
+
+	bool bSaved = false;
+#if WITH_EDITOR
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetMapPackageExtension());
+	bSaved = UPackage::SavePackage(Package, World, RF_NoFlags, *Filename, GError, nullptr, false, true, SAVE_NoError);
+#endif
+	if (bSaved)
+		UE_LOG(LogCobbleStress, Display, TEXT("Saved %s with %d puzzle actors, %d holders start with a gear"), *PackageName, Spawns.Num() + NumPowered, NumPowered);
+	else
+		UE_LOG(LogCobbleStress, Error, TEXT("Could not save %s"), *PackageName);
+
+	UCobbleLevelAuditCommandlet::UnloadMap(World);
+	return bSaved;
+}
+
+AActor* UCobbleStressLevelCommandlet::SpawnPuzzleActor(UWorld* World, UClass* Class, const FVector& Location)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<AActor>(Class, Location, FRotator::ZeroRotator, SpawnParams);
+}
+
+void UCobbleStressLevelCommandlet::SeatStartingGear(UWorld* World, UClass* Class, UCobbleGearHolderComponent* Holder)
+{
+	AGear* StartingGear = Cast<AGear>(SpawnPuzzleActor(World, Class, Holder->GetComponentLocation()));
+	if (StartingGear != nullptr)
+		Holder->StartingGear = StartingGear;
+}
+
+void UCobbleStressLevelCommandlet::ConfigurePlatform(AActor* Platform, bool bStraight, FRandomStream& Random)
+{
+	USplineComponent* Path = Platform->FindComponentByClass<USplineComponent>();
+	if (Path == nullptr)
+		return;
+	if (AMovingPlatform* MovingPlatform = Cast<AMovingPlatform>(Platform))
+	{
+		MovingPlatform->bIsStraightPath = bStraight;
+	}
+
+	const ESplinePointType::Type PointType = bStraight ? ESplinePointType::Linear : ESplinePointType::Curve;
+	const float Rise = bStraight ? 0 : Random.FRandRange(-0.5f, 0.5f) * PlatformTravel;
+	Path->ClearSplinePoints(false);
+	Path->AddSplinePoint(FVector::ZeroVector, ESplineCoordinateSpace::Local, false);
+	if (!bStraight)
+	{
+		Path->AddSplinePoint(FVector(PlatformTravel / 2, 0, Rise), ESplineCoordinateSpace::Local, false);
+	}
+	Path->AddSplinePoint(FVector(PlatformTravel, 0, 0), ESplineCoordinateSpace::Local, false);
+	for (int32 i = 0; i < Path->GetNumberOfSplinePoints(); i++)
+	{
+		Path->SetSplinePointType(i, PointType, false);
+	}
+	Path->UpdateSpline();
+#if WITH_EDITORONLY_DATA
+	// Stops the construction script from resetting the points when the map is loaded
+	Path->bSplineHasBeenEdited = true;
+#endif
+}
+
+UClass* UCobbleStressLevelCommandlet::LoadPuzzleClass(const TSoftClassPtr<AActor>& ConfiguredClass, UClass* NativeClass)
+{
+	UClass* Class = ConfiguredClass.IsNull() ? nullptr : ConfiguredClass.LoadSynchronous();
+	if (Class != nullptr && Class->IsChildOf(NativeClass))
+		return Class;
+	if (!ConfiguredClass.IsNull())
+		UE_LOG(LogCobbleStress, Warning, TEXT("%s is not a %s, using the native class"), *ConfiguredClass.ToString(), *NativeClass->GetName());
+	return NativeClass;
+}
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CobbleStressLevelCommandlet.generated.h"
+
+UENUM()
+enum class ECobbleStressLayout : uint8
+{
+	// Everything in one long row along the scroll axis
+	Line,
+	// Rows of GridColumns stacked on top of each other
+	Grid,
+	// Random positions in the same area the grid covers
+	Scatter
+};
+
+/*
+How many of each puzzle actor a map has at 1x density. Defaults roughly match our shipped maps.
+*/
+USTRUCT()
+struct FCobbleStressCounts
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	int32 Gears = 6;
+	UPROPERTY(config)
+	int32 GearHolders = 4;
+	UPROPERTY(config)
+	int32 StraightPlatforms = 3;
+	UPROPERTY(config)
+	int32 CurvedPlatforms = 2;
+	// Every lever has a hose
+	UPROPERTY(config)
+	int32 Levers = 3;
+	UPROPERTY(config)
+	int32 MoveableBoxes = 3;
+};
+
+/**
+ * Generates and saves maps with many times the puzzle machinery of our shipped maps, to find which system breaks first.
+ *
+ * UE4Editor-Cmd Cobble.uproject -run=CobbleStressLevel -unattended -nopause -nullrhi [-Density=10,100] [-Layout=Grid,Scatter]
+ *     [-Seed=1] [-Output=/Game/Stress]
+ * Writes one map per density and layout named Lvl_Stress_<Layout>_x<Density>, which can be played headless with
+ * UE4Editor Cobble.uproject /Game/Stress/Lvl_Stress_Grid_x100 -game -nullrhi or audited with -run=CobbleLevelAudit -Maps=...
+ */
+UCLASS(config = Game)
+class COBBLE_API UCobbleStressLevelCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCobbleStressLevelCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool GenerateMap(const FString& PackageName, ECobbleStressLayout Layout, int32 Density, int32 Seed);
+	AActor* SpawnPuzzleActor(UWorld* World, UClass* Class, const FVector& Location);
+	void ConfigurePlatform(AActor* Platform, bool bStraight, FRandomStream& Random);
+	// Spawns a gear of Class in the holder so its machine runs from the start
+	void SeatStartingGear(UWorld* World, UClass* Class, class UCobbleGearHolderComponent* Holder);
+	// The configured blueprint, or the native class if the blueprint can't be loaded
+	static UClass* LoadPuzzleClass(const TSoftClassPtr<AActor>& ConfiguredClass, UClass* NativeClass);
+
+public:
+	UPROPERTY(config)
+	FCobbleStressCounts BaseCounts;
+	// Distance between neighbouring actors along the scroll axis
+	UPROPERTY(config)
+	float Spacing = 400;
+	UPROPERTY(config)
+	float RowHeight = 600;
+	UPROPERTY(config)
+	int32 GridColumns = 60;
+	// How far platforms travel along their spline
+	UPROPERTY(config)
+	float PlatformTravel = 800;
+	// Share of holders, standalone and on platforms, that start with a gear in them. Unpowered machines don't tick,
+	// so without these the map only measures idle machinery.
+	UPROPERTY(config)
+	float PoweredShare = 0.5f;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AActor> GearClass;
+	UPROPERTY(config)
+	TSoftClassPtr<AActor> GearHolderClass;
+	UPROPERTY(config)
+	TSoftClassPtr<AActor> MovingPlatformClass;
+	UPROPERTY(config)
+	TSoftClassPtr<AActor> LeverClass;
+	UPROPERTY(config)
+	TSoftClassPtr<AActor> MoveableBoxClass;
+};
@@ -0,0 +1,652 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleTelemetry.h"
+#include "CobbleSettings.h"
+#include "CobbleMemory.h"
+#include "Async/Async.h"
+#include "Common/TcpListener.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTLS.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "RHI.h"
+#include "Serialization/JsonWriter.h"
+#include "Sockets.h"
+#include "Templates/Atomic.h"
+
+bool FCobbleTelemetry::bEnabled = false;
+
+namespace
+{
+	const int32 NumSystems = (int32)ECobbleTimedSystem::Count;
+	const int32 NumCounters = (int32)ECobbleCounter::Count;
+	const int32 NumGauges = (int32)ECobbleGauge::Count;
+
+	enum EFrameTime
+	{
+		FrameMs,
+		GameThreadMs,
+		RenderThreadMs,
+		GPUMs,
+		TelemetryMs, // Game thread time the telemetry itself took at the end of the previous frame
+		NumFrameTimes
+	};
+	const TCHAR* FrameTimeNames[NumFrameTimes] = { TEXT("FrameMs"), TEXT("GameThreadMs"), TEXT("RenderThreadMs"), TEXT("GPUMs"), TEXT("TelemetryMs") };
+
+	// Bucket i holds values up to Edges[i], the last bucket everything above the last edge
+	const float TimeEdgesMs[] = { 0.01f, 0.025f, 0.05f, 0.1f, 0.25f, 0.5f, 1, 2, 4, 8, 16, 33, 50, 100, 250 };
+	const float CountEdges[] = { 0, 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+
+	typedef TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>> FLineWriter;
+
+	struct FHistogram
+	{
+		TArrayView<const float> Edges;
+		TArray<uint32, TInlineAllocator<16>> Buckets;
+		uint64 Count = 0;
+		double Sum = 0;
+		float Min = 0;
+		float Max = 0;
+
+		void Init(TArrayView<const float> InEdges)
+		{
+			Edges = InEdges;
+			Buckets.SetNumZeroed(Edges.Num() + 1);
+		}
+
+		void Add(float Value)
+		{
+			int32 Bucket = 0;
+			while (Bucket < Edges.Num() && Value > Edges[Bucket])
+				Bucket++;
+			Buckets[Bucket]++;
+			Min = Count == 0 ? Value : FMath::Min(Min, Value);
+			Max = Count == 0 ? Value : FMath::Max(Max, Value);
+			Count++;
+			Sum += Value;
+		}
+
+		void Merge(const FHistogram& Other)
+		{
+			if (Other.Count == 0)
+				return;
+			for (int32 i = 0; i < Buckets.Num(); i++)
+				Buckets[i] += Other.Buckets[i];
+			Min = Count == 0 ? Other.Min : FMath::Min(Min, Other.Min);
+			Max = Count == 0 ? Other.Max : FMath::Max(Max, Other.Max);
+			Count += Other.Count;
+			Sum += Other.Sum;
+		}
+
+		void Reset()
+		{
+			Buckets.Init(0, Edges.Num() + 1);
+			Count = 0;
+			Sum = 0;
+			Min = 0;
+			Max = 0;
+		}
+
+		double GetMean() const
+		{
+			return Count > 0 ? Sum / Count : 0;
+		}
+
+		// Upper edge of the bucket the percentile falls in, so an estimate that errs high
+		float GetPercentile(double Percentile) const
+		{
+			const uint64 Rank = FMath::Max<uint64>((uint64)FMath::CeilToDouble(Count * Percentile), 1);
+			uint64 Seen = 0;
+			for (int32 i = 0; i < Edges.Num(); i++)
+			{
+				Seen += Buckets[i];
+				if (Seen >= Rank)
+					return FMath::Min(Edges[i], Max);
+			}
+			return Max;
+		}
+
+		void Write(FLineWriter& Writer, const TCHAR* Name) const
+		{
+			Writer.WriteObjectStart(Name);
+			Writer.WriteValue(TEXT("Count"), (int64)Count);
+			Writer.WriteValue(TEXT("Mean"), GetMean());
+			Writer.WriteValue(TEXT("Min"), Min);
+			Writer.WriteValue(TEXT("Max"), Max);
+			Writer.WriteValue(TEXT("P50"), GetPercentile(0.5));
+			Writer.WriteValue(TEXT("P90"), GetPercentile(0.9));
+			Writer.WriteValue(TEXT("P99"), GetPercentile(0.99));
+			Writer.WriteArrayStart(TEXT("Buckets"));
+			for (uint32 Bucket : Buckets)
+				Writer.WriteValue((int64)Bucket);
+			Writer.WriteArrayEnd();
+			Writer.WriteObjectEnd();
+		}
+
+		void AppendScrapeText(FString& Out, const TCHAR* Family, const TCHAR* Label, const TCHAR* LabelValue) const
+		{
+			uint64 Cumulative = 0;
+			for (int32 i = 0; i < Buckets.Num(); i++)
+			{
+				Cumulative += Buckets[i];
+				const FString UpperEdge = i < Edges.Num() ? FString::SanitizeFloat(Edges[i]) : FString(TEXT("+Inf"));
+				Out += FString::Printf(TEXT("%s_bucket{%s=\"%s\",le=\"%s\"} %llu\n"), Family, Label, LabelValue, *UpperEdge, Cumulative);
+			}
+			Out += FString::Printf(TEXT("%s_sum{%s=\"%s\"} %f\n"), Family, Label, LabelValue, Sum);
+			Out += FString::Printf(TEXT("%s_count{%s=\"%s\"} %llu\n"), Family, Label, LabelValue, Count);
+		}
+	};
+
+	struct FHistogramSet
+	{
+		FHistogram FrameTimes[NumFrameTimes];
+		FHistogram Systems[NumSystems];
+		FHistogram Gauges[NumGauges];
+
+		FHistogramSet()
+		{
+			for (FHistogram& Histogram : FrameTimes)
+				Histogram.Init(MakeArrayView(TimeEdgesMs));
+			for (FHistogram& Histogram : Systems)
+				Histogram.Init(MakeArrayView(TimeEdgesMs));
+			for (FHistogram& Histogram : Gauges)
+				Histogram.Init(MakeArrayView(CountEdges));
+		}
+
+		void Merge(const FHistogramSet& Other)
+		{
+			for (int32 i = 0; i < NumFrameTimes; i++)
+				FrameTimes[i].Merge(Other.FrameTimes[i]);
+			for (int32 i = 0; i < NumSystems; i++)
+				Systems[i].Merge(Other.Systems[i]);
+			for (int32 i = 0; i < NumGauges; i++)
+				Gauges[i].Merge(Other.Gauges[i]);
+		}
+
+		void Reset()
+		{
+			for (FHistogram& Histogram : FrameTimes)
+				Histogram.Reset();
+			for (FHistogram& Histogram : Systems)
+				Histogram.Reset();
+			for (FHistogram& Histogram : Gauges)
+				Histogram.Reset();
+		}
+	};
+
+	// Only ever added to by its own thread, emptied by the game thread at the end of each frame
+	struct FThreadBuffer
+	{
+		TAtomic<uint64> Cycles[NumSystems];
+		TAtomic<int64> Counters[NumCounters];
+
+		FThreadBuffer()
+		{
+			for (TAtomic<uint64>& Value : Cycles)
+				Value = 0;
+			for (TAtomic<int64>& Value : Counters)
+				Value = 0;
+		}
+	};
+
+	class FTelemetryState
+	{
+	public:
+		FTelemetryState()
+			: TlsSlot(FPlatformTLS::AllocTlsSlot())
+		{
+			FMemory::Memzero(WindowCounters);
+			FMemory::Memzero(TotalCounters);
+			FMemory::Memzero(LastGauges);
+		}
+
+		~FTelemetryState()
+		{
+			FPlatformTLS::FreeTlsSlot(TlsSlot);
+			for (FThreadBuffer* Buffer : Buffers)
+				delete Buffer;
+		}
+
+		void AddTime(ECobbleTimedSystem System, uint64 Cycles)
+		{
+			GetThreadBuffer().Cycles[(int32)System] += Cycles;
+		}
+
+		void Count(ECobbleCounter Counter, int64 Amount)
+		{
+			GetThreadBuffer().Counters[(int32)Counter] += Amount;
+		}
+
+		void EndFrame(const float (&FrameTimes)[NumFrameTimes], const int32 (&GaugeValues)[NumGauges])
+		{
+			uint64 SystemCycles[NumSystems] = {};
+			{
+				FScopeLock Lock(&BuffersLock);
+				for (FThreadBuffer* Buffer : Buffers)
+				{
+					for (int32 i = 0; i < NumSystems; i++)
+						SystemCycles[i] += Buffer->Cycles[i].Exchange(0);
+					for (int32 i = 0; i < NumCounters; i++)
+						WindowCounters[i] += Buffer->Counters[i].Exchange(0);
+				}
+			}
+			for (int32 i = 0; i < NumFrameTimes; i++)
+				Window.FrameTimes[i].Add(FrameTimes[i]);
+			for (int32 i = 0; i < NumSystems; i++)
+				Window.Systems[i].Add(FPlatformTime::ToSeconds64(SystemCycles[i]) * 1000);
+			for (int32 i = 0; i < NumGauges; i++)
+			{
+				Window.Gauges[i].Add(GaugeValues[i]);
+				LastGauges[i] = GaugeValues[i];
+			}
+		}
+
+		double GetWindowMean(EFrameTime FrameTime) const
+		{
+			return Window.FrameTimes[FrameTime].GetMean();
+		}
+
+		// One JSON line with everything since the last flush, then starts a new window
+		FString Flush(double WindowSeconds, const TArray<TPair<FString, int64>>& Memory)
+		{
+			FString Line;
+			TSharedRef<FLineWriter> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Line);
+			Writer->WriteObjectStart();
+			Writer->WriteValue(TEXT("Time"), FDateTime::UtcNow().ToIso8601());
+			Writer->WriteValue(TEXT("Seconds"), WindowSeconds);
+			Writer->WriteValue(TEXT("Frames"), (int64)Window.FrameTimes[FrameMs].Count);
+			Writer->WriteArrayStart(TEXT("TimeEdgesMs"));
+			for (float Edge : TimeEdgesMs)
+				Writer->WriteValue(Edge);
+			Writer->WriteArrayEnd();
+			Writer->WriteArrayStart(TEXT("CountEdges"));
+			for (float Edge : CountEdges)
+				Writer->WriteValue(Edge);
+			Writer->WriteArrayEnd();
+
+			Writer->WriteObjectStart(TEXT("FrameTimes"));
+			for (int32 i = 0; i < NumFrameTimes; i++)
+				Window.FrameTimes[i].Write(*Writer, FrameTimeNames[i]);
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectStart(TEXT("Systems"));
+			for (int32 i = 0; i < NumSystems; i++)
+				Window.Systems[i].Write(*Writer, FCobbleTelemetry::GetSystemName((ECobbleTimedSystem)i));
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectStart(TEXT("Gauges"));
+			for (int32 i = 0; i < NumGauges; i++)
+				Window.Gauges[i].Write(*Writer, FCobbleTelemetry::GetGaugeName((ECobbleGauge)i));
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectStart(TEXT("Counters"));
+			for (int32 i = 0; i < NumCounters; i++)
+			{
+				Writer->WriteObjectStart(FCobbleTelemetry::GetCounterName((ECobbleCounter)i));
+				Writer->WriteValue(TEXT("Count"), WindowCounters[i]);
+				Writer->WriteValue(TEXT("PerMinute"), WindowSeconds > 0 ? WindowCounters[i] * 60 / WindowSeconds : 0);
+				Writer->WriteObjectEnd();
+			}
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectStart(TEXT("MemoryBytes"));
+			for (const TPair<FString, int64>& Pair : Memory)
+				Writer->WriteValue(Pair.Key, Pair.Value);
+			Writer->WriteObjectEnd();
+			Writer->WriteObjectEnd();
+			Writer->Close();
+
+			Totals.Merge(Window);
+			Window.Reset();
+			for (int32 i = 0; i < NumCounters; i++)
+			{
+				TotalCounters[i] += WindowCounters[i];
+				WindowCounters[i] = 0;
+			}
+			LastMemory = Memory;
+			return Line + LINE_TERMINATOR;
+		}
+
+		// Totals since start in the Prometheus text format
+		FString FormatScrapeText() const
+		{
+			FString Text = TEXT("# TYPE cobble_frame_time_ms histogram\n");
+			for (int32 i = 0; i < NumFrameTimes; i++)
+				Totals.FrameTimes[i].AppendScrapeText(Text, TEXT("cobble_frame_time_ms"), TEXT("timer"), FrameTimeNames[i]);
+			Text += TEXT("# TYPE cobble_system_ms histogram\n");
+			for (int32 i = 0; i < NumSystems; i++)
+				Totals.Systems[i].AppendScrapeText(Text, TEXT("cobble_system_ms"), TEXT("system"), FCobbleTelemetry::GetSystemName((ECobbleTimedSystem)i));
+			Text += TEXT("# TYPE cobble_gauge gauge\n");
+			for (int32 i = 0; i < NumGauges; i++)
+				Text += FString::Printf(TEXT("cobble_gauge{name=\"%s\"} %d\n"), FCobbleTelemetry::GetGaugeName((ECobbleGauge)i), LastGauges[i]);
+			Text += TEXT("# TYPE cobble_counter_total counter\n");
+			for (int32 i = 0; i < NumCounters; i++)
+				Text += FString::Printf(TEXT("cobble_counter_total{name=\"%s\"} %lld\n"), FCobbleTelemetry::GetCounterName((ECobbleCounter)i), TotalCounters[i]);
+			Text += TEXT("# TYPE cobble_memory_bytes gauge\n");
+			for (const TPair<FString, int64>& Pair : LastMemory)
+				Text += FString::Printf(TEXT("cobble_memory_bytes{name=\"%s\"} %lld\n"), *Pair.Key, Pair.Value);
+			return Text;
+		}
+
+	private:
+		FThreadBuffer& GetThreadBuffer()
+		{
+			FThreadBuffer* Buffer = (FThreadBuffer*)FPlatformTLS::GetTlsValue(TlsSlot);
+			if (Buffer == nullptr)
+			{
+				// Once per thread, buffers are kept until shutdown even if their thread exits
+				Buffer = new FThreadBuffer();
+				FPlatformTLS::SetTlsValue(TlsSlot, Buffer);
+				FScopeLock Lock(&BuffersLock);
+				Buffers.Add(Buffer);
+			}
+			return *Buffer;
+		}
+
+	private:
+		uint32 TlsSlot;
+		FCriticalSection BuffersLock;
+		TArray<FThreadBuffer*> Buffers;
+		FHistogramSet Window;
+		FHistogramSet Totals;
+		int64 WindowCounters[NumCounters];
+		int64 TotalCounters[NumCounters];
+		int32 LastGauges[NumGauges];
+		TArray<TPair<FString, int64>> LastMemory;
+	};
+
+	FTelemetryState* LiveState = nullptr;
+	TAtomic<int32> Gauges[NumGauges];
+	FDelegateHandle EndFrameHandle;
+	double LastEndFrameTime = 0;
+	double WindowStartTime = 0;
+	float LastTelemetryMs = 0;
+	TFuture<void> PendingWrite;
+	FTcpListener* Listener = nullptr;
+	FCriticalSection ScrapeLock;
+	FString ScrapeText;
+
+	// Read once at startup, the settings object may be gone by the time the module shuts down
+	float FlushSeconds = 10;
+	int64 MaxFileBytes = 0;
+	int32 MaxFiles = 1;
+	float OverheadBudgetUs = 0;
+
+	void AppendRotating(const FString& Line)
+	{
+		const FString Directory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+		const FString Filename = Directory / TEXT("Telemetry.jsonl");
+		IFileManager& FileManager = IFileManager::Get();
+		if (MaxFileBytes > 0 && FileManager.FileSize(*Filename) + Line.Len() > MaxFileBytes)
+		{
+			// Telemetry.1.jsonl is the newest old file, the oldest falls off the end
+			for (int32 i = MaxFiles - 1; i >= 1; i--)
+			{
+				const FString From = i == 1 ? Filename : Directory / FString::Printf(TEXT("Telemetry.%d.jsonl"), i - 1);
+				FileManager.Move(*(Directory / FString::Printf(TEXT("Telemetry.%d.jsonl"), i)), *From, true);
+			}
+			FileManager.Delete(*Filename);
+		}
+		FFileHelper::SaveStringToFile(Line, *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &FileManager, FILEWRITE_Append);
+	}
+
+	// Ends the window and returns its line for the file
+	FString FlushLive(double WindowSeconds)
+	{
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		TArray<TPair<FString, int64>> Memory;
+		Memory.Emplace(TEXT("UsedPhysical"), (int64)MemoryStats.UsedPhysical);
+		Memory.Emplace(TEXT("PeakUsedPhysical"), (int64)MemoryStats.PeakUsedPhysical);
+		Memory.Emplace(TEXT("UsedVirtual"), (int64)MemoryStats.UsedVirtual);
+		// Subsystem memory is only known when running with -llm, estimating it from the actors is far too slow to do here
+		const TArray<int64> SubsystemBytes = FCobbleMemory::GetSubsystemBytes(nullptr);
+		for (int32 i = 0; i < SubsystemBytes.Num(); i++)
+		{
+			if (SubsystemBytes[i] > 0)
+				Memory.Emplace(FCobbleMemory::GetTagName((ECobbleMemoryTag)i), SubsystemBytes[i]);
+		}
+
+		const double OverheadUs = LiveState->GetWindowMean(TelemetryMs) * 1000;
+		FString Line = LiveState->Flush(WindowSeconds, Memory);
+		if (Listener != nullptr)
+		{
+			FString Text = LiveState->FormatScrapeText();
+			FScopeLock Lock(&ScrapeLock);
+			ScrapeText = MoveTemp(Text);
+		}
+		if (OverheadBudgetUs > 0 && OverheadUs > OverheadBudgetUs)
+			UE_LOG(LogTemp, Warning, TEXT("Telemetry took %.1f us a frame, budget is %.1f us"), OverheadUs, OverheadBudgetUs);
+		return Line;
+	}
+
+	void QueueWrite(FString Line)
+	{
+		// Writes stay in order, the previous one finished long ago
+		if (PendingWrite.IsValid())
+			PendingWrite.Wait();
+		PendingWrite = Async(EAsyncExecution::ThreadPool, [Line = MoveTemp(Line)]()
+		{
+			AppendRotating(Line);
+		});
+	}
+
+	void OnEndFrame()
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const double Now = FPlatformTime::Seconds();
+		if (LastEndFrameTime > 0)
+		{
+			float FrameTimes[NumFrameTimes];
+			FrameTimes[FrameMs] = (Now - LastEndFrameTime) * 1000;
+			FrameTimes[GameThreadMs] = FPlatformTime::ToMilliseconds(GGameThreadTime);
+			FrameTimes[RenderThreadMs] = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+			FrameTimes[GPUMs] = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+			FrameTimes[TelemetryMs] = LastTelemetryMs;
+			int32 GaugeValues[NumGauges];
+			for (int32 i = 0; i < NumGauges; i++)
+				GaugeValues[i] = Gauges[i].Load();
+			LiveState->EndFrame(FrameTimes, GaugeValues);
+		}
+		LastEndFrameTime = Now;
+		if (Now - WindowStartTime >= FlushSeconds)
+		{
+			QueueWrite(FlushLive(Now - WindowStartTime));
+			WindowStartTime = Now;
+		}
+		LastTelemetryMs = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000;
+	}
+
+	// Runs on the listener thread. Answers whatever was asked with the latest totals, the way a scraper expects.
+	bool OnScrapeConnection(FSocket* Socket, const FIPv4Endpoint& Endpoint)
+	{
+		if (Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)))
+		{
+			uint8 Request[1024];
+			int32 BytesRead = 0;
+			Socket->Recv(Request, sizeof(Request), BytesRead);
+		}
+		FString Body;
+		{
+			FScopeLock Lock(&ScrapeLock);
+			Body = ScrapeText;
+		}
+		const FTCHARToUTF8 BodyUTF8(*Body);
+		const FString Header = FString::Printf(TEXT("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n"),
+			BodyUTF8.Length());
+		const FTCHARToUTF8 HeaderUTF8(*Header);
+		auto SendAll = [Socket](const uint8* Data, int32 Length)
+		{
+			int32 BytesSent = 0;
+			while (Length > 0 && Socket->Send(Data, Length, BytesSent) && BytesSent > 0)
+			{
+				Data += BytesSent;
+				Length -= BytesSent;
+			}
+		};
+		SendAll((const uint8*)HeaderUTF8.Get(), HeaderUTF8.Length());
+		SendAll((const uint8*)BodyUTF8.Get(), BodyUTF8.Length());
+		// Not kept, so the listener closes and destroys the socket
+		return false;
+	}
+
+	FAutoConsoleCommand TelemetryBenchCommand(
+		TEXT("Cobble.TelemetryBench"),
+		TEXT("Checks the telemetry overhead against TelemetryOverheadBudgetUs. Optional scopes per frame and frames, e.g. Cobble.TelemetryBench 200 5000"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 ScopesPerFrame = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 0) : 200;
+			const int32 NumFrames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 5000;
+			const double Microseconds = FCobbleTelemetry::RunBenchmark(ScopesPerFrame, NumFrames);
+			const float BudgetUs = GetDefault<UCobbleSettings>()->TelemetryOverheadBudgetUs;
+			const bool bWithinBudget = Microseconds <= BudgetUs;
+
+			FString Json;
+			TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+			Writer->WriteObjectStart();
+			Writer->WriteValue(TEXT("ScopesPerFrame"), ScopesPerFrame);
+			Writer->WriteValue(TEXT("Frames"), NumFrames);
+			Writer->WriteValue(TEXT("MicrosecondsPerFrame"), Microseconds);
+			Writer->WriteValue(TEXT("BudgetMicroseconds"), BudgetUs);
+			Writer->WriteValue(TEXT("WithinBudget"), bWithinBudget);
+			Writer->WriteObjectEnd();
+			Writer->Close();
+			FFileHelper::SaveStringToFile(Json, *(FPaths::ProfilingDir() / TEXT("TelemetryBench.json")));
+
+			if (bWithinBudget)
+				UE_LOG(LogTemp, Display, TEXT("Telemetry: %d scopes a frame, %.2f us per frame, budget is %.1f us"), ScopesPerFrame, Microseconds, BudgetUs);
+			else
+				UE_LOG(LogTemp, Error, TEXT("Telemetry: %d scopes a frame, %.2f us per frame, over the %.1f us budget"), ScopesPerFrame, Microseconds, BudgetUs);
+		}));
+}
+
+void FCobbleTelemetry::Startup()
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	if (!Settings->bEnableTelemetry || IsRunningCommandlet() || GIsEditor || FParse::Param(FCommandLine::Get(), TEXT("NoCobbleTelemetry")))
+		return;
+	FlushSeconds = FMath::Max(Settings->TelemetryFlushSeconds, 1.f);
+	MaxFileBytes = (int64)Settings->TelemetryMaxFileKB * 1024;
+	MaxFiles = FMath::Max(Settings->TelemetryMaxFiles, 1);
+	OverheadBudgetUs = Settings->TelemetryOverheadBudgetUs;
+
+	LiveState = new FTelemetryState();
+	LastEndFrameTime = 0;
+	WindowStartTime = FPlatformTime::Seconds();
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&OnEndFrame);
+
+	int32 Port = Settings->TelemetryPort;
+	FParse::Value(FCommandLine::Get(), TEXT("CobbleTelemetryPort="), Port);
+	if (Port > 0 && Port <= MAX_uint16)
+	{
+		Listener = new FTcpListener(FIPv4Endpoint(FIPv4Address::InternalLoopback, (uint16)Port));
+		Listener->OnConnectionAccepted().BindStatic(&OnScrapeConnection);
+		if (!Listener->IsActive())
+			UE_LOG(LogTemp, Warning, TEXT("Telemetry could not listen on 127.0.0.1:%d"), Port);
+	}
+	bEnabled = true;
+}
+
+void FCobbleTelemetry::Shutdown()
+{
+	if (!bEnabled)
+		return;
+	bEnabled = false;
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	EndFrameHandle.Reset();
+	delete Listener;
+	Listener = nullptr;
+
+	// The last partial window is still worth having. Written here, the thread pool is already gone at module shutdown.
+	const FString Line = FlushLive(FPlatformTime::Seconds() - WindowStartTime);
+	if (PendingWrite.IsValid())
+		PendingWrite.Wait();
+	PendingWrite = TFuture<void>();
+	AppendRotating(Line);
+	delete LiveState;
+	LiveState = nullptr;
+}
+
+void FCobbleTelemetry::AddTime(ECobbleTimedSystem System, uint64 Cycles)
+{
+	if (LiveState != nullptr)
+		LiveState->AddTime(System, Cycles);
+}
+
+void FCobbleTelemetry::Count(ECobbleCounter Counter, int64 Amount)
+{
+	if (bEnabled && LiveState != nullptr)
+		LiveState->Count(Counter, Amount);
+}
+
+void FCobbleTelemetry::AddToGauge(ECobbleGauge Gauge, int32 Delta)
+{
+	// Kept up to date even while disabled, it is cheap and rarely changes
+	Gauges[(int32)Gauge] += Delta;
+}
+
+const TCHAR* FCobbleTelemetry::GetSystemName(ECobbleTimedSystem System)
+{
+	switch (System)
+	{
+	case ECobbleTimedSystem::Character: return TEXT("Character");
+	case ECobbleTimedSystem::Interactables: return TEXT("Interactables");
+	case ECobbleTimedSystem::Hoses: return TEXT("Hoses");
+	case ECobbleTimedSystem::Platforms: return TEXT("Platforms");
+	case ECobbleTimedSystem::MachineAudio: return TEXT("MachineAudio");
+	case ECobbleTimedSystem::Streaming: return TEXT("Streaming");
+	case ECobbleTimedSystem::Scheduler: return TEXT("Scheduler");
+	case ECobbleTimedSystem::PhysicsRegions: return TEXT("PhysicsRegions");
+	default: return TEXT("Unknown");
+	}
+}
+
+const TCHAR* FCobbleTelemetry::GetCounterName(ECobbleCounter Counter)
+{
+	switch (Counter)
+	{
+	case ECobbleCounter::Interactions: return TEXT("Interactions");
+	default: return TEXT("Unknown");
+	}
+}
+
+const TCHAR* FCobbleTelemetry::GetGaugeName(ECobbleGauge Gauge)
+{
+	switch (Gauge)
+	{
+	case ECobbleGauge::HosesSimulating: return TEXT("HosesSimulating");
+	case ECobbleGauge::PlatformsMoving: return TEXT("PlatformsMoving");
+	default: return TEXT("Unknown");
+	}
+}
+
+double FCobbleTelemetry::RunBenchmark(int32 ScopesPerFrame, int32 NumFrames)
+{
+	FTelemetryState State;
+	const float BenchFlushSeconds = FMath::Max(GetDefault<UCobbleSettings>()->TelemetryFlushSeconds, 1.f);
+	const int32 FramesPerFlush = FMath::Max(FMath::RoundToInt(BenchFlushSeconds * 60), 1);
+	const float FrameTimes[NumFrameTimes] = { 16.7f, 11, 8, 14, 0.02f };
+	const int32 GaugeValues[NumGauges] = {};
+	const TArray<TPair<FString, int64>> Memory;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		for (int32 i = 0; i < ScopesPerFrame; i++)
+		{
+			// What COBBLE_TELEMETRY_SCOPE does, into the benchmark's own buffers
+			const uint64 ScopeStart = FPlatformTime::Cycles64();
+			State.AddTime((ECobbleTimedSystem)(i % NumSystems), FPlatformTime::Cycles64() - ScopeStart);
+		}
+		State.Count(ECobbleCounter::Interactions, 1);
+		State.EndFrame(FrameTimes, GaugeValues);
+		if ((Frame + 1) % FramesPerFlush == 0)
+		{
+			State.Flush(BenchFlushSeconds, Memory);
+			State.FormatScrapeText();
+		}
+	}
+	return FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000 / NumFrames;
+}
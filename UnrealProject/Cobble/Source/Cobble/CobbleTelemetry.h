@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Cobble systems whose game thread time is measured with COBBLE_TELEMETRY_SCOPE. Time is inclusive, e.g. the scheduler
+// includes the actions it runs.
+enum class ECobbleTimedSystem : uint8
+{
+	Character,
+	Interactables,
+	Hoses,
+	Platforms,
+	MachineAudio,
+	Streaming,
+	Scheduler,
+	PhysicsRegions,
+	Count
+};
+
+// Running totals, reported per flush and per minute
+enum class ECobbleCounter : uint8
+{
+	Interactions,
+	Count
+};
+
+// Current values, sampled once a frame
+enum class ECobbleGauge : uint8
+{
+	HosesSimulating,
+	PlatformsMoving,
+	Count
+};
+
+#define COBBLE_TELEMETRY_SCOPE(System) FCobbleTelemetryScope ANONYMOUS_VARIABLE(CobbleTelemetryScope)(ECobbleTimedSystem::System)
+
+/*
+Always on frame and gameplay metrics for builds we can't attach tools to.
+Timed scopes and counters go into a buffer per thread with no locks. At the end of every frame the game thread collects the
+buffers into histograms of the frame, game, render and GPU times, each system's time and each gauge. Every
+TelemetryFlushSeconds the histograms and counters are written as one JSON line to Saved/Telemetry/Telemetry.jsonl on a
+background thread, rotated into Telemetry.1.jsonl and on once it reaches TelemetryMaxFileKB. With TelemetryPort set (or
+-CobbleTelemetryPort=N), a collector can also scrape the totals since start in Prometheus text format from
+http://127.0.0.1:<port>/. Only the loopback address is bound. -NoCobbleTelemetry turns it all off.
+
+Overhead budget: recording, the end of frame collection and the flush formatting together take at most
+TelemetryOverheadBudgetUs of game thread time per frame, measured with 200 timed scopes a frame. Cobble.TelemetryBench
+checks this and writes Saved/Profiling/TelemetryBench.json. Headless: -ExecCmds="Cobble.TelemetryBench 200 5000".
+The live cost is reported in every flush as TelemetryMs, and a warning is logged when a flush averages over the budget.
+*/
+struct COBBLE_API FCobbleTelemetry
+{
+	// Called by the module
+	static void Startup();
+	static void Shutdown();
+
+	static bool IsEnabled() { return bEnabled; }
+	// Safe to call from any thread
+	static void AddTime(ECobbleTimedSystem System, uint64 Cycles);
+	static void Count(ECobbleCounter Counter, int64 Amount = 1);
+	static void AddToGauge(ECobbleGauge Gauge, int32 Delta);
+
+	static const TCHAR* GetSystemName(ECobbleTimedSystem System);
+	static const TCHAR* GetCounterName(ECobbleCounter Counter);
+	static const TCHAR* GetGaugeName(ECobbleGauge Gauge);
+
+	// Game thread microseconds per frame with ScopesPerFrame timed scopes, flushing at the configured rate at 60 fps.
+	// Runs on its own buffers, the live metrics are not touched.
+	static double RunBenchmark(int32 ScopesPerFrame, int32 NumFrames);
+
+private:
+	static bool bEnabled;
+};
+
+struct FCobbleTelemetryScope
+{
+	explicit FCobbleTelemetryScope(ECobbleTimedSystem InSystem)
+		: System(InSystem)
+		, StartCycles(FCobbleTelemetry::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+	~FCobbleTelemetryScope()
+	{
+		if (StartCycles != 0)
+			FCobbleTelemetry::AddTime(System, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+	ECobbleTimedSystem System;
+	uint64 StartCycles;
+};
@@ -0,0 +1,280 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CobbleTextureStreaming.h"
+#include "CobbleSettings.h"
+#include "CobbleTelemetry.h"
+#include "CobbleSideScroll.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Level.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	// Players cover a small part of the look ahead between updates even at full speed
+	const float UpdateInterval = 0.1f;
+	// Primed textures stay forced this long unless renewed, so a missed update doesn't drop them
+	const float PrimeSeconds = 4 * UpdateInterval;
+
+	FAutoConsoleCommandWithWorld TextureReportCommand(
+		TEXT("Cobble.TextureReport"),
+		TEXT("Prints the predictive texture streaming path, primed textures and blurry frame totals."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			UCobbleTextureStreaming* TextureStreaming = World != nullptr ? UGameInstance::GetSubsystem<UCobbleTextureStreaming>(World->GetGameInstance()) : nullptr;
+			if (TextureStreaming != nullptr)
+				TextureStreaming->PrintReport();
+		}));
+}
+
+void UCobbleTextureStreaming::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	bMeasure = FParse::Param(FCommandLine::Get(), TEXT("CobbleTextureMetrics"));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UCobbleTextureStreaming::OnLevelsChanged);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UCobbleTextureStreaming::OnLevelsChanged);
+}
+
+void UCobbleTextureStreaming::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	WriteMetrics();
+	ReleaseAll();
+	Super::Deinitialize();
+}
+
+bool UCobbleTextureStreaming::IsTickable() const
+{
+	return !HasAnyFlags(RF_ClassDefaultObject) && FApp::CanEverRender() && GetDefault<UCobbleSettings>()->bPredictiveTextureStreaming;
+}
+
+TStatId UCobbleTextureStreaming::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCobbleTextureStreaming, STATGROUP_Tickables);
+}
+
+void UCobbleTextureStreaming::OnLevelsChanged(ULevel* Level, UWorld* World)
+{
+	if (World == PathWorld.Get())
+		bPathDirty = true;
+}
+
+void UCobbleTextureStreaming::Tick(float DeltaTime)
+{
+	COBBLE_TELEMETRY_SCOPE(Streaming);
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (World == nullptr)
+		return;
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate <= 0)
+	{
+		TimeUntilUpdate = UpdateInterval;
+		TArray<AActor*> Viewers;
+		for (ULocalPlayer* LocalPlayer : GetGameInstance()->GetLocalPlayers())
+		{
+			APlayerController* Controller = LocalPlayer != nullptr ? LocalPlayer->PlayerController : nullptr;
+			if (Controller != nullptr && Controller->GetViewTarget() != nullptr)
+				Viewers.Add(Controller->GetViewTarget());
+		}
+		if (Viewers.Num() == 0)
+			return;
+		const FVector Axis = FCobbleSideScroll::GetScrollAxis(Viewers[0]);
+		if (bPathDirty || PathWorld.Get() != World || FVector::DotProduct(Axis, PathAxis) < 0.99f)
+			BuildPath(World, Axis);
+		UpdateWindows(Viewers);
+		UpdatePriming();
+	}
+	if (bMeasure)
+		MeasureFrame();
+}
+
+void UCobbleTextureStreaming::BuildPath(UWorld* World, const FVector& Axis)
+{
+	if (PathWorld.Get() != World)
+	{
+		// A new map, the totals so far belong to the last one
+		WriteMetrics();
+		MeasuredMap = World->GetMapName();
+	}
+	ReleaseAll();
+	Path.Reset();
+	Textures.Reset();
+	PathWorld = World;
+	PathAxis = Axis;
+	bPathDirty = false;
+
+	TMap<UTexture2D*, int32> TextureIndices;
+	TArray<UTexture*> UsedTextures;
+	for (ULevel* Level : World->GetLevels())
+	{
+		if (Level == nullptr || !Level->bIsVisible)
+			continue;
+		for (AActor* Actor : Level->Actors)
+		{
+			// Characters are always on screen, the streamer already keeps their textures
+			if (Actor == nullptr || Actor->IsPendingKill() || Actor->IsA<APawn>())
+				continue;
+			TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+			for (UPrimitiveComponent* Primitive : Primitives)
+			{
+				if (!Primitive->IsRegistered())
+					continue;
+				FPathEntry Entry;
+				UsedTextures.Reset();
+				Primitive->GetUsedTextures(UsedTextures, EMaterialQualityLevel::Num);
+				for (UTexture* Texture : UsedTextures)
+				{
+					UTexture2D* Texture2D = Cast<UTexture2D>(Texture);
+					if (Texture2D == nullptr || Texture2D->NeverStream)
+						continue;
+					const int32* Found = TextureIndices.Find(Texture2D);
+					Entry.Textures.AddUnique(Found != nullptr ? *Found : TextureIndices.Add(Texture2D, Textures.Add(Texture2D)));
+				}
+				if (Entry.Textures.Num() == 0)
+					continue;
+				const FBoxSphereBounds& Bounds = Primitive->Bounds;
+				const float Centre = FVector::DotProduct(Bounds.Origin, Axis);
+				const float HalfLength = FVector::DotProduct(Bounds.BoxExtent, Axis.GetAbs());
+				Entry.Start = Centre - HalfLength;
+				Entry.End = Centre + HalfLength;
+				Path.Add(MoveTemp(Entry));
+			}
+		}
+	}
+	Path.Sort([](const FPathEntry& A, const FPathEntry& B) { return A.Start < B.Start; });
+	PrimedTextures.Init(false, Textures.Num());
+	VisibleTextures.Init(false, Textures.Num());
+	UE_LOG(LogTemp, Log, TEXT("Texture streaming path for %s: %d primitives, %d streaming textures"), *World->GetMapName(), Path.Num(), Textures.Num());
+}
+
+void UCobbleTextureStreaming::UpdateWindows(const TArray<AActor*>& Viewers)
+{
+	const UCobbleSettings* Settings = GetDefault<UCobbleSettings>();
+	Windows.Reset();
+	for (const AActor* Viewer : Viewers)
+	{
+		const float At = FVector::DotProduct(Viewer->GetActorLocation(), PathAxis);
+		// Look further in the direction the player is heading, by how far they get before the textures are needed
+		const float Speed = FVector::DotProduct(Viewer->GetVelocity(), PathAxis);
+		const float Lead = FMath::Abs(Speed) * Settings->TextureLeadSeconds;
+		FViewWindow& Window = Windows.AddDefaulted_GetRef();
+		Window.Start = At - Settings->TextureKeepBehind - (Speed < 0 ? Lead : 0);
+		Window.End = At + Settings->TextureLookAhead + (Speed > 0 ? Lead : 0);
+		Window.VisibleStart = At - Settings->TextureCameraHalfWidth;
+		Window.VisibleEnd = At + Settings->TextureCameraHalfWidth;
+	}
+}
+
+void UCobbleTextureStreaming::UpdatePriming()
+{
+	TBitArray<> WantedTextures(false, Textures.Num());
+	VisibleTextures.Init(false, Textures.Num());
+	for (const FPathEntry& Entry : Path)
+	{
+		for (const FViewWindow& Window : Windows)
+		{
+			// Only the lead past either edge of the camera, so a texture is forced only until the camera gets to it
+			const bool bWanted = (Entry.Start <= Window.End && Entry.End > Window.VisibleEnd) || (Entry.Start < Window.VisibleStart && Entry.End >= Window.Start);
+			const bool bVisible = Entry.Start <= Window.VisibleEnd && Entry.End >= Window.VisibleStart;
+			for (int32 Index : Entry.Textures)
+			{
+				if (bWanted)
+					WantedTextures[Index] = true;
+				if (bVisible)
+					VisibleTextures[Index] = true;
+			}
+		}
+	}
+
+	int64 PrimedBytes = 0;
+	for (int32 Index = 0; Index < Textures.Num(); Index++)
+	{
+		UTexture2D* Texture = Textures[Index].Get();
+		if (Texture == nullptr)
+			continue;
+		if (WantedTextures[Index])
+		{
+			Texture->SetForceMipLevelsToBeResident(PrimeSeconds);
+			if (!PrimedTextures[Index])
+			{
+				PrimedTextures[Index] = true;
+				NumPrimes++;
+			}
+			PrimedBytes += Texture->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+		}
+		else if (PrimedTextures[Index])
+		{
+			// On screen or behind every player, the streamer decides from here
+			Texture->SetForceMipLevelsToBeResident(0);
+			PrimedTextures[Index] = false;
+			NumReleases++;
+		}
+	}
+	PeakPrimedBytes = FMath::Max(PeakPrimedBytes, PrimedBytes);
+}
+
+void UCobbleTextureStreaming::ReleaseAll()
+{
+	for (TConstSetBitIterator<> It(PrimedTextures); It; ++It)
+	{
+		if (UTexture2D* Texture = Textures[It.GetIndex()].Get())
+			Texture->SetForceMipLevelsToBeResident(0);
+	}
+	PrimedTextures.Init(false, Textures.Num());
+}
+
+void UCobbleTextureStreaming::MeasureFrame()
+{
+	if (Textures.Num() == 0)
+		return;
+	NumFrames++;
+	for (TConstSetBitIterator<> It(VisibleTextures); It; ++It)
+	{
+		const UTexture2D* Texture = Textures[It.GetIndex()].Get();
+		if (Texture != nullptr && Texture->GetNumResidentMips() < Texture->GetNumRequestedMips())
+		{
+			NumBlurryFrames++;
+			break;
+		}
+	}
+}
+
+void UCobbleTextureStreaming::WriteMetrics()
+{
+	if (!bMeasure || NumFrames == 0)
+		return;
+	const FString Filename = FPaths::ProfilingDir() / TEXT("TextureStreaming.csv");
+	FString Line;
+	if (!IFileManager::Get().FileExists(*Filename))
+		Line = TEXT("Time,Map,Frames,BlurryFrames,BlurryPercent,Primes,Releases,PeakPrimedKB\n");
+	Line += FString::Printf(TEXT("%s,%s,%d,%d,%.2f,%d,%d,%.1f\n"), *FDateTime::Now().ToString(), *MeasuredMap, NumFrames, NumBlurryFrames,
+		100.0 * NumBlurryFrames / NumFrames, NumPrimes, NumReleases, PeakPrimedBytes / 1024.0);
+	FFileHelper::SaveStringToFile(Line, *Filename, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	NumFrames = 0;
+	NumBlurryFrames = 0;
+	NumPrimes = 0;
+	NumReleases = 0;
+	PeakPrimedBytes = 0;
+}
+
+void UCobbleTextureStreaming::PrintReport() const
+{
+	UE_LOG(LogTemp, Display, TEXT("Cobble textures: %s, %d primitives on the path, %d streaming textures, %d primed"),
+		*MeasuredMap, Path.Num(), Textures.Num(), PrimedTextures.CountSetBits());
+	UE_LOG(LogTemp, Display, TEXT("Cobble textures: %d primes, %d releases, %.1f KB peak primed resident"), NumPrimes, NumReleases, PeakPrimedBytes / 1024.0);
+	if (bMeasure)
+		UE_LOG(LogTemp, Display, TEXT("Cobble textures: %d of %d frames blurry"), NumBlurryFrames, NumFrames);
+}
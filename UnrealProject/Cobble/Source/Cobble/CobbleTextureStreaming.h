@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "CobbleTextureStreaming.generated.h"
+
+class UTexture2D;
+
+/**
+ * Tells the texture streamer where a side scrolling camera is going next. When a level starts, every primitive in it is
+ * reduced to its extent along the scroll axis and the streaming textures it draws with, sorted by where it starts. A few
+ * times a second each local player's window is worked out: TextureLookAhead in front of the player plus how far they will
+ * get in TextureLeadSeconds at their current speed, and TextureKeepBehind behind them. Textures of primitives in the part
+ * of a window past TextureCameraHalfWidth are forced to full resolution for a short while, renewed as long as they stay
+ * there. Once the camera reaches them, or they fall out of every window, they are released straight away, so the streamer
+ * picks mips for what is on screen by distance as usual and the pool isn't kept full of the level behind the camera.
+ *
+ * With -CobbleTextureMetrics every frame is checked for textures in the camera area whose resident mips are below what the
+ * streamer wants. Those frames count as blurry, and the totals for each map are appended to Saved/Profiling/TextureStreaming.csv.
+ * Cobble.TextureReport prints the same numbers.
+ */
+UCLASS()
+class COBBLE_API UCobbleTextureStreaming : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	void PrintReport() const;
+
+private:
+	// A primitive's extent along the scroll axis and the textures it needs
+	struct FPathEntry
+	{
+		float Start = 0;
+		float End = 0;
+		TArray<int32, TInlineAllocator<2>> Textures;
+	};
+	struct FViewWindow
+	{
+		float Start = 0;
+		float End = 0;
+		// The part the camera can see now, left to the streamer and used for the blurry frame metric
+		float VisibleStart = 0;
+		float VisibleEnd = 0;
+	};
+
+	void BuildPath(UWorld* World, const FVector& Axis);
+	void UpdateWindows(const TArray<AActor*>& Viewers);
+	void UpdatePriming();
+	void ReleaseAll();
+	void MeasureFrame();
+	void WriteMetrics();
+	void OnLevelsChanged(ULevel* Level, UWorld* World);
+
+private:
+	TArray<FPathEntry> Path; // Sorted by Start
+	TArray<TWeakObjectPtr<UTexture2D>> Textures;
+	TBitArray<> PrimedTextures;
+	TBitArray<> VisibleTextures;
+	TArray<FViewWindow> Windows;
+	TWeakObjectPtr<UWorld> PathWorld;
+	FVector PathAxis = FVector::ZeroVector;
+	bool bPathDirty = true;
+	float TimeUntilUpdate = 0;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	bool bMeasure = false;
+	FString MeasuredMap;
+	int32 NumFrames = 0;
+	int32 NumBlurryFrames = 0;
+	int32 NumPrimes = 0;
+	int32 NumReleases = 0;
+	int64 PeakPrimedBytes = 0;
+};
@@ -2,6 +2,10 @@
 
 
 #include "Gear.h"
+#include "CobbleNetworking.h"
+#include "CobbleHitchDetector.h"
+#include "CobblePhysicsRegions.h"
+#include "Net/UnrealNetwork.h"
 
 // Sets default values
 AGear::AGear()
@@ -10,35 +14,88 @@ AGear::AGear()
 	PrimaryActorTick.bCanEverTick = true;
 }
 
-void AGear::Highlight()
+void AGear::Highlight(ACobblePaperCharacter* Interactor)
 {
-	if (Player != nullptr && !Player->IsPlayerHoldingGear())
+	BindToPlayerHeldItem(Interactor);
+	UpdateHighlight(Interactor, true);
+}
+
+void AGear::Unhighlight(ACobblePaperCharacter* Interactor)
+{
+	UpdateHighlight(Interactor, false);
+	UnbindFromPlayerHeldItem();
+}
+
+void AGear::Interact(ACobblePaperCharacter* Interactor)
+{
+	if (Interactor != nullptr && !bIsHeld)
 	{
-		Player->ShowGearHighlight();
-		RegularSpriteComponent->SetHiddenInGame(true);
+		if (Interactor->PickUpItem(this))
+		{
+			SetIsHeld(true);
+		}
 	}
 }
 
-void AGear::Unhighlight()
+void AGear::SetIsHeld(bool bHeld)
+{
+	FCobbleNet::MarkStateChanged(this);
+	bIsHeld = bHeld;
+	OnRep_IsHeld();
+}
+
+void AGear::OnRep_IsHeld()
 {
-	RegularSpriteComponent->SetHiddenInGame(false);
-	if (Player != nullptr)
+	if (bIsHeld)
+	{
+		SetSpriteBatched(false);
+		DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		SetActorLocation(FVector(0, -40000, 0));
+		FCobbleHitchDetector::RecordEvent(ECobbleEvent::GearTeleported, this);
+		if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+			PhysicsRegions->UpdateActorCells(this);
+	}
+	else
 	{
-		Player->HideGearHighlight();
+		// Still again unless a holder has it
+		SetSpriteBatched(true);
 	}
 }
 
-void AGear::Interact()
+bool AGear::CanBatchSprite() const
+{
+	return !bIsHeld && GetAttachParentActor() == nullptr;
+}
+
+void AGear::OnPlayerHeldItemChanged(int32 SlotIndex, EHeldItemType OldType, EHeldItemType NewType)
+{
+	UpdateHighlight(HighlightingPlayer, true);
+}
+
+void AGear::UpdateHighlight(ACobblePaperCharacter* ForPlayer, bool bHighlighted)
 {
-	if (Player != nullptr)
+	// The player's gear highlight stands in for this gear while it can be picked up
+	const bool bShowHighlight = bHighlighted && ForPlayer != nullptr && ForPlayer->HasFreeHeldItemSlot();
+	if (bShowHighlight)
+		SetSpriteBatched(false);
+	RegularSpriteComponent->SetHiddenInGame(bShowHighlight);
+	if (!bShowHighlight)
+		SetSpriteBatched(true);
+	if (ForPlayer != nullptr)
 	{
-		if (Player->ReceiveGear(this))
-		{
-			SetActorLocation(FVector(0, -40000, 0));
-		}
+		if (bShowHighlight)
+			ForPlayer->ShowGearHighlight();
+		else
+			ForPlayer->HideGearHighlight();
 	}
 }
 
+void AGear::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AGear, bIsHeld);
+}
+
 // Called when the game starts or when spawned
 void AGear::BeginPlay()
 {
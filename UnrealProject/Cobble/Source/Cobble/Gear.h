@@ -14,15 +14,27 @@ class COBBLE_API AGear : public AInteractable
 public:
 	// Sets default values for this actor's properties
 	AGear();
-	virtual void Highlight() override;
-	virtual void Unhighlight() override;
-	virtual void Interact() override;
+	virtual void Highlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Unhighlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Interact(ACobblePaperCharacter* Interactor) override;
+
+	// Server only. A held gear is moved out of the level until it is put in a holder.
+	void SetIsHeld(bool bHeld);
+	// A gear that is held or turning in a holder is never still enough to batch
+	virtual bool CanBatchSprite() const override;
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void OnPlayerHeldItemChanged(int32 SlotIndex, EHeldItemType OldType, EHeldItemType NewType) override;
 
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 private:
+	void UpdateHighlight(ACobblePaperCharacter* ForPlayer, bool bHighlighted);
+	UFUNCTION()
+	void OnRep_IsHeld();
+private:
+	UPROPERTY(ReplicatedUsing = OnRep_IsHeld)
+	bool bIsHeld = false;
 };
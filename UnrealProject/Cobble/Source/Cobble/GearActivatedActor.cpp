@@ -2,20 +2,25 @@
 
 
 #include "GearActivatedActor.h"
-#include "Cobble//GearHolder.h"
+#include "CobbleGearHolderComponent.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleManifestBinding.h"
 #include "Components/ChildActorComponent.h"
 
 // Sets default values
 AGearActivatedActor::AGearActivatedActor()
 {
+	COBBLE_LLM_SCOPE(Platforms);
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
 	SceneRoot = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
 	SetRootComponent(SceneRoot);
-	GearHolderActor = CreateDefaultSubobject<UChildActorComponent>(TEXT("GearHolderChildActor"));
-
-	GearHolderActor->SetupAttachment(SceneRoot);
-	GearHolderActor->SetChildActorClass(AGearHolder::StaticClass());
+	GearHolder = CreateDefaultSubobject<UCobbleGearHolderComponent>(TEXT("GearHolder"));
+	GearHolder->SetupAttachment(SceneRoot);
 }
 
 void AGearActivatedActor::OnConstruction(const FTransform & Transform)
@@ -23,10 +28,46 @@ void AGearActivatedActor::OnConstruction(const FTransform & Transform)
 	Super::OnConstruction(Transform);
 }
 
+void AGearActivatedActor::PreRegisterAllComponents()
+{
+	Super::PreRegisterAllComponents();
+	// Actors saved while the holder was a child actor still carry its component and the holder it spawned, see
+	// [CoreRedirects] in DefaultEngine.ini. Registering it would spawn a second, unpowered holder next to this one,
+	// so it is stripped before that in every world, resaving the map drops it for good.
+	TInlineComponentArray<UChildActorComponent*> ChildActorComponents(this);
+	for (UChildActorComponent* Leftover : ChildActorComponents)
+	{
+		if (Leftover->GetFName() != TEXT("GearHolderChildActor"))
+			continue;
+		Leftover->bAutoRegister = false;
+		Leftover->DestroyChildActor();
+		Leftover->SetChildActorClass(nullptr);
+		Leftover->DestroyComponent();
+	}
+}
+
 // Called when the game starts or when spawned
 void AGearActivatedActor::BeginPlay()
 {
+	COBBLE_LLM_SCOPE(Platforms);
 	Super::BeginPlay();
+	PowerChangedHandle = GearHolder->OnPowerChanged().AddUObject(this, &AGearActivatedActor::HandlePowerChanged);
+	// Actors bound from the level manifest were registered with the rest of their level
+	ACobblePhysicsRegions* PhysicsRegions = !ACobbleManifestBinding::IsBound(this) ? ACobblePhysicsRegions::Get(GetWorld()) : nullptr;
+	if (PhysicsRegions != nullptr)
+		PhysicsRegions->RegisterActor(this);
+	// A starting gear is seated while the components begin play, before the handler is bound
+	if (GearHolder->GetIsGearTurning())
+		HandlePowerChanged(true);
+}
+
+void AGearActivatedActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GearHolder->OnPowerChanged().Remove(PowerChangedHandle);
+	PowerChangedHandle.Reset();
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->UnregisterActor(this);
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -36,8 +77,41 @@ void AGearActivatedActor::Tick(float DeltaTime)
 
 }
 
-bool AGearActivatedActor::IsPowered()
+void AGearActivatedActor::Highlight(ACobblePaperCharacter* Interactor)
+{
+	GearHolder->Highlight(Interactor);
+}
+
+void AGearActivatedActor::Unhighlight(ACobblePaperCharacter* Interactor)
+{
+	GearHolder->Unhighlight(Interactor);
+}
+
+void AGearActivatedActor::Interact(ACobblePaperCharacter* Interactor)
+{
+	GearHolder->Interact(Interactor);
+}
+
+void AGearActivatedActor::HandlePowerChanged(bool bPowered)
+{
+	// Back in the physics scene first, so whatever the power change does to collision isn't undone when the region is restored
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->Wake(this);
+	OnPowerChanged(bPowered);
+}
+
+bool AGearActivatedActor::IsPowered() const
+{
+	return GearHolder->GetIsGearTurning();
+}
+
+bool AGearActivatedActor::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
 {
-	return Cast<AGearHolder>(GearHolderActor->GetChildActor())->GetIsGearTurning();
+	return FCobbleNet::IsRelevantToCamera(this, RealViewer, ViewTarget, SrcLocation);
 }
 
+void AGearActivatedActor::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	FCobbleNet::RecordReplicationCheck(this);
+}
@@ -4,10 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "InteractInterface.h"
 #include "GearActivatedActor.generated.h"
 
 UCLASS()
-class COBBLE_API AGearActivatedActor : public AActor
+class COBBLE_API AGearActivatedActor : public AActor, public IInteractInterface
 {
 	GENERATED_BODY()
 	
@@ -19,14 +20,31 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	virtual void OnConstruction(const FTransform & Transform) override;
+	virtual void PreRegisterAllComponents() override;
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
+	// Interact Interface, forwarded to the gear holder
+	virtual void Highlight(class ACobblePaperCharacter* Interactor) override;
+	virtual void Unhighlight(class ACobblePaperCharacter* Interactor) override;
+	virtual void Interact(class ACobblePaperCharacter* Interactor) override;
 
-	bool IsPowered();
+	bool IsPowered() const;
+	class UCobbleGearHolderComponent* GetGearHolder() const { return GearHolder; }
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 protected:
-	UPROPERTY(VisibleDefaultsOnly)
-	class UChildActorComponent* GearHolderActor;
+	// Called on every machine when the gear holder starts or stops turning
+	virtual void OnPowerChanged(bool bPowered) {}
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+protected:
+	UPROPERTY(VisibleAnywhere)
+	class UCobbleGearHolderComponent* GearHolder;
 	UPROPERTY(VisibleDefaultsOnly)
 	class USceneComponent* SceneRoot;
+private:
+	void HandlePowerChanged(bool bPowered);
+private:
+	FDelegateHandle PowerChangedHandle;
 };
@@ -2,99 +2,65 @@
 
 
 #include "GearHolder.h"
+#include "CobbleGearHolderComponent.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleManifestBinding.h"
 
-void AGearHolder::Highlight()
+AGearHolder::AGearHolder()
 {
-	// if the player has a gear
-	if (Player != nullptr) // this if statement has early execution on the left side so we wont dereference a nullptr
-	{
-		if (HasGearInHolder())
-		{
-			if (!Player->IsPlayerHoldingGear())
-			{
-				Player->ShowGearHighlight();
-			}
-		}
-		else if(Player->IsPlayerHoldingGear())
-		{
-			HighlightedSpriteComponent->SetHiddenInGame(false); // display gear input highlight
-		}
-	}
+	COBBLE_LLM_SCOPE(Interactables);
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	NetDormancy = DORM_Initial; // Woken up by FCobbleNet::MarkStateChanged when interacted with
+	GearHolder = CreateDefaultSubobject<UCobbleGearHolderComponent>(TEXT("GearHolder"));
+	SetRootComponent(GearHolder);
 }
 
-void AGearHolder::Unhighlight()
+void AGearHolder::BeginPlay()
 {
-	if (HasGearInHolder())
-	{
-		if (Player != nullptr && !Player->IsPlayerHoldingGear())
-		{
-			Player->HideGearHighlight();
-		}
-	}
-	else
-	{
-		HighlightedSpriteComponent->SetHiddenInGame(true);
-	}
+	Super::BeginPlay();
+	// Actors bound from the level manifest were registered with the rest of their level
+	ACobblePhysicsRegions* PhysicsRegions = !ACobbleManifestBinding::IsBound(this) ? ACobblePhysicsRegions::Get(GetWorld()) : nullptr;
+	if (PhysicsRegions != nullptr)
+		PhysicsRegions->RegisterActor(this);
 }
 
-void AGearHolder::Interact()
+void AGearHolder::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (HasGearInHolder())
-	{
-		if (Player != nullptr)
-		{
-			if (Player->ReceiveGear(GearInHolder))
-			{
-				GearInHolder->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
-				GearInHolder->SetActorLocation(FVector(0, -40000, 0));
-				GearInHolder = nullptr;
-				Player->HideGearHighlight();
-			}	
-		}
-	}
-	else
-	{
-		Player->TakeGear(GearInHolder);
-		if (GearInHolder != nullptr)
-		{
-			GearInHolder->AttachToActor(this, FAttachmentTransformRules::KeepWorldTransform);
-			FTransform GearTransform = HighlightedSpriteComponent->GetComponentTransform();
-			GearTransform.SetScale3D(GearInHolder->GetActorScale3D());
-			GearInHolder->SetActorTransform(GearTransform);
-			HighlightedSpriteComponent->SetHiddenInGame(true);
-			bIsGearTurning = true;
-		}
-	}
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->UnregisterActor(this);
+	Super::EndPlay(EndPlayReason);
 }
 
-void AGearHolder::BeginPlay()
+void AGearHolder::Highlight(ACobblePaperCharacter* Interactor)
 {
-	Super::BeginPlay();
+	GearHolder->Highlight(Interactor);
 }
 
-void AGearHolder::Tick(float DeltaTime)
+void AGearHolder::Unhighlight(ACobblePaperCharacter* Interactor)
 {
-	Super::Tick(DeltaTime);
-	if (GetIsGearTurning())
-	{
-		GearInHolder->AddActorLocalRotation(GearRotation * DeltaTime);
-	}
+	GearHolder->Unhighlight(Interactor);
 }
 
-AGearHolder::AGearHolder()
+void AGearHolder::Interact(ACobblePaperCharacter* Interactor)
 {
+	GearHolder->Interact(Interactor);
+}
 
+bool AGearHolder::GetIsGearTurning() const
+{
+	return GearHolder->GetIsGearTurning();
 }
 
-bool AGearHolder::HasGearInHolder()
+bool AGearHolder::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
 {
-	return GearInHolder != nullptr;
+	return FCobbleNet::IsRelevantToCamera(this, RealViewer, ViewTarget, SrcLocation);
 }
 
-bool AGearHolder::GetIsGearTurning()
+void AGearHolder::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
 {
-	if(GearInHolder == nullptr)
-		return false;
-	return bIsGearTurning;
-	
-}
\ No newline at end of file
+	Super::PreReplication(ChangedPropertyTracker);
+	FCobbleNet::RecordReplicationCheck(this);
+}
@@ -3,39 +3,36 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Interactable.h"
+#include "GameFramework/Actor.h"
+#include "InteractInterface.h"
 #include "GearHolder.generated.h"
 
 /**
- * 
+ * A gear holder on its own, for placing in levels where nothing is powered by it.
+ * Gear activated actors carry a UCobbleGearHolderComponent themselves instead of spawning one of these.
  */
 UCLASS()
-class COBBLE_API AGearHolder : public AInteractable
+class COBBLE_API AGearHolder : public AActor, public IInteractInterface
 {
 	GENERATED_BODY()
-	
 
+public:
+	AGearHolder();	// Sets default values for this actor's properties
 /*
 Interact Interface 
 */
-public:
-	virtual void Highlight() override;
-	virtual void Unhighlight() override;
-	virtual void Interact() override;
-	bool GetIsGearTurning();
-public:
-	UPROPERTY(EditAnywhere)
-	FRotator GearRotation = FRotator(-200,0,0);
-protected:
-	virtual void BeginPlay() override; 	// Called when the game starts or when spawned
+	virtual void Highlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Unhighlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Interact(ACobblePaperCharacter* Interactor) override;
+	bool GetIsGearTurning() const;
+	class UCobbleGearHolderComponent* GetGearHolder() const { return GearHolder; }
 
-public:
-	virtual void Tick(float DeltaTime) override; 	// Called every frame
-	AGearHolder();	// Sets default values for this actor's properties
-private:
-	AActor* GearInHolder = nullptr;
-
-private:
-	bool HasGearInHolder();
-	bool bIsGearTurning = false;
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+protected:
+	UPROPERTY(VisibleAnywhere)
+	class UCobbleGearHolderComponent* GearHolder;
 };
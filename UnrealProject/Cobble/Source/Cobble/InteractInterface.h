@@ -14,7 +14,8 @@ class UInteractInterface : public UInterface
 };
 
 /**
- * 
+ * Interactor is the character doing the highlighting or interacting. Highlight and Unhighlight only run for locally
+ * controlled characters, Interact only runs on the server.
  */
 class COBBLE_API IInteractInterface
 {
@@ -22,7 +23,7 @@ class COBBLE_API IInteractInterface
 		
 	// Add interface functions to this class. This is the class that will be inherited to implement this interface.
 public:
-	virtual void Highlight() = 0;
-	virtual void Unhighlight() = 0;
-	virtual void Interact() = 0;
+	virtual void Highlight(class ACobblePaperCharacter* Interactor) = 0;
+	virtual void Unhighlight(class ACobblePaperCharacter* Interactor) = 0;
+	virtual void Interact(class ACobblePaperCharacter* Interactor) = 0;
 };
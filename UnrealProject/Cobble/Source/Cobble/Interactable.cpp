@@ -2,12 +2,20 @@
 
 
 #include "Interactable.h"
-#include "Kismet/GameplayStatics.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobbleSpriteBatch.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleManifestBinding.h"
+#include "CobbleHeadless.h"
 
 // Sets default values
 AInteractable::AInteractable()
 {
+	COBBLE_LLM_SCOPE(Interactables);
 	PrimaryActorTick.bCanEverTick = true;
+	bReplicates = true;
+	NetDormancy = DORM_Initial; // Woken up by FCobbleNet::MarkStateChanged when interacted with
 	SceneRoot = CreateDefaultSubobject<USceneComponent>(TEXT("Scene Root"));
 	SetRootComponent(SceneRoot);
 	
@@ -24,8 +32,74 @@ AInteractable::AInteractable()
 // Called when the game starts or when spawned
 void AInteractable::BeginPlay()
 {
+	COBBLE_LLM_SCOPE(Interactables);
 	Super::BeginPlay();
-	Player = Cast<ACobblePaperCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
+	SetSpriteBatched(true);
+	// Actors bound from the level manifest were registered with the rest of their level
+	ACobblePhysicsRegions* PhysicsRegions = !ACobbleManifestBinding::IsBound(this) ? ACobblePhysicsRegions::Get(GetWorld()) : nullptr;
+	if (PhysicsRegions != nullptr)
+		PhysicsRegions->RegisterActor(this);
+}
+
+void AInteractable::PreRegisterAllComponents()
+{
+	Super::PreRegisterAllComponents();
+	if (FCobbleHeadless::IsEnabled(this))
+		FCobbleHeadless::SkipComponent(HighlightedSpriteComponent);
+}
+
+void AInteractable::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnbindFromPlayerHeldItem();
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->UnregisterActor(this);
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+		SetSpriteBatched(false);
+	Super::EndPlay(EndPlayReason);
+}
+
+void AInteractable::SetSpriteBatched(bool bBatched)
+{
+	if (bBatched && CanBatchSprite())
+		ACobbleSpriteBatch::Merge(RegularSpriteComponent);
+	else
+		ACobbleSpriteBatch::Split(RegularSpriteComponent);
+}
+
+bool AInteractable::CanBatchSprite() const
+{
+	return IsRootComponentStatic();
+}
+
+void AInteractable::BindToPlayerHeldItem(ACobblePaperCharacter* InPlayer)
+{
+	UnbindFromPlayerHeldItem();
+	HighlightingPlayer = InPlayer;
+	if (HighlightingPlayer != nullptr)
+	{
+		HeldItemChangedHandle = HighlightingPlayer->OnHeldItemChanged().AddUObject(this, &AInteractable::OnPlayerHeldItemChanged);
+	}
+}
+
+void AInteractable::UnbindFromPlayerHeldItem()
+{
+	if (HighlightingPlayer != nullptr && HeldItemChangedHandle.IsValid())
+	{
+		HighlightingPlayer->OnHeldItemChanged().Remove(HeldItemChangedHandle);
+	}
+	HeldItemChangedHandle.Reset();
+	HighlightingPlayer = nullptr;
+}
+
+bool AInteractable::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return FCobbleNet::IsRelevantToCamera(this, RealViewer, ViewTarget, SrcLocation);
+}
+
+void AInteractable::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	FCobbleNet::RecordReplicationCheck(this);
 }
 
 // Called every frame
@@ -34,19 +108,21 @@ void AInteractable::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
-void AInteractable::Highlight()
+void AInteractable::Highlight(ACobblePaperCharacter* Interactor)
 {
+	SetSpriteBatched(false);
 	RegularSpriteComponent->SetHiddenInGame(true);
 	HighlightedSpriteComponent->SetHiddenInGame(false);
 }
 
-void AInteractable::Unhighlight()
+void AInteractable::Unhighlight(ACobblePaperCharacter* Interactor)
 {
 	RegularSpriteComponent->SetHiddenInGame(false);
 	HighlightedSpriteComponent->SetHiddenInGame(true);
+	SetSpriteBatched(true);
 }
 
-void AInteractable::Interact()
+void AInteractable::Interact(ACobblePaperCharacter* Interactor)
 {
 
 }
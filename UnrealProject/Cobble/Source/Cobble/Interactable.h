@@ -18,12 +18,31 @@ class COBBLE_API AInteractable : public AActor, public IInteractInterface
 public:	
 	// Sets default values for this actor's properties
 	AInteractable();
-	virtual void Highlight() override;
-	virtual void Unhighlight() override;
-	virtual void Interact() override;
+	virtual void Highlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Unhighlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Interact(ACobblePaperCharacter* Interactor) override;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	// Draw the regular sprite through the level's sprite batch. Turn it off before moving or rotating the actor.
+	void SetSpriteBatched(bool bBatched);
+	// By default only actors with a static root, which nothing moves. Actors that split their sprite before moving it
+	// themselves override this, and return false while moving so highlighting doesn't merge a sprite about to move again.
+	virtual bool CanBatchSprite() const;
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PreRegisterAllComponents() override;
+
+	/*
+	Listen to the player's held item changes. Bound while highlighted so only the interactable the
+	player is looking at reacts when the held item changes.
+	*/
+	void BindToPlayerHeldItem(ACobblePaperCharacter* InPlayer);
+	void UnbindFromPlayerHeldItem();
+	virtual void OnPlayerHeldItemChanged(int32 SlotIndex, EHeldItemType OldType, EHeldItemType NewType) {}
 
 public:
 	// Called every frame
@@ -34,5 +53,7 @@ protected:
 	UPROPERTY(VisibleAnywhere)
 	class UPaperSpriteComponent* HighlightedSpriteComponent;
 	class USceneComponent* SceneRoot;
-	ACobblePaperCharacter* Player;
+	ACobblePaperCharacter* HighlightingPlayer = nullptr; // Local player this is highlighted for, null when not highlighted
+private:
+	FDelegateHandle HeldItemChangedHandle;
 };
@@ -2,11 +2,20 @@
 
 
 #include "Lever.h"
-#include "Hose.h"
-#include "CableComponent.h"
+#include "CobbleHoseComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/ChildActorComponent.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobbleHitchDetector.h"
+#include "CobbleManifestBinding.h"
+#include "CobbleHeadless.h"
+#include "Net/UnrealNetwork.h"
 
 ALever::ALever()
 {
+	// Most of a lever is its hose, so it is counted with the hoses here and in FCobbleMemory::GetTagForActor
+	COBBLE_LLM_SCOPE(Hoses);
 	LeftPlaceholder = CreateDefaultSubobject<UPaperSpriteComponent>(TEXT("PlaceholderLeft"));
 	LeftPlaceholder->SetupAttachment(GetRootComponent());
 	RightPlaceholder = CreateDefaultSubobject<UPaperSpriteComponent>(TEXT("PlaceholderRight"));
@@ -16,25 +25,62 @@ ALever::ALever()
 	LeftPlaceholder->SetCollisionProfileName("OverlapAll");
 	RightPlaceholder->SetCollisionProfileName("OverlapAll");
 
-	LeftHose = CreateDefaultSubobject<UChildActorComponent>(TEXT("GearHolderChildActor"));
+	Hose = CreateDefaultSubobject<UCobbleHoseComponent>(TEXT("Hose"));
+	Hose->SetupAttachment(SceneRoot);
+	HoseEnd = CreateDefaultSubobject<UBoxComponent>(TEXT("HoseEnd"));
+	HoseEnd->SetupAttachment(Hose);
+	HoseEnd->SetBoxExtent(FVector(80, 80, 80));
+	HoseEnd->SetHiddenInGame(false);
+}
 
-	LeftHose->SetupAttachment(SceneRoot);
-	LeftHose->SetChildActorClass(AHose::StaticClass());
+void ALever::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	Hose->SetEndCollision(HoseEnd);
+}
+
+void ALever::PreRegisterAllComponents()
+{
+	Super::PreRegisterAllComponents();
+	// Levers saved while the hose was a child actor still carry its component, see [CoreRedirects] in DefaultEngine.ini.
+	// It is stripped before it can register and spawn anything, in every world.
+	TInlineComponentArray<UChildActorComponent*> ChildActorComponents(this);
+	for (UChildActorComponent* Leftover : ChildActorComponents)
+	{
+		if (Leftover->GetFName() != TEXT("GearHolderChildActor"))
+			continue;
+		Leftover->bAutoRegister = false;
+		Leftover->DestroyChildActor();
+		Leftover->SetChildActorClass(nullptr);
+		Leftover->DestroyComponent();
+	}
+	// The cable still simulates, the hose end follows it
+	if (FCobbleHeadless::IsEnabled(this))
+	{
+		FCobbleHeadless::HideComponent(Hose);
+		FCobbleHeadless::HideComponent(HoseEnd);
+	}
 }
 
-void ALever::Highlight()
+void ALever::Highlight(ACobblePaperCharacter* Interactor)
 {
-	Super::Highlight();
+	Super::Highlight(Interactor);
 }
 
-void ALever::Unhighlight()
+void ALever::Unhighlight(ACobblePaperCharacter* Interactor)
 {
-	Super::Unhighlight();
+	Super::Unhighlight(Interactor);
 }
 
-void ALever::Interact()
+void ALever::Interact(ACobblePaperCharacter* Interactor)
 {
-	Super::Interact();
+	Super::Interact(Interactor);
+	if (Interactor != nullptr && !Hose->IsHeld() && Hose->IsEndInReach(Interactor) && !RegularSpriteComponent->IsOverlappingActor(Interactor))
+	{
+		Hose->PickUp(Interactor);
+		return;
+	}
+	FCobbleNet::MarkStateChanged(this);
 	if (bIsFlippedToTheLeft)
 	{
 		bIsFlippedToTheLeft = false;
@@ -43,52 +89,71 @@ void ALever::Interact()
 	{
 		bIsFlippedToTheLeft = true;
 	}
+	FCobbleHitchDetector::RecordEvent(ECobbleEvent::LeverFlipped, this, bIsFlippedToTheLeft ? 1 : 0);
 	RotateToMatchFlippedDirection();
 }
 
+void ALever::Drop()
+{
+	Hose->Drop();
+}
+
 void ALever::BeginPlay()
 {
-	AHose* Hose = Cast<AHose>(LeftHose->GetChildActor());
-	if (Hose != nullptr)
-	{
-		Hose->Cable->bAttachEnd = false;
-		Hose->Cable->EndLocation = FVector::ZeroVector;
-	}
+	Super::BeginPlay();
+	if (!ACobbleManifestBinding::IsBound(this))
+		SetUpHoseForPlay(GetHoseGravityScale(bIsFlippedToTheLeft));
+}
+
+void ALever::SetUpHoseForPlay(float GravityScale)
+{
+	Hose->bAttachEnd = false;
+	Hose->EndLocation = FVector::ZeroVector;
+	Hose->CableGravityScale = GravityScale;
 }
 
 void ALever::OnConstruction(const FTransform & Transform)
 {
-	AHose* Hose = Cast<AHose>(LeftHose->GetChildActor());
-	if (Hose != nullptr)
-	{
-		//Hose->SetActorLocation(GetActorLocation() + FVector(0, 0, 10));
-		Hose->Cable->EndLocation = GetActorForwardVector()* -Hose->CableStartOffset;
-		Hose->Cable->bAttachEnd = true;
-		//Hose->Cable->EndLocation += FVector(0, 0, 40);
-	}
+	Hose->EndLocation = GetActorForwardVector()* -Hose->CableStartOffset;
+	Hose->bAttachEnd = true;
 	RotateToMatchFlippedDirection();
 }
 
 void ALever::RotateToMatchFlippedDirection()
 {
+	SetSpriteBatched(false);
 	if (bIsFlippedToTheLeft)
 	{
 		HighlightedSpriteComponent->SetRelativeTransform(LeftPlaceholder->GetRelativeTransform());
 		RegularSpriteComponent->SetRelativeTransform(LeftPlaceholder->GetRelativeTransform());
-		AHose* Hose = Cast<AHose>(LeftHose->GetChildActor());
-		if (Hose != nullptr)
-		{
-			Hose->Cable->CableGravityScale = -1;
-		}
+		SetHoseGravityScale(GetHoseGravityScale(true));
 	}
 	else
 	{
-		AHose* Hose = Cast<AHose>(LeftHose->GetChildActor());
-		if (Hose != nullptr)
-		{
-			Hose->Cable->CableGravityScale = 1;
-		}
+		SetHoseGravityScale(GetHoseGravityScale(false));
 		HighlightedSpriteComponent->SetRelativeTransform(RightPlaceholder->GetRelativeTransform());
 		RegularSpriteComponent->SetRelativeTransform(RightPlaceholder->GetRelativeTransform());
 	}
+	if (HighlightingPlayer == nullptr)
+		SetSpriteBatched(true);
+}
+
+void ALever::SetHoseGravityScale(float GravityScale)
+{
+	if (Hose->CableGravityScale != GravityScale)
+	{
+		Hose->CableGravityScale = GravityScale;
+		FCobbleHitchDetector::RecordEvent(ECobbleEvent::CableGravityChanged, this, GravityScale);
+	}
+}
+
+void ALever::OnRep_IsFlippedToTheLeft()
+{
+	RotateToMatchFlippedDirection();
+}
+
+void ALever::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(ALever, bIsFlippedToTheLeft);
 }
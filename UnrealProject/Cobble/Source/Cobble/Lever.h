@@ -4,27 +4,38 @@
 
 #include "CoreMinimal.h"
 #include "Interactable.h"
+#include "PickupInterface.h"
 #include "Lever.generated.h"
 
 /**
- * 
+ * Flipping the lever swings its hose to the other side. Players near the loose end of the hose pick it up instead.
  */
 UCLASS()
-class COBBLE_API ALever : public AInteractable
+class COBBLE_API ALever : public AInteractable, public IPickupInterface
 {
 	GENERATED_BODY()
 public:
-	UPROPERTY(EditAnywhere)
+	UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_IsFlippedToTheLeft)
 		bool bIsFlippedToTheLeft = false;
 public:
 	// Sets default values for this actor's properties
 	ALever();
 	//Interactable interface
-	virtual void Highlight() override;
-	virtual void Unhighlight() override;
-	virtual void Interact() override;
+	virtual void Highlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Unhighlight(ACobblePaperCharacter* Interactor) override;
+	virtual void Interact(ACobblePaperCharacter* Interactor) override;
+	// Pickup Interface, the character holds the lever while carrying its hose
+	virtual void Drop() override;
+	// The lever never moves, flipping it only turns the sprite, which is split first
+	virtual bool CanBatchSprite() const override { return true; }
 	
 	virtual void BeginPlay() override;
+	virtual void PostInitializeComponents() override;
+	virtual void PreRegisterAllComponents() override;
+	class UCobbleHoseComponent* GetHose() const { return Hose; }
+	// Loosens the hose end the editor pins for placing it. Called by BeginPlay, or before it by ACobbleManifestBinding.
+	void SetUpHoseForPlay(float GravityScale);
+	static float GetHoseGravityScale(bool bFlippedToTheLeft) { return bFlippedToTheLeft ? -1 : 1; }
 protected:
 	virtual void OnConstruction(const FTransform& Transform) override;
 	
@@ -34,9 +45,14 @@ protected:
 	class UPaperSpriteComponent* LeftPlaceholder;
 	UPROPERTY(VisibleAnywhere)
 	class UPaperSpriteComponent* RightPlaceholder;
+	UPROPERTY(VisibleAnywhere)
+	class UCobbleHoseComponent* Hose;
+	// Follows the loose end of the hose so players can reach it
+	UPROPERTY(VisibleAnywhere)
+	class UBoxComponent* HoseEnd;
 private:
 	void RotateToMatchFlippedDirection();
-private:
-	UPROPERTY(VisibleDefaultsOnly)
-		class UChildActorComponent* LeftHose;
+	void SetHoseGravityScale(float GravityScale);
+	UFUNCTION()
+	void OnRep_IsFlippedToTheLeft();
 };
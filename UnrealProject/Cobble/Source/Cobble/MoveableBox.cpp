@@ -2,43 +2,237 @@
 
 
 #include "MoveableBox.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/WorldSettings.h"
+#include "Engine/World.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobbleHitchDetector.h"
+#include "CobblePhysicsRegions.h"
+#include "CobbleTelemetry.h"
+#include "Net/UnrealNetwork.h"
+
+namespace
+{
+	// Sweeps use a slightly smaller box so a box resting on the floor or against a wall doesn't start out blocked
+	const float SweepSkin = 1.0f;
+}
 
 // Sets default values
 AMoveableBox::AMoveableBox()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	COBBLE_LLM_SCOPE(Interactables);
 	PrimaryActorTick.bCanEverTick = true;
-	interactable = false;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
+	BlockingVolume = CreateDefaultSubobject<UBoxComponent>(TEXT("Blocking Volume"));
+	BlockingVolume->SetupAttachment(SceneRoot);
+	BlockingVolume->SetBoxExtent(FVector(50, 50, 50));
+	BlockingVolume->SetCollisionProfileName("BlockAllDynamic");
+	BlockingVolume->SetGenerateOverlapEvents(false);
 }
 
 // Called when the game starts or when spawned
 void AMoveableBox::BeginPlay()
 {
 	Super::BeginPlay();
-	
+	SpriteRelativeLocation = RegularSpriteComponent->GetRelativeTransform().GetLocation();
+	if (HasAuthority())
+		RestLocation = GetActorLocation();
+}
+
+void AMoveableBox::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (GrabbingCharacter != nullptr)
+		SetCharacterGrabbing(GrabbingCharacter, false);
+	FixedStepBinding.Unbind(GetWorld());
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void AMoveableBox::Tick(float DeltaTime)
 {
+	COBBLE_LLM_SCOPE(Interactables);
+	COBBLE_TELEMETRY_SCOPE(Interactables);
 	Super::Tick(DeltaTime);
+	if (GrabbingCharacter != nullptr)
+		MoveWithCharacter();
+	else if (!FixedStepBinding.IsBound())
+		Fall(DeltaTime);
+}
+
+void AMoveableBox::Interact(ACobblePaperCharacter* Interactor)
+{
+	if (Interactor != nullptr && GrabbingCharacter == nullptr && Interactor->PickUpItem(this))
+	{
+		FCobbleNet::MarkStateChanged(this);
+		GrabbingCharacter = Interactor;
+		OnRep_GrabbingCharacter(nullptr);
+	}
+}
+
+void AMoveableBox::Drop()
+{
+	ACobblePaperCharacter* OldCharacter = GrabbingCharacter;
+	FCobbleNet::MarkStateChanged(this);
+	GrabbingCharacter = nullptr;
+	OnRep_GrabbingCharacter(OldCharacter);
+}
+
+bool AMoveableBox::CanBatchSprite() const
+{
+	return !IsActorTickEnabled();
+}
+
+void AMoveableBox::OnRep_GrabbingCharacter(ACobblePaperCharacter* OldCharacter)
+{
+	if (OldCharacter != nullptr)
+		SetCharacterGrabbing(OldCharacter, false);
+	if (GrabbingCharacter != nullptr)
+	{
+		SetCharacterGrabbing(GrabbingCharacter, true);
+		GrabOffset = FVector::DotProduct(GetActorLocation() - GrabbingCharacter->GetActorLocation(), GrabbingCharacter->GetActorForwardVector());
+		FCobbleHitchDetector::RecordEvent(ECobbleEvent::BoxGrabbed, this);
+	}
+	FallSpeed = 0;
+	StartMoving(); // A released box falls until it lands, which is usually straight away
+	// A grabbed box follows the character every frame, so only falling is stepped
+	SetFixedStepping(GrabbingCharacter == nullptr && ACobbleFixedStep::IsEnabled());
+}
+
+void AMoveableBox::OnRep_RestLocation()
+{
+	if (GrabbingCharacter != nullptr)
+		return;
+	SetActorLocation(RestLocation);
+	if (IsActorTickEnabled())
+		Settle();
+}
+
+void AMoveableBox::SetCharacterGrabbing(ACobblePaperCharacter* Character, bool bGrabbing)
+{
+	// The character walks into the box while pushing it, the box keeps the two apart instead
+	Character->GetCapsuleComponent()->IgnoreActorWhenMoving(this, bGrabbing);
+	UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	if (bGrabbing)
+	{
+		CharacterWalkSpeed = Movement->MaxWalkSpeed;
+		Movement->MaxWalkSpeed = FMath::Min(Movement->MaxWalkSpeed, GrabbedWalkSpeed);
+	}
+	else if (CharacterWalkSpeed > 0)
+	{
+		Movement->MaxWalkSpeed = CharacterWalkSpeed;
+	}
+}
 
+void AMoveableBox::StartMoving()
+{
+	SetActorTickEnabled(true);
+	SetSpriteBatched(false);
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->SetActorAwake(this, true);
 }
 
-void AMoveableBox::Highlight()
+void AMoveableBox::Settle()
 {
+	SetFixedStepping(false);
+	SetActorTickEnabled(false);
+	FallSpeed = 0;
+	SetSpriteBatched(true);
+	if (ACobblePhysicsRegions* PhysicsRegions = ACobblePhysicsRegions::Get(GetWorld(), false))
+		PhysicsRegions->SetActorAwake(this, false);
+	if (HasAuthority())
+	{
+		FCobbleNet::MarkStateChanged(this);
+		RestLocation = GetActorLocation();
+	}
+	FCobbleHitchDetector::RecordEvent(ECobbleEvent::BoxSettled, this);
 }
 
-void AMoveableBox::Unhighlight()
+void AMoveableBox::SetFixedStepping(bool bStepping)
 {
+	if (bStepping == FixedStepBinding.IsBound())
+		return;
+	if (bStepping)
+	{
+		StepLocation.Reset(GetActorLocation());
+		FixedStepBinding.Bind(GetWorld(), this, &AMoveableBox::FixedStep, &AMoveableBox::InterpolateFixedStep);
+	}
+	else
+	{
+		FixedStepBinding.Unbind(GetWorld());
+		RegularSpriteComponent->SetRelativeLocation(SpriteRelativeLocation);
+	}
 }
 
-void AMoveableBox::Interact()
+void AMoveableBox::FixedStep(float StepSeconds)
 {
-	if (Player != nullptr)
+	COBBLE_TELEMETRY_SCOPE(Interactables);
+	Fall(StepSeconds);
+	StepLocation.Push(GetActorLocation());
+}
+
+void AMoveableBox::InterpolateFixedStep(float Alpha)
+{
+	// The box itself stays at the simulated location for collision, the sprite is drawn where it was in between
+	const FVector Offset = GetActorTransform().InverseTransformVector(StepLocation.Get(Alpha) - StepLocation.Current);
+	RegularSpriteComponent->SetRelativeLocation(SpriteRelativeLocation + Offset);
+}
+
+void AMoveableBox::MoveWithCharacter()
+{
+	const FVector Axis = GrabbingCharacter->GetActorForwardVector();
+	const float Along = FVector::DotProduct(GetActorLocation() - GrabbingCharacter->GetActorLocation(), Axis);
+	FHitResult Hit;
+	if (!FMath::IsNearlyEqual(Along, GrabOffset) && SweepBy(Axis * (GrabOffset - Along), Hit))
 	{
-		interactable = true;
+		// Blocked, so hold the character back at the grab distance instead
+		const float Blocked = FVector::DotProduct(GetActorLocation() - GrabbingCharacter->GetActorLocation(), Axis);
+		GrabbingCharacter->AddActorWorldOffset(Axis * (Blocked - GrabOffset));
 	}
+
+	// Follow the floor down small steps, let go when it drops away
+	if (!SweepBy(FVector(0, 0, -MaxStepDown), Hit) && HasAuthority())
+	{
+		GrabbingCharacter->ReleaseHeldItem(EHeldItemType::Box);
+		Drop();
+	}
+}
+
+void AMoveableBox::Fall(float DeltaTime)
+{
+	FallSpeed -= GetWorld()->GetGravityZ() * DeltaTime;
+	FHitResult Hit;
+	const bool bLanded = SweepBy(FVector(0, 0, -FallSpeed * DeltaTime), Hit);
+	if (bLanded || GetActorLocation().Z < GetWorldSettings()->KillZ)
+		Settle();
 }
 
+bool AMoveableBox::SweepBy(const FVector& Delta, FHitResult& OutHit)
+{
+	const float Distance = Delta.Size();
+	if (Distance <= KINDA_SMALL_NUMBER)
+		return false;
+	const FVector Start = BlockingVolume->GetComponentLocation();
+	const FVector Extent = BlockingVolume->GetScaledBoxExtent() - FVector(SweepSkin);
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(MoveableBoxSweep), false, this);
+	Params.AddIgnoredActor(GrabbingCharacter);
+	FCollisionResponseParams ResponseParams(BlockingVolume->GetCollisionResponseToChannels());
+
+	const bool bHit = GetWorld()->SweepSingleByChannel(OutHit, Start, Start + Delta, BlockingVolume->GetComponentQuat(),
+		BlockingVolume->GetCollisionObjectType(), FCollisionShape::MakeBox(Extent.ComponentMax(FVector(SweepSkin))), Params, ResponseParams);
+	// Stop a skin short of what was hit so the full size box ends up touching it
+	const float Moved = bHit ? FMath::Max(OutHit.Distance - SweepSkin, 0.0f) : Distance;
+	if (Moved > 0)
+		AddActorWorldOffset(Delta * (Moved / Distance));
+	return bHit;
+}
+
+void AMoveableBox::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AMoveableBox, GrabbingCharacter);
+	DOREPLIFETIME(AMoveableBox, RestLocation);
+}
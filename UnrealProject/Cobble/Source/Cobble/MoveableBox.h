@@ -4,27 +4,73 @@
 
 #include "CoreMinimal.h"
 #include "Cobble/Interactable.h"
+#include "PickupInterface.h"
+#include "Engine/NetSerialization.h"
+#include "CobbleFixedStep.h"
 #include "MoveableBox.generated.h"
 
+/*
+A box the player grabs to push or pull along the side scrolling axis.
+Movement is kinematic: while grabbed the box follows the character with collision sweeps, once released it falls with
+sweeps until it lands and then stops ticking. There is no rigid body, so boxes nobody is touching cost nothing.
+Every machine runs the same movement from the replicated grabbing character, the server sends where the box came to rest.
+With fixed step gameplay on, falling runs at the fixed rate and only the sprite is drawn between steps.
+*/
 UCLASS()
-class COBBLE_API AMoveableBox : public AInteractable
+class COBBLE_API AMoveableBox : public AInteractable, public IPickupInterface
 {
 	GENERATED_BODY()
-	
-public:	
+
+public:
 	// Sets default values for this actor's properties
 	AMoveableBox();
-	virtual void Highlight() override;
-	virtual void Unhighlight() override;
-	virtual void Interact() override;
+	virtual void Interact(ACobblePaperCharacter* Interactor) override;
+	// Pickup Interface
+	virtual void Drop() override;
+	virtual bool CanBatchSprite() const override;
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-public:	
-	// Called every frame
+public:
+	// Only ticks while the box is grabbed or falling
 	virtual void Tick(float DeltaTime) override;
-protected:
-	// Variables for box
-	bool interactable;
+
+public:
+	UPROPERTY(VisibleAnywhere)
+	class UBoxComponent* BlockingVolume;
+	// Walk speed of the character while it pushes or pulls the box
+	UPROPERTY(EditAnywhere, Category = "Push Pull")
+	float GrabbedWalkSpeed = 200;
+	// How far the floor may drop away under a grabbed box before it slips out of the character's hands
+	UPROPERTY(EditAnywhere, Category = "Push Pull")
+	float MaxStepDown = 20;
+private:
+	void MoveWithCharacter();
+	void Fall(float DeltaTime);
+	// Sweeps the blocking volume by Delta and moves the box as far as it got. Returns true if something was hit.
+	bool SweepBy(const FVector& Delta, FHitResult& OutHit);
+	void StartMoving();
+	void Settle();
+	void SetFixedStepping(bool bStepping);
+	void FixedStep(float StepSeconds);
+	void InterpolateFixedStep(float Alpha);
+	void SetCharacterGrabbing(ACobblePaperCharacter* Character, bool bGrabbing);
+	UFUNCTION()
+	void OnRep_GrabbingCharacter(ACobblePaperCharacter* OldCharacter);
+	UFUNCTION()
+	void OnRep_RestLocation();
+private:
+	UPROPERTY(ReplicatedUsing = OnRep_GrabbingCharacter)
+	ACobblePaperCharacter* GrabbingCharacter = nullptr;
+	// Where the box last came to rest on the server
+	UPROPERTY(ReplicatedUsing = OnRep_RestLocation)
+	FVector_NetQuantize RestLocation;
+	float GrabOffset = 0; // Distance from the grabbing character to the box along the scroll axis
+	float FallSpeed = 0;
+	float CharacterWalkSpeed = 0; // Walk speed of the grabbing character before it grabbed the box
+	FCobbleFixedStepBinding FixedStepBinding;
+	FCobbleStepLocation StepLocation;
+	FVector SpriteRelativeLocation = FVector::ZeroVector;
 };
@@ -4,23 +4,55 @@
 #include "MovingPlatform.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/SplineComponent.h"
+#include "CobbleNetworking.h"
+#include "CobbleMemory.h"
+#include "CobbleHitchDetector.h"
+#include "CobbleMachineAudio.h"
+#include "CobbleTelemetry.h"
+#include "Net/UnrealNetwork.h"
+#include "GameFramework/GameStateBase.h"
+#include "Engine/World.h"
 AMovingPlatform::AMovingPlatform()
 {
+	COBBLE_LLM_SCOPE(Platforms);
 	PlatformMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Platform Object"));
 	PlatformMesh->SetupAttachment(GetRootComponent());
+	PlatformMesh->SetGenerateOverlapEvents(false); // Standing on the platform shouldn't highlight its gear holder
 
 	MovingPlatformPath = CreateDefaultSubobject<USplineComponent>(TEXT("SplineForThePlatform"));
 	MovingPlatformPath->SetupAttachment(GetRootComponent());
-	GearHolderActor->SetupAttachment(PlatformMesh);
+	GearHolder->SetupAttachment(PlatformMesh);
 }
 
 void AMovingPlatform::BeginPlay()
 {
 	Super::BeginPlay();
+	UpdateTicking();
+	ACobbleMachineAudio* MachineAudio = MovingLoopEvent != nullptr ? ACobbleMachineAudio::Get(GetWorld()) : nullptr;
+	if (MachineAudio != nullptr)
+	{
+		MachineSoundId = MachineAudio->RegisterSource(PlatformMesh, MovingLoopEvent, MovingLoopLoudness);
+		MachineAudio->SetSourceActive(MachineSoundId, PowerState.bPowered);
+	}
+}
+
+void AMovingPlatform::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(GetWorld(), false))
+		MachineAudio->UnregisterSource(MachineSoundId);
+	MachineSoundId = INDEX_NONE;
+	FixedStepBinding.Unbind(GetWorld());
+	if (bCountedAsMoving)
+	{
+		bCountedAsMoving = false;
+		FCobbleTelemetry::AddToGauge(ECobbleGauge::PlatformsMoving, -1);
+	}
+	Super::EndPlay(EndPlayReason);
 }
 
 void AMovingPlatform::OnConstruction(const FTransform & Transform)
 {
+	COBBLE_LLM_SCOPE(Platforms);
 	Super::OnConstruction(Transform);
 	if (bIsStraightPath)
 	{
@@ -38,43 +70,155 @@ void AMovingPlatform::OnConstruction(const FTransform & Transform)
 	}
 }
 
+void AMovingPlatform::OnPowerChanged(bool bPowered)
+{
+	// The server decides when the power changed so every machine agrees on the time stamp
+	if (!HasAuthority() || bPowered == PowerState.bPowered)
+		return;
+	FCobbleNet::MarkStateChanged(this);
+	PowerState.CyclePhase = GetCurrentCyclePhase();
+	PowerState.ServerTimeStamp = GetServerWorldTime();
+	PowerState.bPowered = bPowered;
+	OnRep_PowerState();
+}
+
+void AMovingPlatform::OnRep_PowerState()
+{
+	FCobbleHitchDetector::RecordEvent(ECobbleEvent::PlatformPowerChanged, this, PowerState.bPowered ? 1 : 0);
+	UpdateTicking();
+	if (ACobbleMachineAudio* MachineAudio = ACobbleMachineAudio::Get(GetWorld(), false))
+		MachineAudio->SetSourceActive(MachineSoundId, PowerState.bPowered);
+	UpdatePlatformLocation();
+}
+
+void AMovingPlatform::UpdateTicking()
+{
+	// Only moves while powered, every frame or at the fixed step rate
+	const bool bFixedStep = PowerState.bPowered && HasActorBegunPlay() && ACobbleFixedStep::IsEnabled();
+	SetActorTickEnabled(PowerState.bPowered && !bFixedStep);
+	if (!bFixedStep)
+	{
+		FixedStepBinding.Unbind(GetWorld());
+	}
+	else if (!FixedStepBinding.IsBound())
+	{
+		StepLocation.Reset(PlatformMesh->GetComponentLocation());
+		FixedStepBinding.Bind(GetWorld(), this, &AMovingPlatform::FixedStep, &AMovingPlatform::InterpolateFixedStep);
+	}
+	const bool bMoving = PowerState.bPowered && HasActorBegunPlay();
+	if (bMoving != bCountedAsMoving)
+	{
+		bCountedAsMoving = bMoving;
+		FCobbleTelemetry::AddToGauge(ECobbleGauge::PlatformsMoving, bMoving ? 1 : -1);
+	}
+}
+
+void AMovingPlatform::FixedStep(float StepSeconds)
+{
+	COBBLE_TELEMETRY_SCOPE(Platforms);
+	const ACobbleFixedStep* Stepper = ACobbleFixedStep::Get(GetWorld(), false);
+	UpdatePlatformLocation(Stepper != nullptr ? Stepper->GetStepTimeBehind() : 0);
+}
+
+void AMovingPlatform::InterpolateFixedStep(float Alpha)
+{
+	PlatformMesh->SetWorldLocation(StepLocation.Get(Alpha));
+}
+
 void AMovingPlatform::Tick(float DeltaTime)
 {
+	COBBLE_TELEMETRY_SCOPE(Platforms);
 	Super::Tick(DeltaTime);
-	if (IsPowered())
+	if (PowerState.bPowered)
 	{
-		if (TimeWaited <= 0)
-		{
-			if (!bReverse)
-			{
-				if (AmountOfSplineTraversed < MovingPlatformPath->GetSplineLength() && Direction)
-				{
-					AmountOfSplineTraversed += MovementSpeed * DeltaTime * Direction;
-					PlatformMesh->SetWorldLocation(MovingPlatformPath->GetLocationAtDistanceAlongSpline(AmountOfSplineTraversed, ESplineCoordinateSpace::World));
-				}
-				else
-				{
-					bReverse = true;
-					TimeWaited = TimeToWaitAtEndPoint;
-				}
-			}
-			else
-			{
-				if (AmountOfSplineTraversed > 0)
-				{
-					AmountOfSplineTraversed += MovementSpeed * DeltaTime * -1;
-					PlatformMesh->SetWorldLocation(MovingPlatformPath->GetLocationAtDistanceAlongSpline(AmountOfSplineTraversed, ESplineCoordinateSpace::World));
-				}
-				else
-				{
-					bReverse = false;
-					TimeWaited = TimeToWaitAtEndPoint;
-				}
-			}
-		}
-		else
-		{
-			TimeWaited -= DeltaTime;
-		}
+		UpdatePlatformLocation();
+	}
+}
+
+void AMovingPlatform::UpdatePlatformLocation(float TimeBehind)
+{
+	const float NewDistance = GetDistanceAtCyclePhase(GetCurrentCyclePhase() - (PowerState.bPowered ? TimeBehind : 0));
+	const int8 TravelDirection = (int8)FMath::Sign(NewDistance - AmountOfSplineTraversed);
+	if (TravelDirection != 0)
+	{
+		if (TravelDirection != LastTravelDirection && LastTravelDirection != 0)
+			FCobbleHitchDetector::RecordEvent(ECobbleEvent::PlatformReversed, this, NewDistance);
+		LastTravelDirection = TravelDirection;
 	}
-}
\ No newline at end of file
+	AmountOfSplineTraversed = NewDistance;
+	const FVector Location = GetPathLocation(AmountOfSplineTraversed);
+	if (FixedStepBinding.IsBound())
+		StepLocation.Push(Location);
+	else
+		PlatformMesh->SetWorldLocation(Location);
+}
+
+float AMovingPlatform::GetCurrentCyclePhase() const
+{
+	if (!PowerState.bPowered)
+		return PowerState.CyclePhase;
+	return PowerState.CyclePhase + (GetServerWorldTime() - PowerState.ServerTimeStamp);
+}
+
+float AMovingPlatform::GetDistanceAtCyclePhase(float CyclePhase) const
+{
+	const float SplineLength = GetPathLength();
+	if (SplineLength <= 0 || MovementSpeed <= 0)
+		return 0;
+	const float TravelTime = SplineLength / MovementSpeed;
+	const float WaitTime = FMath::Max(TimeToWaitAtEndPoint, 0.f);
+	const float CycleTime = 2 * (TravelTime + WaitTime);
+
+	float Time = FMath::Fmod(CyclePhase, CycleTime);
+	if (Time < 0)
+		Time += CycleTime;
+
+	if (Time < TravelTime)
+		return Time * MovementSpeed; // Going out
+	Time -= TravelTime;
+	if (Time < WaitTime)
+		return SplineLength; // Waiting at the end
+	Time -= WaitTime;
+	if (Time < TravelTime)
+		return SplineLength - Time * MovementSpeed; // Coming back
+	return 0; // Waiting at the start
+}
+
+void AMovingPlatform::SetBakedPath(const TArray<FVector>& Points, float Spacing, float Length)
+{
+	if (Points.Num() < 2 || Spacing <= 0)
+		return;
+	BakedPath = Points;
+	BakedPathSpacing = Spacing;
+	BakedPathLength = Length;
+}
+
+FVector AMovingPlatform::GetPathLocation(float Distance) const
+{
+	if (BakedPath.Num() < 2)
+		return MovingPlatformPath->GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+	const int32 Last = BakedPath.Num() - 1;
+	const int32 Segment = FMath::Clamp(FMath::FloorToInt(Distance / BakedPathSpacing), 0, Last - 1);
+	const float SegmentStart = Segment * BakedPathSpacing;
+	// The last segment ends at the end of the path, so it is usually shorter
+	const float SegmentLength = Segment == Last - 1 ? BakedPathLength - SegmentStart : BakedPathSpacing;
+	const float Alpha = SegmentLength > 0 ? FMath::Clamp((Distance - SegmentStart) / SegmentLength, 0.f, 1.f) : 0;
+	return FMath::Lerp(BakedPath[Segment], BakedPath[Segment + 1], Alpha);
+}
+
+float AMovingPlatform::GetPathLength() const
+{
+	return BakedPath.Num() >= 2 ? BakedPathLength : MovingPlatformPath->GetSplineLength();
+}
+
+float AMovingPlatform::GetServerWorldTime() const
+{
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+void AMovingPlatform::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AMovingPlatform, PowerState);
+}
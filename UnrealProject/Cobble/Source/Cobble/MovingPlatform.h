@@ -4,10 +4,31 @@
 
 #include "CoreMinimal.h"
 #include "GearActivatedActor.h"
+#include "CobbleFixedStep.h"
 #include "MovingPlatform.generated.h"
 
+/*
+Everything needed to work out where a platform is. Only changes when the platform is powered on or off.
+*/
+USTRUCT()
+struct FPlatformPowerState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	bool bPowered = false;
+	// Server world time the power last changed
+	UPROPERTY()
+	float ServerTimeStamp = 0;
+	// Seconds into the back and forth cycle the platform was at when the power last changed
+	UPROPERTY()
+	float CyclePhase = 0;
+};
+
 /**
- * 
+ * Platform position is a closed form function of synchronized world time, so every machine computes the same position
+ * without replicating movement and long frames can't overshoot the ends of the spline.
+ * With fixed step gameplay on, the position is worked out at the fixed rate and the mesh is drawn between steps.
  */
 UCLASS()
 class COBBLE_API AMovingPlatform : public AGearActivatedActor
@@ -21,29 +42,60 @@ public:
 	float TimeToWaitAtEndPoint = 3;
 	UPROPERTY(EditAnywhere)
 	bool bIsStraightPath = false;
+	// Loops while the platform is powered, played through ACobbleMachineAudio
+	UPROPERTY(EditAnywhere, Category = Audio)
+	class UAkAudioEvent* MovingLoopEvent = nullptr;
+	UPROPERTY(EditAnywhere, Category = Audio)
+	float MovingLoopLoudness = 1;
 	// Sets default values for this actor's properties
 	AMovingPlatform();
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	void OnConstruction(const FTransform& Transform) override;
+	virtual void OnPowerChanged(bool bPowered) override;
 public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
+
+	// Distance along the spline at a point in the travel, wait, travel back, wait cycle
+	float GetDistanceAtCyclePhase(float CyclePhase) const;
+	float GetCurrentCyclePhase() const;
+	const class USplineComponent* GetPath() const { return MovingPlatformPath; }
+	// Points every Spacing along the path from the level manifest, followed instead of evaluating the spline
+	void SetBakedPath(const TArray<FVector>& Points, float Spacing, float Length);
 private:
 	UPROPERTY(VisibleAnywhere)
 	class UStaticMeshComponent* PlatformMesh;
 	UPROPERTY(VisibleAnywhere)
 	class USplineComponent* MovingPlatformPath;
 
+	UFUNCTION()
+	void OnRep_PowerState();
+	// TimeBehind moves the platform to where it was that many seconds ago
+	void UpdatePlatformLocation(float TimeBehind = 0);
+	FVector GetPathLocation(float Distance) const;
+	float GetPathLength() const;
+	void UpdateTicking();
+	void FixedStep(float StepSeconds);
+	void InterpolateFixedStep(float Alpha);
+	float GetServerWorldTime() const;
+
 /*Spline variables*/
 protected:
 	float AmountOfSplineTraversed = 0;
-	int CurrentPoint = 0;
-	
-	float Direction = 1;
-	bool bReverse = false;
-	bool bIsWaiting = false;
-	float TimeWaited = 0;
+	// Which way the platform last moved along the spline, only used to spot reversals for the hitch detector
+	int8 LastTravelDirection = 0;
+	int32 MachineSoundId = INDEX_NONE;
+	// Whether the platform is in the telemetry's PlatformsMoving gauge
+	bool bCountedAsMoving = false;
+	FCobbleFixedStepBinding FixedStepBinding;
+	FCobbleStepLocation StepLocation;
+	TArray<FVector> BakedPath;
+	float BakedPathSpacing = 0;
+	float BakedPathLength = 0;
+	UPROPERTY(ReplicatedUsing = OnRep_PowerState)
+	FPlatformPowerState PowerState;
 };